@@ -88,13 +88,19 @@ class Analysis
                              llvm::BasicBlock *,
                              Element,
                              ReversePostOrder,
-                             llvm::SmallVector<llvm::BasicBlock *, 2>> {
+                             llvm::SmallVector<llvm::BasicBlock *, 2>,
+                             DefaultInterrupt<Element>,
+                             false,
+                             true> {
 private:
   using Base = MonotoneFramework<Analysis,
                                  llvm::BasicBlock *,
                                  Element,
                                  ReversePostOrder,
-                                 llvm::SmallVector<llvm::BasicBlock *, 2>>;
+                                 llvm::SmallVector<llvm::BasicBlock *, 2>,
+                                 DefaultInterrupt<Element>,
+                                 false,
+                                 true>;
 
 private:
   llvm::BasicBlock *Entry;
@@ -142,11 +148,11 @@ public:
 
   DefaultInterrupt<Element> transfer(llvm::BasicBlock *BB) {
     if (TargetEdges.count({ BB, nullptr }) != 0) {
-      Element Result = *compute(State[BB], BB, nullptr, true);
+      Element Result = *compute(*getState(BB), BB, nullptr, true);
       return DefaultInterrupt<Element>::createInterrupt(Result);
     }
 
-    return DefaultInterrupt<Element>::createInterrupt(State[BB]);
+    return DefaultInterrupt<Element>::createInterrupt(*getState(BB));
   }
 
   llvm::Optional<Element> handleEdge(const Element &Original,
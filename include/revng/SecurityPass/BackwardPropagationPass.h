@@ -31,15 +31,22 @@ STATISTIC(InputFunctions, "Number of input functions (or input propagator functi
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/IR/ValueSymbolTable.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 // Standard Libraries
 #include <queue>
+#include <set>
 #include <ostream>
 #include <vector>
 
 // LOCAL LIBERARIES
 #include "CommonDefinitions.h"
+#include "DefUseClosure.h"
+#include "DefUseReachability.h"
 #include "MaxStepsPass.h"
+#include "ReverseCallGraph.h"
 // #include "FunctionScraper.h"
 
 
@@ -72,7 +79,7 @@ namespace revng {
 		bool isaRevngVar(const Value*);
 		const Function *scrapedFun = nullptr;
 		RevngFunction res;
-		Regex revngFunctionRegex = { "bb..*" };
+		FunctionArena<VirtualStackParam> stackParams; // owns res.functionVirtStackParams
 	};
 
 	struct FunctionScraper  {
@@ -86,9 +93,9 @@ namespace revng {
 		bool isaRiskyStore(const DefUse &DU) const;
 		void printOperandsRange(raw_ostream &OS, const Instruction *UR) const;
 		void printValueRange(raw_ostream &OS, Value *V,const  BasicBlock* context) const;
-		const std::vector<RiskyStore> getRiskyStores() const { return this->currentRiskyStores; }
-		const std::vector<VariableFlow> getVarsFlows() const { return this->currentVarsFlows; }
-		const std::vector<StackVarFlow> getStackVarsFlows() const { return this->currentStackVarsFlows; }
+		const std::vector<RiskyStore> &getRiskyStores() const { return this->currentRiskyStores; }
+		const std::vector<VariableFlow> &getVarsFlows() const { return this->currentVarsFlows; }
+		const std::vector<StackVarFlow> &getStackVarsFlows() const { return this->currentStackVarsFlows; }
 		bool isaUserOfParams(const User *U) const;
 		// Public attribtues
 		const Function* getFunction() const { return this->currentF; };
@@ -104,15 +111,15 @@ namespace revng {
 		std::vector<DefUse> traverseDefUseChain(const Value *V) const;
 		std::vector<DefUseChain> analyzeSingleArgUsage(const Function *F, const Value* var);
 		void analyzeVSPUsage(const RevngFunction*,const  Function *F);
-		void findRiskyStores();
-		bool isInChain(std::vector<DefUse> &chain, DefUse &V) const;
-		bool containsRiskyStore(std::vector<RiskyStore>& vector, const StoreInst* store) const;
+		void scanFlow(const Value *origin, const std::vector<DefUseChain> &chains);
 
 		std::vector<VariableFlow> currentVarsFlows;
 		std::vector<StackVarFlow> currentStackVarsFlows;
 		std::vector<RiskyStore> currentRiskyStores;
+		DenseSet<const StoreInst*> riskyStoreSet; // stores in currentRiskyStores
 		const Function* currentF = nullptr;
 		const RevngFunction *currentRF = nullptr;
+		mutable DefUseClosure DUClosure; // def-use closures of currentF
 		// Stats
 		unsigned int FPUSkippedFunctions;
                 unsigned int TotalStackChains;
@@ -130,6 +137,19 @@ namespace revng {
 
 	using RelocationsMap = std::map<std::string, std::string>;
 
+	/// Intraprocedural taint facts of a function, computed once per function
+	struct TaintSummary {
+		/// Values whose def-use chains reach a return instruction
+		DenseSet<const Value*> returning;
+	};
+
+	/// Intraprocedural taint facts of an argument of a function, computed
+	/// once per (function, argument index)
+	struct ParamSummary {
+		/// Values derived from the argument through a chain of def-uses
+		DenseSet<const Value*> derived;
+	};
+
 
 	class BackwardPropagationPass : public ModulePass {
 	public:
@@ -146,19 +166,29 @@ namespace revng {
 		json::Object toJSON();
 
 	private:
-		FunctionScraper fScraper;
-
 		MarkedFunMap markedFunctions;
-		std::map<Function*, MarkedFunInfo> *nextCallers;
+		// Tainted functions whose callers still have to be visited, ordered
+		// by the bottom-up SCC index of MaxStepsPass and then by position in
+		// the module, as (SCC index, position) pairs
+		std::set<std::pair<unsigned int, unsigned int>> worklist;
+		std::vector<Function*> moduleFunctions; // functions by position
+		DenseMap<const Function*, unsigned int> functionPositions;
+		DenseMap<const Function*, TaintSummary> summaries;
+		DenseMap<std::pair<const Function*, unsigned int>, ParamSummary> paramSummaries;
 
 
 
 		const CallGraph* moduleCG = nullptr; // build local call graph on start
+		ReverseCallGraph reverseCG; // callee -> callers index of moduleCG
 		const Function* currentF = nullptr;
+		DefUseReachability DUReachability; // def-use reachability of the last queried function
 		bool toAnalyze(Function *F); // Check metadata
 
 		MarkedFunInfo getReachedParamIndex(Function &F, const Value* ); // Return -1 i
 		MarkedFunInfo isReturnedByFun(Function &F, const Value*); // traverse backward de-chains
+		const TaintSummary& getSummary(const Function &F);
+		const ParamSummary& getParamSummary(const Function &F, unsigned int argIndex);
+		MarkedFunInfo propagateToCaller(Function &caller, MarkedFunInfo &calledInfo);
 		const Value* getInputValue(Function &F, MarkedFunInfo& mf);
                 void markCaller(Function* caller,  int argPos);
 		void markInputFunctions(Module &M);
@@ -166,7 +196,7 @@ namespace revng {
 		void markPassFunction(Function* F, bool);
 		void parseInputFiles(Module &M);
 		std::vector<Function*> findCallersInCG(Function *F);
-		Function* searchFunctionByAddress(Module &M, std::string address);
+		static Function* searchFunctionByAddress(const DenseMap<uint64_t, Function*> &functionsByAddress, StringRef address);
 
 		// Check if the values is a function argument and returns its index,
 		// otherwise returns a negative number
@@ -181,7 +211,7 @@ namespace revng {
 		const Value* findNextInstructionInBB(const Instruction* I, const BasicBlock *BB);
 		void printNextCallers();
 
-		bool addMarkedFunction(Function *F, int argIndex, std::string argName, std::map<Function*,MarkedFunInfo>* );
+		bool addMarkedFunction(Function *F, int argIndex, std::string argName);
   };
 
 
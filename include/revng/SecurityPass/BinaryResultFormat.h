@@ -0,0 +1,125 @@
+#ifndef REVNG_SECURITY_BINARY_RESULT_FORMAT
+#define REVNG_SECURITY_BINARY_RESULT_FORMAT
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <memory>
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Layout of the binary security analysis results
+	///
+	/// A file is a header followed by four tables, each aligned to 8 bytes:
+	/// function records, loop records, instruction locations and a string
+	/// table of NUL-terminated strings. Strings are referred to by their
+	/// offset in the string table, loops and locations by a [first, first +
+	/// count) range of their table. Instructions are identified by the
+	/// address of the guest instruction they were lifted from, not by their
+	/// IR. Every field is little endian.
+	namespace binary {
+
+		const char Magic[8] = { 'R', 'V', 'N', 'G', 'S', 'E', 'C', '\0' };
+		const uint32_t Version = 1;
+
+		using u32 = support::ulittle32_t;
+		using u64 = support::ulittle64_t;
+
+		struct Header {
+			char magic[8];
+			u32 version;
+			u32 numFunctions;
+			u32 numLoops;
+			u32 numLocations;
+			u64 functionsOffset;
+			u64 loopsOffset;
+			u64 locationsOffset;
+			u64 stringsOffset;
+			u64 stringsSize;
+		};
+
+		enum FunctionFlags : uint32_t {
+			IsMarked = 1 << 0,
+			IsSafe = 1 << 1
+		};
+
+		struct FunctionRecord {
+			u64 entryAddress;
+			u32 name;
+			u32 flags;
+			u32 firstLoop;
+			u32 numLoops;
+			u32 numRiskyStores;
+			u32 reserved;
+		};
+
+		struct LoopRecord {
+			u32 name;
+			u32 firstBranch;
+			u32 numBranches;
+			u32 firstStore;
+			u32 numStores;
+			u32 reserved;
+		};
+
+		struct LocationRecord {
+			u64 address;
+			u32 offset;
+			u32 reserved;
+		};
+
+		static_assert(sizeof(Header) == 64, "Unexpected padding in binary::Header");
+		static_assert(sizeof(FunctionRecord) == 32, "Unexpected padding in binary::FunctionRecord");
+		static_assert(sizeof(LoopRecord) == 24, "Unexpected padding in binary::LoopRecord");
+		static_assert(sizeof(LocationRecord) == 16, "Unexpected padding in binary::LocationRecord");
+
+	}
+
+	/// Zero-copy reader of binary security analysis results
+	///
+	/// The file is mapped in memory and validated once by open(): after
+	/// that, records are read in place, nothing is parsed or copied.
+	class BinaryResultReader {
+	public:
+		static Expected<std::unique_ptr<BinaryResultReader>> open(StringRef fileName);
+		static Expected<std::unique_ptr<BinaryResultReader>> create(std::unique_ptr<MemoryBuffer> buffer);
+
+		ArrayRef<binary::FunctionRecord> functions() const { return functionTable; }
+		ArrayRef<binary::LoopRecord> loops(const binary::FunctionRecord &function) const {
+			return loopTable.slice(function.firstLoop, function.numLoops);
+		}
+		ArrayRef<binary::LocationRecord> branches(const binary::LoopRecord &loop) const {
+			return locationTable.slice(loop.firstBranch, loop.numBranches);
+		}
+		ArrayRef<binary::LocationRecord> stores(const binary::LoopRecord &loop) const {
+			return locationTable.slice(loop.firstStore, loop.numStores);
+		}
+		StringRef getString(uint32_t offset) const;
+		StringRef getName(const binary::FunctionRecord &function) const { return getString(function.name); }
+		StringRef getName(const binary::LoopRecord &loop) const { return getString(loop.name); }
+
+		/// The results as JSON, laid out as the "isMarked", "isSafe" and
+		/// "loopDependenciesAnalysis" members of the JSON records, with
+		/// locations in place of the printed IR
+		json::Value toJSON() const;
+
+	private:
+		explicit BinaryResultReader(std::unique_ptr<MemoryBuffer> buffer) : buffer(std::move(buffer)) {}
+		Error validate();
+
+		std::unique_ptr<MemoryBuffer> buffer;
+		ArrayRef<binary::FunctionRecord> functionTable;
+		ArrayRef<binary::LoopRecord> loopTable;
+		ArrayRef<binary::LocationRecord> locationTable;
+		StringRef strings;
+	};
+
+}
+
+#endif // REVNG_SECURITY_BINARY_RESULT_FORMAT
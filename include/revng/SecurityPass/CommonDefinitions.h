@@ -16,9 +16,11 @@
 #include "llvm/IR/CFG.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/JSON.h"
+#include "llvm/Support/Allocator.h"
 #include <ostream>
 #include <vector>
 #include <deque>
+#include "revng/Support/Debug.h"
 
 // Constant definitions
 
@@ -27,13 +29,25 @@
 #define REVNG_INPUT_POS_MD "revng.dm.inputgen.argpos" // STRING
 #define REVNG_INPUT_TOANALYZE_MD "revng.dm.inputgen.toanalyze" // BOOLEAN
 #define REVNG_SECURITY_MARKED_MD "revng.dm.inputgen.mark" // BOOL
+#define REVNG_SECURITY_SLICE_MD "revng.dm.inputgen.slice" // BOOL
 
 #define MAX_PASS_VERBOSITY_LEVEL 3
 
+/// Write a message to the security logger of level \p Level, the message is
+/// not even built if the level is disabled
+#define security_log(Level, ...)                                   \
+	do {                                                       \
+		if (revng::isSecurityLogEnabled(Level)) {           \
+			revng::get_print_stream(Level) << __VA_ARGS__; \
+		}                                                  \
+	} while (0)
+
 using namespace llvm;
 
 namespace revng {
-	static bool only_marked_funs = false;
+	// set by -only-marked-funs and -analyze-input-slice
+	extern bool only_marked_funs;
+	extern bool input_slice_only;
 
 
 	using DefUse = std::pair<const User*, const Value*>;
@@ -42,6 +56,20 @@ namespace revng {
 	using RiskyStore = std::pair<const Value*, const StoreInst*>;
 	using VulnerableLoopItem = std::pair<std::vector<const Instruction*>, std::vector<const RiskyStore*>>;
 
+	/// Where an instruction comes from: the address of the guest instruction
+	/// it was lifted from (its newpc marker) and its distance from the marker
+	struct InstructionLocation {
+		uint64_t address = 0;
+		uint32_t offset = 0;
+	};
+
+	/// What LoopDependenciesPass found in a loop, without references to the IR
+	struct LoopFindings {
+		std::string name;
+		std::vector<InstructionLocation> branches;
+		std::vector<InstructionLocation> stores;
+	};
+
 
 
 	class VirtualStackParam {
@@ -65,6 +93,24 @@ namespace revng {
 
 	using StackVarFlow = std::pair<const VirtualStackParam* , std::vector<DefUseChain>>;
 
+	/// Bump allocator owning the result objects of the analysis of one function
+	///
+	/// A pass resets it when it starts on a new function: the objects it
+	/// hands out stay valid, at a stable address, until then, and are all
+	/// destroyed at once without going through malloc for each of them.
+	template<typename T>
+	class FunctionArena {
+	public:
+		template<typename... Args>
+		T* create(Args&&... args) {
+			return new (allocator.Allocate()) T(std::forward<Args>(args)...);
+		}
+		void reset() { allocator.DestroyAll(); }
+
+	private:
+		SpecificBumpPtrAllocator<T> allocator;
+	};
+
 
 
 	struct RevngFunctionParamsPass;
@@ -92,30 +138,78 @@ namespace revng {
 	};
 
 
-	inline raw_ostream& get_print_stream(int verbosity) {
-		static raw_null_ostream* nullStream = new raw_null_ostream();
-		if( verbosity <= MAX_PASS_VERBOSITY_LEVEL )
-			return errs();
-		else {
-			// TODO return null stream
-			return *nullStream;
+	/// Loggers of the security passes, one per verbosity level: 1 for the
+	/// per-function summaries, 2 for the progress of the analyses, 3 for
+	/// everything else. Levels up to -security-verbosity (1 by default) are
+	/// enabled, each one can also be enabled with -debug-log.
+	extern Logger<> SecurityLog;
+	extern Logger<> SecurityVerboseLog;
+	extern Logger<> SecurityDebugLog;
+
+	/// When set, replaces the loggers as the destination of get_print_stream
+	/// for the current thread: workers of the parallel driver buffer their
+	/// output here instead of interleaving it
+	extern thread_local raw_ostream* threadPrintStream;
+
+	inline bool isSecurityLogEnabled(int verbosity) {
+		switch (verbosity) {
+		case 0:
+		case 1:
+			return SecurityLog.isEnabled();
+		case 2:
+			return SecurityVerboseLog.isEnabled();
+		case MAX_PASS_VERBOSITY_LEVEL:
+			return SecurityDebugLog.isEnabled();
+		default:
+			return false;
 		}
-
 	}
 
+	/// Stream writing complete lines to the logger of \p verbosity, the
+	/// output of all the levels is buffered together until flushSecurityLogs
+	raw_ostream& getSecurityLogStream(int verbosity);
+	/// Push the pending output of the logger streams
+	void flushSecurityLogs();
 
-	inline bool isaSkippedFunction(const Function*F) {
-		if( F->getName().startswith("bb.__")) {
-			return true;
-		}
-		if (F->getName().startswith("bb.vasnprintf")) {
-		    return true;
+	/// Stream for output of level \p verbosity, prefer security_log, which
+	/// does not evaluate its arguments when the level is disabled
+	inline raw_ostream& get_print_stream(int verbosity) {
+		// one per thread, the stream buffer is not synchronized
+		static thread_local raw_null_ostream nullStream;
+		if (!isSecurityLogEnabled(verbosity)) {
+			return nullStream;
 		}
-		if (F->getName().startswith("bb.")) {
-			return false;
-		} else {
-			return true;
+		if (threadPrintStream != nullptr) {
+			return *threadPrintStream;
 		}
+		return getSecurityLogStream(verbosity);
+	}
+
+	/// What the security passes need to know about a function, from its name
+	/// and its revng metadata
+	struct FunctionClass {
+		MDNode *entry = nullptr; // revng.func.entry, if any
+		bool isolated = false; // revng.func.entry and a revng name
+		bool skipped = true; // out of the scope of the analysis
+		bool hasInputMD = false;
+		bool input = false; // REVNG_INPUT_MD is "true"
+		bool marked = false; // REVNG_SECURITY_MARKED_MD is "true"
+		bool outsideSlice = false; // REVNG_SECURITY_SLICE_MD is "false"
+	};
+
+	/// Classify every function of \p M once, in a side table that the
+	/// predicates below query instead of looking up metadata by name. Not
+	/// thread safe: call it before starting workers that query the table.
+	void classifyFunctions(const Module &M);
+
+	/// Refresh the class of \p F after its metadata was changed
+	void reclassifyFunction(const Function &F);
+
+	/// Class of \p F, from the table if \p F is in it, computed otherwise
+	FunctionClass getFunctionClass(const Function *F);
+
+	inline bool isaSkippedFunction(const Function*F) {
+		return getFunctionClass(F).skipped;
 	}
 
 	inline MDString* getMDString(const Function* F, std::string mdname) {
@@ -130,66 +224,31 @@ namespace revng {
 	}
 
 	inline bool isMarked(const Function* F)  {
-		MDString* fMD = getMDString(F, REVNG_SECURITY_MARKED_MD);
-		if(fMD) {
-			if(fMD->getString().compare("true") == 0) {
-				return true;
-			} else {
-				return false;
-			}
-		}
-	        return false;
+		return getFunctionClass(F).marked;
+	}
+
+	/// True if -analyze-input-slice is set and revng-input-slice tagged \p F
+	/// as not reachable from inputs (untagged functions are analyzed)
+	inline bool isOutsideInputSlice(const Function* F) {
+		return input_slice_only && getFunctionClass(F).outsideSlice;
 	}
 
 	inline bool isInputFunction(const Function* F)  {
-		MDString* fMD = getMDString(F, REVNG_INPUT_MD);
-		if(fMD) {
-			if(fMD->getString().compare("true") == 0) {
-				return true;
-			} else {
-				return false;
-			}
+		FunctionClass FC = getFunctionClass(F);
+		if (!FC.hasInputMD) {
+			security_log(3, "Warning! The function " << F->getName() << " is not an input function\n");
 		}
-		get_print_stream(3) << "Warning! The function " << F->getName() << " is not an input function\n";
-		return false;
+		return FC.input;
 	}
 
-	inline bool isInDefUseChain(Function &F, const Value* startVal, const Value* V) {
-		if(startVal == V)
-			return true;
-		if(startVal == nullptr || V == nullptr)
-			return false;
-		std::deque<const Value*> nextValues;
-		nextValues.push_back(startVal);
-		do {
-			const Value* currentVal = nextValues.front();
-			nextValues.pop_front();
-			if (currentVal == nullptr) {
-				continue;
-			}
-			if(currentVal == V)
-				return true;
-
-			for( const Use &U : currentVal->uses()) {
-				if(U.getUser() == nullptr) {
-					continue;
-				}
-				const User* currentUser = U.getUser();
-				if( ! isa<Instruction>(currentUser) )
-					continue;
-				if( dyn_cast<Instruction>(currentUser)->getFunction() != &F) {
-					continue;
-				}
-				const Value* nextVal = dyn_cast<Value>(currentUser);
-				if(std::find(nextValues.begin(), nextValues.end(), nextVal) == nextValues.end() ) {
-					nextValues.push_back(nextVal);
-
-				}
-			}
-		} while( !nextValues.empty() );
-		return false;
+	/// Entry address of an isolated function, from its revng.func.entry
+	/// metadata in the class of \p F, 0 if it has none
+	uint64_t getFunctionEntryAddress(const Function &F);
 
-	}
+	/// Location of \p I, found walking back to the closest newpc marker
+	/// through single predecessors. Without a marker the address is 0 and the
+	/// offset is the distance from the start of the walk.
+	InstructionLocation getInstructionLocation(const Instruction *I);
 
 
 
@@ -0,0 +1,56 @@
+#ifndef REVNG_DEF_USE_CLOSURE
+#define REVNG_DEF_USE_CLOSURE
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Value.h"
+#include <deque>
+#include <vector>
+#include "CommonDefinitions.h"
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Per-function def-use closure engine
+	///
+	/// Computes the forward def-use closure of a value restricted to the
+	/// instructions of a single function. Each closure is computed at most once
+	/// per function and kept in a pool, so that all the flows that go through
+	/// the same instruction share the same traversal. Duplicates are detected
+	/// with a dense visited set keyed by (User*, Value*) instead of scanning the
+	/// chain built so far.
+	class DefUseClosure {
+	public:
+		DefUseClosure() {};
+
+		/// Drop all the cached closures and start working on \p F
+		void reset(const Function *F);
+		const Function* getFunction() const { return this->currentF; }
+
+		/// Def-uses reachable from \p V, in breadth-first order
+		///
+		/// A store contributes the def-use (store, pointer operand), every
+		/// other instruction contributes (instruction, used value). The
+		/// returned reference stays valid until the next reset().
+		const DefUseChain& getClosure(const Value *V);
+
+		/// One chain for each direct user of \p V inside the function: the
+		/// first def-use is (user, V), followed by the closure of the user
+		std::vector<DefUseChain> getValueFlows(const Value *V);
+
+		unsigned int getNumClosures() const { return this->pool.size(); }
+
+	private:
+		const Function *currentF = nullptr;
+		std::deque<DefUseChain> pool;
+		DenseMap<const Value*, const DefUseChain*> closures;
+		DenseSet<DefUse> visited;
+		std::vector<const Value*> worklist;
+	};
+
+}
+
+#endif // REVNG_DEF_USE_CLOSURE
@@ -0,0 +1,65 @@
+#ifndef REVNG_DEF_USE_REACHABILITY
+#define REVNG_DEF_USE_REACHABILITY
+
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+#include <vector>
+#include "CommonDefinitions.h"
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Per-function reachability oracle over the SSA def-use graph
+	///
+	/// Nodes are the arguments and instructions of the function, plus the
+	/// constants and globals they use; every value has an edge to each of
+	/// its users. Strongly connected components (phi cycles) are condensed,
+	/// and their Tarjan numbering is a topological order of the condensed
+	/// DAG, which rejects most negative queries in constant time. The set of
+	/// components reachable from a source is computed once, as a bitset,
+	/// the first time the source is queried: after that every query is a bit
+	/// test. The graph is built lazily, on the first query after reset().
+	class DefUseReachability {
+	public:
+		DefUseReachability() {};
+
+		/// Drop everything and start working on \p F
+		void reset(const Function *F);
+		const Function* getFunction() const { return this->currentF; }
+
+		/// True if \p to is \p from or is derived from it through a chain of
+		/// def-uses inside the function
+		bool reaches(const Value *from, const Value *to);
+
+		unsigned int getNumNodes() const { return this->nodeSCC.size(); }
+		unsigned int getNumSCCs() const { return this->numSCCs; }
+
+	private:
+		void build();
+		unsigned int addNode(const Value *V);
+		void computeSCCs();
+		const BitVector& getReachableSCCs(unsigned int SCC);
+
+		const Function *currentF = nullptr;
+		bool built = false;
+
+		// def-use graph, edges in CSR form
+		DenseMap<const Value*, unsigned int> nodeIDs;
+		std::vector<const Value*> nodes;
+		std::vector<unsigned int> edgeBegin;
+		std::vector<unsigned int> edgeTargets;
+
+		// condensed graph
+		std::vector<unsigned int> nodeSCC;
+		unsigned int numSCCs = 0;
+		std::vector<unsigned int> SCCEdgeBegin;
+		std::vector<unsigned int> SCCEdgeTargets;
+		DenseMap<unsigned int, BitVector> reachableSCCs;
+	};
+
+}
+
+#endif // REVNG_DEF_USE_REACHABILITY
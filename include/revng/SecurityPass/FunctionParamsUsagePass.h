@@ -9,6 +9,9 @@ STATISTIC(TotalVarChains, "Number of defuse chains found for parameters");
 STATISTIC(TotalStores, "Number of stores depending on params found");
 
 #include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
@@ -28,6 +31,8 @@ STATISTIC(TotalStores, "Number of stores depending on params found");
 #include <vector>
 #include "RevngFunctionParamsPass.h"
 #include "CommonDefinitions.h"
+#include "DefUseClosure.h"
+#include "SecurityProfile.h"
 #include "RevngFunctionParamsPass.h"
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Support/Debug.h"
@@ -50,19 +55,44 @@ namespace revng {
 		FunctionParamsUsagePass();
 		virtual ~FunctionParamsUsagePass() {};
 		virtual bool runOnFunction(Function &F) override;
+		/// Analyze \p F given its parameters, without going through the pass
+		/// manager. Returns false if \p F is out of the analysis scope.
+		bool analyze(Function &F, const RevngFunction *RF);
+		/// True if the verbose output prints value ranges, which need SCEV
+		static bool printsValueRanges();
+		/// Use \p SE to print value ranges of the current function
+		void setScalarEvolution(ScalarEvolution *SE) { this->SCEV = SE; }
 		virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
 		virtual void print(raw_ostream &OS, const Module *M) const override;
 
 		std::vector<DefUse> traverseDefUseChain(const Value *V) const;
 		bool isaUserOfParams(const User *U) const;
-		const std::vector<RiskyStore> getRiskyStores() const { return this->currentRiskyStores;}
+		/// True if \p V derives from a parameter of the current function
+		bool isTainted(const Value *V) const { return taintedValues.count(V) != 0; }
+		/// True if \p store writes through a pointer derived from a parameter
+		bool isaRiskyStore(const StoreInst *store) const;
+		const std::vector<RiskyStore> &getRiskyStores() const { return this->currentRiskyStores;}
+		/// Risky stores inside \p BB, in the order of getRiskyStores()
+		ArrayRef<RiskyStore> getRiskyStores(const BasicBlock *BB) const {
+			auto it = riskyStoresByBlock.find(BB);
+			return it == riskyStoresByBlock.end() ? ArrayRef<RiskyStore>() : ArrayRef<RiskyStore>(it->second);
+		}
 		bool doInitialization(Module &M) override;
 		bool doFinalization(Module &M) override;
 		json::Object toJSON();
 
+		/// Pass statistics, counted also per function
+		enum StatisticKind { SkippedFunctionsStat, StackChainsStat, VarChainsStat, StoresStat, StatisticsCount };
+		/// Statistics counted by the last analyze(), by StatisticKind, so that
+		/// results replayed from a cache can count them again
+		ArrayRef<unsigned int> getStatistics() const { return statistics; }
+		/// Add \p counts, as returned by getStatistics(), to the pass statistics
+		static void addStatistics(ArrayRef<unsigned int> counts);
+
 	private:
 		const CallGraph* moduleCG = nullptr; // build local call graph on start
 		const Function* currentF = nullptr;
+		mutable DefUseClosure DUClosure; // def-use closures of currentF
 		bool isaUserOfParameter(const User *U,const Value *P) const;
 		bool isaRiskyStore(const DefUse &DU) const;
 		void printOperandsRange(raw_ostream &OS, const Instruction *UR) const;
@@ -71,6 +101,12 @@ namespace revng {
 		std::vector<VariableFlow> currentVarsFlows;
 		std::vector<StackVarFlow> currentStackVarsFlows;
 		std::vector<RiskyStore> currentRiskyStores;
+		DenseMap<const BasicBlock*, SmallVector<RiskyStore, 2>> riskyStoresByBlock;
+		DenseSet<const StoreInst*> riskyStoreSet; // stores in currentRiskyStores
+		DenseSet<const Value*> taintedValues; // values derived from parameters
+		unsigned int visitedStores = 0; // by scanFlow, for the profile
+		unsigned int statistics[StatisticsCount] = {}; // reset per function
+		void count(StatisticKind kind);
 		// std::vactor<VariableFlow> getVarsFlows();
 		// std::vector<StackVarFlow> getStackVarsFlows();
 		// std::vector<RiskyStore> getRiskyStores();
@@ -78,7 +114,6 @@ namespace revng {
 
 		json::Object JSONoutput;
 		const RevngFunction *currentRF;
-		LazyValueInfo *LVI = nullptr ;
 		ScalarEvolution *SCEV = nullptr;
 		void deallocDefUseChains();
 		void analyzeArgsUsage(const RevngFunction*, Function *F);
@@ -90,9 +125,8 @@ namespace revng {
 
 		std::vector<DefUseChain> analyzeSingleArgUsage(Function *F, const Value* var);
 		void analyzeVSPUsage(const RevngFunction*, Function *F);
-		void findRiskyStores();
-		bool isInChain(std::vector<DefUse> &chain, DefUse &V) const;
-		bool containsRiskyStore(std::vector<RiskyStore>& vector, const StoreInst* store) const;
+		void scanFlow(const Value *origin, const std::vector<DefUseChain> &chains);
+		void indexRiskyStores();
 		bool alreadyStartFile = false;
 		// RevngFunction result;
 	};
@@ -0,0 +1,55 @@
+#ifndef REVNG_INPUT_SLICE_PASS
+#define REVNG_INPUT_SLICE_PASS
+
+#include "llvm/ADT/Statistic.h"
+
+#define DEBUG_TYPE "InputSlicePass"
+STATISTIC(SliceFunctions, "Number of functions in the slice reachable from inputs");
+STATISTIC(SliceExcludedFunctions, "Number of functions outside the slice reachable from inputs");
+
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+#include "CommonDefinitions.h"
+#include "ReverseCallGraph.h"
+
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Tag the functions input data can reach
+	///
+	/// The slice starts from the input sources (revng.dm.inputgen) and
+	/// the callers input is propagated to: the functions marked by
+	/// revng-backward-prop or, if none is marked, every transitive caller of
+	/// an input source. Everything these functions call, transitively, is
+	/// added as well, since tainted values may be passed down. Every defined
+	/// function gets a REVNG_SECURITY_SLICE_MD tag telling whether it is in
+	/// the slice; with -analyze-input-slice the analyses skip the others.
+	class InputSlicePass : public ModulePass {
+	public:
+		static char ID;
+		InputSlicePass();
+		virtual ~InputSlicePass() {};
+		virtual bool runOnModule(Module &M) override;
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
+		virtual void print(raw_ostream &OS, const Module *M) const override;
+
+		bool isInSlice(const Function *F) const { return slice.count(F) != 0; }
+
+	private:
+		void visitCallers(const ReverseCallGraph &RCG, std::vector<const Function*> &worklist);
+		void visitCallees(const ReverseCallGraph &RCG, std::vector<const Function*> &worklist);
+
+		DenseSet<const Function*> slice;
+		unsigned int numFunctions = 0;
+	};
+
+}
+
+#endif // REVNG_INPUT_SLICE_PASS
@@ -17,6 +17,7 @@ STATISTIC(OverallFunctions, "Number of overall functions analyzed");
 #include "llvm/Passes/PassPlugin.h"
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/Instruction.h"
@@ -32,6 +33,7 @@ STATISTIC(OverallFunctions, "Number of overall functions analyzed");
 #include "CommonDefinitions.h"
 #include "RevngFunctionParamsPass.h"
 #include "FunctionParamsUsagePass.h"
+#include "SecurityProfile.h"
 
 
 using namespace llvm;
@@ -48,6 +50,9 @@ namespace revng {
     LoopDependenciesPass();
     virtual ~LoopDependenciesPass() {};
     virtual bool runOnFunction(Function &F) override;
+    /// Analyze the loops of \p F without going through the pass manager.
+    /// Returns false if \p F is out of the analysis scope.
+    bool analyze(Function &F, const RevngFunction *RF, FunctionParamsUsagePass &FPU, LoopInfo &LI);
     virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
     virtual void print(raw_ostream &OS, const Module *M) const override;
     virtual bool doInitialization(Module &) override;
@@ -55,7 +60,18 @@ namespace revng {
     DefUseChain traverseBackwardDefUseChain(const User*);
     bool isFunctionSafe() const;
     json::Object toJSON() const;
-	  std::map<const StringRef, VulnerableLoopItem*> getVulnerableLoops() const { return this->vulnerableLoops; };
+    /// Findings of the current function, by instruction location
+    std::vector<LoopFindings> getLoopFindings() const;
+	  /// Valid until the next function is analyzed
+	  const std::map<const StringRef, VulnerableLoopItem*> &getVulnerableLoops() const { return this->vulnerableLoops; };
+	  /// Pass statistics, counted also per function
+	  enum StatisticKind { SkippedFunctionsStat, FilteredStoresStat, LoopsStat, CandidateLoopsStat,
+	                       VulnerableFunctionsStat, InputVulnerableFunctionsStat, OverallFunctionsStat, StatisticsCount };
+	  /// Statistics counted by the last analyze(), by StatisticKind, so that
+	  /// results replayed from a cache can count them again
+	  ArrayRef<unsigned int> getStatistics() const { return statistics; }
+	  /// Add \p counts, as returned by getStatistics(), to the pass statistics
+	  static void addStatistics(ArrayRef<unsigned int> counts);
 	  unsigned int getNumRiskyStores() const {
 		  unsigned int counter = 0;
 		  for(auto VI : vulnerableLoops) {
@@ -68,8 +84,17 @@ namespace revng {
   private:
     std::vector<const Instruction*> candidateBranches;
     std::map<const StringRef, VulnerableLoopItem*> vulnerableLoops;
+    // own the vulnerable loops and their risky stores, reset per function
+    FunctionArena<VulnerableLoopItem> loopItems;
+    FunctionArena<RiskyStore> loopRiskyStores;
     bool analyzeLoopBasicBlock(const BasicBlock*, FunctionParamsUsagePass&);
     bool analyzeLoop(const Loop*, FunctionParamsUsagePass&, VulnerableLoopItem&);
+    void resetResults();
+    // for the profile, reset per function
+    unsigned int traversedChains = 0;
+    unsigned int visitedStores = 0;
+    unsigned int statistics[StatisticsCount] = {}; // reset per function
+    void count(StatisticKind kind);
     bool analyzeLoopCondition(const CmpInst* , FunctionParamsUsagePass&);
     void dumpAnalysis(raw_fd_ostream &FOS, Function &F) const;
     const RevngFunction *currentRF;
@@ -7,11 +7,11 @@
 STATISTIC(MaxLength, "Max length of branch or loop found");
 
 #include "llvm/Pass.h"
-#include "llvm/Analysis/CallGraphSCCPass.h"
+#include "llvm/Analysis/CallGraph.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
-#include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/Instruction.h"
@@ -34,31 +34,41 @@ using namespace llvm;
 
 namespace revng {
 
-	static unsigned int SHARED_MAX_LENGTH = 0;
-
-	struct MaxStepsPass : public CallGraphSCCPass {
+	/// Length of the longest acyclic call chain of the module
+	///
+	/// The call graph is condensed in its strongly connected components, which
+	/// form a DAG, and the longest path of the DAG is computed in a single
+	/// bottom-up sweep, in time linear in the size of the call graph. Each SCC
+	/// weighs as many steps as the functions it contains, so the result bounds
+	/// the length of every path of the call graph that does not visit a
+	/// function twice.
+	struct MaxStepsPass : public ModulePass {
 	public:
 		static char ID;
 
 		MaxStepsPass();
-		virtual bool doFinalization(CallGraph &CG) override;
 		virtual ~MaxStepsPass() {};
-		virtual bool runOnSCC(CallGraphSCC &SCC) override;
+		virtual bool runOnModule(Module &M) override;
 		virtual  void getAnalysisUsage(AnalysisUsage &AU) const override;
 		void print(raw_ostream &OS, const Module *M) const override;
-		unsigned int getLength() const { return this->maxLength; };
 
-		static unsigned int getMaxLength() { return SHARED_MAX_LENGTH; }
+		/// Number of functions on the longest acyclic call chain
+		unsigned int getLength() const { return this->maxLength; };
+		/// Position of the SCC of \p F in bottom-up order: callees come
+		/// before their callers (functions outside the call graph come last)
+		unsigned int getSCCIndex(const Function *F) const;
 
 	private:
 		// methods
-		unsigned int getSCCLength(CallGraphSCC &SCC);
-
-		void dumpMaxLength();
+		void computeLongestPath(const CallGraph &CG);
+		void closeSCC(const std::vector<const CallGraphNode*> &SCC);
 	        void updateMaxLength(unsigned int );
 
-		unsigned int maxLength = 0 ;
 		// class variables
+		unsigned int maxLength = 0 ;
+		DenseMap<const CallGraphNode*, unsigned int> nodeSCC;
+		std::vector<unsigned int> SCCLength;
+		DenseMap<const Function*, unsigned int> functionSCC;
 
 	};
 }
@@ -0,0 +1,57 @@
+#ifndef REVNG_PARALLEL_SECURITY_PASS
+#define REVNG_PARALLEL_SECURITY_PASS
+
+#include "llvm/Pass.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/JSON.h"
+#include <string>
+#include <vector>
+#include "CommonDefinitions.h"
+#include "SecurityWrapperPass.h"
+
+
+using namespace llvm;
+
+namespace revng {
+
+  /// Run the revng-security-analysis pipeline on many functions at once
+  ///
+  /// Each analysis only reads the IR, so the isolated functions are sharded
+  /// across a pool of worker threads. Every worker owns its own instances of
+  /// RevngFunctionParamsPass, FunctionParamsUsagePass and
+  /// LoopDependenciesPass, computes LoopInfo by itself and buffers its output
+  /// and counters locally. Results are merged in module order, so the dumped
+  /// records and the log are the same as with the sequential pass.
+  class ParallelSecurityPass : public ModulePass {
+  public:
+    static char ID;
+    ParallelSecurityPass();
+    virtual ~ParallelSecurityPass() {};
+    virtual bool runOnModule(Module &M) override;
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
+    virtual void print(raw_ostream &OS, const Module *M) const override;
+
+  private:
+    struct FunctionResult {
+      bool analyzed = false;
+      json::Value record = nullptr;
+      FunctionFindings findings;
+      std::string log;
+    };
+
+    struct ShardStatistics {
+      unsigned int analyzedFunctions = 0;
+      unsigned int skippedFunctions = 0;
+    };
+
+    static void analyzeFunction(Function &F, RevngFunctionParamsPass &RFP, FunctionParamsUsagePass &FPU, LoopDependenciesPass &LDP,
+                                const FunctionResultCache *cache, bool buildRecord, bool buildFindings, FunctionResult &result, ShardStatistics &stats);
+
+    std::vector<Function*> functions;
+  };
+
+}
+
+#endif // REVNG_PARALLEL_SECURITY_PASS
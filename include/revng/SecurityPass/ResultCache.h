@@ -0,0 +1,73 @@
+#ifndef REVNG_SECURITY_RESULT_CACHE
+#define REVNG_SECURITY_RESULT_CACHE
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/JSON.h"
+#include <string>
+#include <vector>
+#include "FunctionParamsUsagePass.h"
+#include "LoopDependenciesPass.h"
+
+using namespace llvm;
+
+namespace revng {
+
+	/// What the security analysis of a function produces: the results of
+	/// FunctionParamsUsagePass and LoopDependenciesPass, in the same form
+	/// they have in the dumped records
+	struct FunctionSecurityResult {
+		FunctionSecurityResult() = default;
+		FunctionSecurityResult(FunctionParamsUsagePass &FPU, const LoopDependenciesPass &LDP);
+
+		json::Value toJSON() const;
+		static Optional<FunctionSecurityResult> fromJSON(const json::Value &value);
+		/// Count again the pass statistics of the analysis that produced this
+		void replayStatistics() const;
+
+		json::Value paramsUsage = nullptr;
+		json::Value loopDependencies = nullptr;
+		bool isSafe = true;
+		unsigned int numRiskyStores = 0;
+		std::vector<LoopFindings> loops; // for the binary records
+		// by StatisticKind of each pass
+		std::vector<unsigned int> paramsUsageStatistics;
+		std::vector<unsigned int> loopDependenciesStatistics;
+	};
+
+	/// On-disk cache of per-function security results
+	///
+	/// Entries are keyed by a structural hash of the function: its body,
+	/// including the local names the results print, the globals and callees
+	/// it refers to, its revng metadata and its marked/input status.
+	/// Functions that did not change between two runs get the same key,
+	/// whatever the names or order of the other functions in the module, so
+	/// their results, and the statistics they counted, are replayed instead
+	/// of recomputed.
+	///
+	/// Each entry is a separate file, written to a temporary and renamed in
+	/// place, so the cache can be shared by concurrent workers and runs.
+	class FunctionResultCache {
+	public:
+		explicit FunctionResultCache(StringRef directory);
+
+		/// Structural hash of \p F, as a hex string
+		static std::string computeKey(const Function &F);
+
+		Optional<FunctionSecurityResult> lookup(StringRef key) const;
+		void store(StringRef key, StringRef functionName, const FunctionSecurityResult &result) const;
+
+		/// Result of \p F from the cache, computed (and stored) on a miss
+		FunctionSecurityResult getOrCompute(const Function &F, function_ref<FunctionSecurityResult()> compute) const;
+
+	private:
+		std::string getEntryPath(StringRef key) const;
+
+		std::string directory;
+	};
+
+}
+
+#endif // REVNG_SECURITY_RESULT_CACHE
@@ -0,0 +1,105 @@
+#ifndef REVNG_SECURITY_RESULT_WRITER
+#define REVNG_SECURITY_RESULT_WRITER
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "BinaryResultFormat.h"
+#include "CommonDefinitions.h"
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Incremental writer of the security analysis results
+	///
+	/// Function records are written, and flushed, as soon as they are
+	/// produced: memory use does not grow with the number of functions and a
+	/// killed run leaves every completed record on disk.
+	///
+	/// Two layouts are available. Object writes a single JSON object, one
+	/// member per function followed by "analysisProfile" and
+	/// "analysisStatistics", exactly as if it had been built in memory.
+	/// Lines writes one single-member object per
+	/// line (JSON Lines): every line is valid on its own and merging the
+	/// members of all the lines gives back the Object layout.
+	class JSONResultWriter {
+	public:
+		enum Format {
+			Object,
+			Lines
+		};
+
+		JSONResultWriter(StringRef fileName, Format format);
+		~JSONResultWriter();
+
+		bool isOpen() const { return output != nullptr; }
+		std::error_code getError() const { return error; }
+
+		/// Write the record of a function, records for a name already written
+		/// are dropped
+		bool writeFunction(StringRef name, json::Value record);
+		void writeStatistics(json::Object stats);
+		/// Write the per-stage costs of the run, see SecurityProfile.h
+		void writeProfile(json::Object profile);
+		void close();
+
+	private:
+		void writeMember(StringRef key, const json::Value &value);
+
+		std::unique_ptr<raw_fd_ostream> output;
+		std::error_code error;
+		Format format;
+		bool firstMember = true;
+		StringSet<> writtenFunctions;
+	};
+
+	/// What goes in the binary record of a function
+	struct FunctionFindings {
+		std::string name;
+		uint64_t entryAddress = 0;
+		bool isMarked = false;
+		bool isSafe = true;
+		unsigned int numRiskyStores = 0;
+		std::vector<LoopFindings> loops;
+	};
+
+	/// Writer of the binary security analysis results (BinaryResultFormat.h)
+	///
+	/// Records are small and hold no IR, they are kept in memory and the
+	/// file is written by close(), to a temporary renamed in place: a killed
+	/// run leaves no partial file behind.
+	class BinaryResultWriter {
+	public:
+		explicit BinaryResultWriter(StringRef fileName);
+		~BinaryResultWriter();
+
+		/// Add the record of a function, records for a name already written
+		/// are dropped
+		bool writeFunction(const FunctionFindings &findings);
+		std::error_code close();
+
+	private:
+		uint32_t addString(StringRef string);
+		uint32_t addLocations(ArrayRef<InstructionLocation> locations);
+
+		std::string fileName;
+		bool closed = false;
+		std::vector<binary::FunctionRecord> functions;
+		std::vector<binary::LoopRecord> loops;
+		std::vector<binary::LocationRecord> locations;
+		std::string strings;
+		StringMap<uint32_t> stringOffsets;
+		StringSet<> writtenFunctions;
+	};
+
+}
+
+#endif // REVNG_SECURITY_RESULT_WRITER
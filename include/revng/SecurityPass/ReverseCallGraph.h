@@ -0,0 +1,61 @@
+#ifndef REVNG_REVERSE_CALL_GRAPH
+#define REVNG_REVERSE_CALL_GRAPH
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instruction.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace revng {
+
+	/// Callee to callers index of a CallGraph
+	///
+	/// Built once from the CallGraph, it answers "who calls F" and "where does
+	/// caller C call F" without walking the whole graph. Callers are listed
+	/// once, in the order their definitions appear in the module, and the call
+	/// sites of each caller are kept in instruction order.
+	class ReverseCallGraph {
+	public:
+		using CallSiteList = SmallVector<const Instruction*, 1>;
+
+		struct CallerEntry {
+			Function *caller;
+			CallSiteList callSites;
+		};
+
+		ReverseCallGraph() {};
+
+		void build(const CallGraph &CG);
+		void clear();
+
+		/// Distinct functions calling \p callee
+		ArrayRef<Function*> getCallers(const Function *callee) const;
+		/// Distinct functions called by \p caller
+		ArrayRef<Function*> getCallees(const Function *caller) const;
+		/// Call sites of \p callee inside \p caller (empty if it is not a caller)
+		ArrayRef<const Instruction*> getCallSites(const Function *callee, const Function *caller) const;
+		ArrayRef<CallerEntry> getCallerEntries(const Function *callee) const;
+
+	private:
+		struct CalleeEntry {
+			std::vector<Function*> callers;
+			std::vector<CallerEntry> entries;
+			/// Position of each caller in entries
+			DenseMap<const Function*, unsigned> entryIndex;
+		};
+
+		void addCallerNode(const CallGraphNode &node);
+		void addCallEdge(Function *caller, Function *callee, const Instruction *callSite);
+
+		DenseMap<const Function*, CalleeEntry> callersMap;
+		DenseMap<const Function*, std::vector<Function*>> calleesMap;
+	};
+
+}
+
+#endif // REVNG_REVERSE_CALL_GRAPH
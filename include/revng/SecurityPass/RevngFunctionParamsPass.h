@@ -19,6 +19,7 @@
 #include <ostream>
 #include <vector>
 #include "CommonDefinitions.h"
+#include "SecurityProfile.h"
 
 using namespace llvm;
 
@@ -36,6 +37,9 @@ namespace revng {
 	  virtual  void getAnalysisUsage(AnalysisUsage &AU) const override;
 	  void print(raw_ostream &OS, const Module *M) const override;
 	  const RevngFunction* getRevngFunction() const;
+	  /// The virtual stack pointer of \p M, what doInitialization looks for
+	  static const GlobalVariable* findVirtualStackPointer(const Module &M);
+	  void setVirtualStackPointer(const GlobalVariable *VSP) { virtualStackPointer = VSP; }
 	  json::Object toJSON();
 
 	  static StringRef getInstructionTypeString(Instruction* I);
@@ -49,8 +53,8 @@ namespace revng {
 	  void filterOutRevngVars();
 	  bool isaRevngVar(const Value*);
 	  RevngFunction res;
-	  Regex revngFunctionRegex = { "bb..*" };
-	  const GlobalVariable* virtualStackPointer;
+	  FunctionArena<VirtualStackParam> stackParams; // owns res.functionVirtStackParams
+	  const GlobalVariable* virtualStackPointer = nullptr;
 
     // RevngFunction result;
  };
@@ -0,0 +1,133 @@
+#ifndef REVNG_SECURITY_ANALYSES
+#define REVNG_SECURITY_ANALYSES
+
+#include "llvm/Pass.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include <memory>
+#include "CommonDefinitions.h"
+#include "RevngFunctionParamsPass.h"
+#include "FunctionParamsUsagePass.h"
+#include "LoopDependenciesPass.h"
+#include "ResultWriter.h"
+#include "ResultCache.h"
+
+
+using namespace llvm;
+
+namespace revng {
+
+  /// New pass manager version of RevngFunctionParamsPass
+  ///
+  /// The result is cached in the FunctionAnalysisManager, so the revng
+  /// metadata of a function is parsed once, whatever the number of analyses
+  /// asking for it.
+  class RevngFunctionParamsAnalysis : public AnalysisInfoMixin<RevngFunctionParamsAnalysis> {
+    friend AnalysisInfoMixin<RevngFunctionParamsAnalysis>;
+    static AnalysisKey Key;
+
+  public:
+    class Result {
+    public:
+      explicit Result(std::unique_ptr<RevngFunctionParamsPass> RFP) : RFP(std::move(RFP)) {}
+      const RevngFunction *getRevngFunction() const { return RFP->getRevngFunction(); }
+      RevngFunctionParamsPass &getPass() { return *RFP; }
+      /// True if the function is an isolated revng function
+      bool isIsolated(const Function &F) const;
+
+    private:
+      // the RevngFunction and its stack parameters live in the pass
+      std::unique_ptr<RevngFunctionParamsPass> RFP;
+    };
+
+    Result run(Function &F, FunctionAnalysisManager &FAM);
+  };
+
+  /// New pass manager version of FunctionParamsUsagePass
+  ///
+  /// ScalarEvolution is requested only when value ranges are printed.
+  class FunctionParamsUsageAnalysis : public AnalysisInfoMixin<FunctionParamsUsageAnalysis> {
+    friend AnalysisInfoMixin<FunctionParamsUsageAnalysis>;
+    static AnalysisKey Key;
+
+  public:
+    class Result {
+    public:
+      Result(std::unique_ptr<FunctionParamsUsagePass> FPU, bool analyzed) : FPU(std::move(FPU)), analyzed(analyzed) {}
+      /// False if the function is out of the analysis scope
+      bool isAnalyzed() const { return analyzed; }
+      FunctionParamsUsagePass &getPass() { return *FPU; }
+      bool invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &Inv);
+
+    private:
+      std::unique_ptr<FunctionParamsUsagePass> FPU;
+      bool analyzed;
+    };
+
+    Result run(Function &F, FunctionAnalysisManager &FAM);
+  };
+
+  /// New pass manager version of LoopDependenciesPass
+  class LoopDependenciesAnalysis : public AnalysisInfoMixin<LoopDependenciesAnalysis> {
+    friend AnalysisInfoMixin<LoopDependenciesAnalysis>;
+    static AnalysisKey Key;
+
+  public:
+    class Result {
+    public:
+      Result(std::unique_ptr<LoopDependenciesPass> LDP, bool analyzed) : LDP(std::move(LDP)), analyzed(analyzed) {}
+      /// False if the function is out of the analysis scope
+      bool isAnalyzed() const { return analyzed; }
+      const LoopDependenciesPass &getPass() const { return *LDP; }
+      bool invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &Inv);
+
+    private:
+      std::unique_ptr<LoopDependenciesPass> LDP;
+      bool analyzed;
+    };
+
+    Result run(Function &F, FunctionAnalysisManager &FAM);
+  };
+
+  /// New pass manager version of SecurityWrapperPass
+  ///
+  /// Prints the result of every analyzed function and writes its records to
+  /// \p writer and \p binaryWriter, if any. With a \p cache, the analyses
+  /// only run on misses.
+  class SecurityAnalysisPrinterPass : public PassInfoMixin<SecurityAnalysisPrinterPass> {
+  public:
+    SecurityAnalysisPrinterPass(JSONResultWriter *writer, BinaryResultWriter *binaryWriter, const FunctionResultCache *cache) :
+      writer(writer), binaryWriter(binaryWriter), cache(cache) {}
+    PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+
+  private:
+    JSONResultWriter *writer;
+    BinaryResultWriter *binaryWriter;
+    const FunctionResultCache *cache;
+  };
+
+  /// Register the analyses above with the analysis managers built by \p PB,
+  /// and "revng-security-analysis" as a function pass of its pipelines
+  void registerSecurityAnalyses(PassBuilder &PB);
+
+  /// Run revng-security-analysis through a single new pass manager pipeline
+  ///
+  /// Same options and output as SecurityWrapperPass, but every analysis is
+  /// computed once per function and only when a consumer asks for it.
+  class SecurityPipelinePass : public ModulePass {
+  public:
+    static char ID;
+    SecurityPipelinePass();
+    virtual ~SecurityPipelinePass() {};
+    virtual bool runOnModule(Module &M) override;
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
+  };
+
+}
+
+#endif // REVNG_SECURITY_ANALYSES
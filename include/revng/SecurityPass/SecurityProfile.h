@@ -0,0 +1,51 @@
+#ifndef REVNG_SECURITY_PROFILE
+#define REVNG_SECURITY_PROFILE
+
+#include "llvm/IR/Function.h"
+#include "llvm/Support/JSON.h"
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+using namespace llvm;
+
+namespace revng {
+
+	/// The analyses run on each function, in pipeline order
+	enum class SecurityStage {
+		RevngFunctionParams,
+		FunctionParamsUsage,
+		LoopDependencies
+	};
+
+	/// Records the cost of one stage on one function when it goes out of
+	/// scope: wall time, def-use chains built or traversed and stores
+	/// visited
+	///
+	/// Costs are accumulated in CounterMaps keyed by function name, like the
+	/// per-function counters of the stack analysis, and are dumped with them
+	/// by -statistics. Recording is thread safe.
+	class SecurityStageTimer {
+	public:
+		SecurityStageTimer(SecurityStage stage, const Function &F) :
+			stage(stage), function(F.getName().str()), start(std::chrono::steady_clock::now()) {}
+		~SecurityStageTimer();
+
+		void addDefUseChains(uint64_t count) { defUseChains += count; }
+		void addStoresVisited(uint64_t count) { storesVisited += count; }
+
+	private:
+		SecurityStage stage;
+		std::string function;
+		std::chrono::steady_clock::time_point start;
+		uint64_t defUseChains = 0;
+		uint64_t storesVisited = 0;
+	};
+
+	/// Totals of every stage and its slowest functions, as many as
+	/// -security-profile-top
+	json::Object getSecurityProfile();
+
+}
+
+#endif // REVNG_SECURITY_PROFILE
@@ -32,6 +32,9 @@
 #include "FunctionParamsUsagePass.h"
 #include "RevngFunctionParamsPass.h"
 #include "FunctionParamsUsagePass.h"
+#include "ResultWriter.h"
+#include "ResultCache.h"
+#include <memory>
 
 
 using namespace llvm;
@@ -39,7 +42,12 @@ using namespace llvm;
   /// Collect information about translated and isolated functions
 namespace revng {
 
-  json::Object* AnalysisOutputJSON;
+  // Options shared with the parallel driver
+  extern cl::opt<bool> DumpAnalysis;
+  extern cl::opt<std::string> AnalysisOutputFilename;
+  extern cl::opt<JSONResultWriter::Format> DumpFormat;
+  extern cl::opt<std::string> SecurityCacheDir;
+  extern cl::opt<std::string> BinaryOutputFilename;
 
   class SecurityWrapperPass : public FunctionPass {
   public:
@@ -50,16 +58,39 @@ namespace revng {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const override;
     virtual void print(raw_ostream &OS, const Module *M) const override;
 	  void printFunctionInfo(Function &F) const;
+	  static void printFunctionInfo(Function &F, const LoopDependenciesPass &LDP);
+	  static void printFunctionInfo(Function &F, bool isSafe, unsigned int numRiskyStores);
     virtual bool doInitialization(Module &) override;
     virtual bool doFinalization(Module &) override;
     bool updateJSON(Function* F);
+    /// JSON record of \p F, built from the results of the three analyses
+    static json::Value buildFunctionRecord(Function &F, RevngFunctionParamsPass &RFP, FunctionParamsUsagePass &FPU, const LoopDependenciesPass &LDP);
+    /// JSON record of \p F, built from results replayed from the cache
+    static json::Value buildFunctionRecord(Function &F, RevngFunctionParamsPass &RFP, const FunctionSecurityResult &result);
+    /// Binary record of \p F, built from the live analyses
+    static FunctionFindings buildFunctionFindings(Function &F, const LoopDependenciesPass &LDP);
+    /// Binary record of \p F, built from results replayed from the cache
+    static FunctionFindings buildFunctionFindings(Function &F, const FunctionSecurityResult &result);
+    /// Write what is left of \p writer, logging failures
+    static void closeBinaryWriter(BinaryResultWriter &writer);
+    /// Append the per-stage profile and the enabled LLVM statistics to
+    /// \p writer
+    static void writeStatistics(JSONResultWriter &writer);
 
   private:
+    bool runWithCache(Function &F);
+
     LoopDependenciesPass *LDP = nullptr;
     FunctionParamsUsagePass *FPU = nullptr;
     RevngFunctionParamsPass *RFP = nullptr;
     // BackwardPropagationPass *BPP = nullptr;
     const RevngFunction *currentRF;
+    std::unique_ptr<JSONResultWriter> resultWriter; // only with -dump-result
+    std::unique_ptr<BinaryResultWriter> binaryWriter; // only with -dump-result-binary
+    // only with -security-cache-dir, the analyses then run on misses only
+    std::unique_ptr<FunctionResultCache> resultCache;
+    std::unique_ptr<FunctionParamsUsagePass> cacheFPU;
+    std::unique_ptr<LoopDependenciesPass> cacheLDP;
  };
 
 
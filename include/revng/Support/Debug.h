@@ -39,10 +39,14 @@ struct LogTerminator {
 ///
 /// The typical usage of this class is to be a static global variable in a
 /// translation unit.
+///
+/// Loggers are not thread-safe: the line being built is shared by all the
+/// threads. The indentation level is per-thread, but an analysis running on
+/// several threads should still go sequential when any logger is enabled.
 template<bool StaticEnabled = true>
 class Logger {
 private:
-  static unsigned IndentLevel;
+  static thread_local unsigned IndentLevel;
 
 public:
   Logger(llvm::StringRef Name) : Name(Name), Enabled(false) { init(); }
@@ -162,6 +166,13 @@ public:
 
   size_t size() const { return Loggers.size(); }
 
+  bool anyEnabled() const {
+    for (Logger<true> *L : Loggers)
+      if (L->isEnabled())
+        return true;
+    return false;
+  }
+
   void enable(llvm::StringRef Name) {
     for (Logger<true> *L : Loggers) {
       if (L->name() == Name) {
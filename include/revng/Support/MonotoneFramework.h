@@ -6,12 +6,15 @@
 //
 
 // Standard includes
+#include <algorithm>
 #include <map>
 #include <set>
 #include <type_traits>
 #include <vector>
 
 // LLVM includes
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallVector.h"
@@ -60,6 +63,16 @@ public:
   size_t size() const { return Queue.size(); }
 };
 
+/// \brief Collect the nodes reachable from \p Entry in reverse post order
+template<typename Iterated>
+inline std::vector<Iterated> buildRPOT(Iterated Entry) {
+  std::vector<Iterated> RPOT;
+  for (Iterated I : llvm::ReversePostOrderTraversal<Iterated>(Entry))
+    RPOT.push_back(I);
+
+  return RPOT;
+}
+
 template<VisitType V>
 using enable_if_post_order = std::enable_if<V == PostOrder
                                             or V == ReversePostOrder>;
@@ -117,7 +130,7 @@ public:
   }
 
   MonotoneFrameworkWorkList(Iterated Entry) :
-    MonotoneFrameworkWorkList(buildRPOT(Entry)) {}
+    MonotoneFrameworkWorkList(buildRPOT<Iterated>(Entry)) {}
 
   size_t size() const {
     revng_assert(verify());
@@ -179,16 +192,6 @@ public:
     return PostOrderList[OldNext].entry();
   }
 
-private:
-  static std::vector<Iterated> buildRPOT(Iterated Entry) {
-    // Populate PostOrderList
-    std::vector<Iterated> RPOT;
-    for (Iterated I : llvm::ReversePostOrderTraversal<Iterated>(Entry))
-      RPOT.push_back(I);
-
-    return RPOT;
-  }
-
 private:
   void initialize() {
     // Reverse the list in case we don't want the reverse post order
@@ -226,6 +229,93 @@ private:
   }
 };
 
+/// \brief Work list for the monotone framework over a graph whose labels are
+///        numbered, once and for all, in (reverse) post order
+///
+/// Each label is identified by its index in the order of visit, which can also
+/// be used to index the state of the analysis. Pending labels are tracked in a
+/// bit vector, and the next one to visit is the one with the lowest index.
+template<typename Iterated, VisitType Visit>
+class IndexedMonotoneFrameworkWorkList {
+  static_assert(Visit == PostOrder or Visit == ReversePostOrder,
+                "Labels can be numbered only in (reverse) post order");
+
+private:
+  /// List of all labels in the appropriate order
+  std::vector<Iterated> Labels;
+
+  /// Map from a label to its index in Labels
+  llvm::DenseMap<Iterated, unsigned> Indices;
+
+  /// Set of the indices of the labels to visit
+  llvm::BitVector Pending;
+
+public:
+  IndexedMonotoneFrameworkWorkList(const std::vector<Iterated> &RPOT) :
+    Labels(RPOT.begin(), RPOT.end()) {
+    initialize();
+  }
+
+  IndexedMonotoneFrameworkWorkList(
+    const llvm::SmallVectorImpl<Iterated> &RPOT) :
+    Labels(RPOT.begin(), RPOT.end()) {
+    initialize();
+  }
+
+  IndexedMonotoneFrameworkWorkList(Iterated Entry) :
+    IndexedMonotoneFrameworkWorkList(buildRPOT<Iterated>(Entry)) {}
+
+  size_t size() const { return Pending.count(); }
+
+  void clear() { Pending.reset(); }
+
+  void insert(Iterated Entry) {
+    llvm::Optional<unsigned> Index = index(Entry);
+    revng_assert(Index);
+    Pending.set(*Index);
+  }
+
+  bool empty() const { return Pending.none(); }
+
+  Iterated head() const {
+    revng_assert(not empty());
+    return Labels[Pending.find_first()];
+  }
+
+  Iterated pop() {
+    revng_assert(not empty());
+    unsigned Next = Pending.find_first();
+    Pending.reset(Next);
+    return Labels[Next];
+  }
+
+  /// \brief Number of labels in the graph
+  size_t labelsCount() const { return Labels.size(); }
+
+  /// \brief Index of \p Entry in the order of visit, None if \p Entry is not
+  ///        part of the graph
+  llvm::Optional<unsigned> index(Iterated Entry) const {
+    auto It = Indices.find(Entry);
+    if (It == Indices.end())
+      return llvm::None;
+    return It->second;
+  }
+
+private:
+  void initialize() {
+    // Reverse the list in case we don't want the reverse post order
+    if (Visit == PostOrder)
+      std::reverse(Labels.begin(), Labels.end());
+
+    Indices.reserve(Labels.size());
+    for (unsigned I = 0; I < Labels.size(); I++)
+      Indices[Labels[I]] = I;
+
+    // Initially all the labels are pending, as in MonotoneFrameworkWorkList
+    Pending.resize(Labels.size(), true);
+  }
+};
+
 /// \brief CRTP base class for an element of the lattice
 ///
 /// \note This class is more for reference. It's unused.
@@ -351,6 +441,10 @@ struct InterruptCreator<D, LatticeElement, DefaultInterrupt<LatticeElement>> {
 /// \tparam D the derived class.
 /// \tparam SuccessorsRange the return type of D::successors.
 /// \tparam Visit type of visit to perform.
+/// \tparam Indexed whether to number the labels in the order of visit before
+///         starting, and keep the state in a vector indexed by such number
+///         instead of a map. Requires a (reverse) post order visit. Derived
+///         classes should access the state through getState.
 // TODO: static_assert features of these classes (Interrupt in particular)
 template<typename D,
          typename Label,
@@ -358,10 +452,24 @@ template<typename D,
          VisitType Visit,
          typename SuccessorsRange,
          typename Interrupt = DefaultInterrupt<LatticeElement>,
-         bool DynamicGraph = false>
+         bool DynamicGraph = false,
+         bool Indexed = false>
 class MonotoneFramework {
   static_assert(DynamicGraph ? Visit == BreadthFirst : true,
                 "Cannot compute (reverse) post order for dynamic graphs");
+  static_assert(Indexed ? Visit != BreadthFirst : true,
+                "Labels can be numbered only in (reverse) post order");
+
+private:
+  using WorkListType = std::conditional_t<
+    Indexed,
+    IndexedMonotoneFrameworkWorkList<Label, Visit>,
+    MonotoneFrameworkWorkList<Label, Visit>>;
+
+  using StateType = std::conditional_t<
+    Indexed,
+    std::vector<llvm::Optional<LatticeElement>>,
+    std::map<Label, LatticeElement>>;
 
 protected:
   /// Lattice element where the results on return points of the function are
@@ -375,10 +483,12 @@ protected:
   /// \note Unused if DynamicGraph == true
   bool FirstFinalResult;
 
-  MonotoneFrameworkWorkList<Label, Visit> WorkList;
+  WorkListType WorkList;
 
   /// State of the monotone framework, maps a label to a lattice element
-  std::map<Label, LatticeElement> State;
+  ///
+  /// \note If Indexed, this is indexed by WorkList.index(Label)
+  StateType State;
 
   /// List of basic blocks we want to be sure to visit again before the end of
   /// the analysis
@@ -510,9 +620,28 @@ public:
     WorkList.clear();
     ToVisit.clear();
 
+    // Not resize: lattice elements might not be copyable
+    if constexpr (Indexed)
+      State = StateType(WorkList.labelsCount());
+
     for (Label ExtremalLabel : Extremals) {
       WorkList.insert(ExtremalLabel);
-      insert_or_assign(State, ExtremalLabel, extremalValue(ExtremalLabel));
+      setState(ExtremalLabel, extremalValue(ExtremalLabel));
+    }
+  }
+
+  /// \brief Return the lattice element associated to \p L, nullptr if \p L
+  ///        has not been reached yet or is not part of the graph
+  LatticeElement *getState(Label L) {
+    if constexpr (Indexed) {
+      llvm::Optional<unsigned> Index = WorkList.index(L);
+      if (not Index)
+        return nullptr;
+      llvm::Optional<LatticeElement> &Element = State[*Index];
+      return Element.hasValue() ? Element.getPointer() : nullptr;
+    } else {
+      auto It = State.find(L);
+      return It == State.end() ? nullptr : &It->second;
     }
   }
 
@@ -525,14 +654,25 @@ public:
   /// This function is required when you want to visit a basic block only if
   /// it's part of the current function, or fail otherwise.
   void registerToVisit(Label L) {
-    if (State.count(L) == 0)
+    if (getState(L) == nullptr)
       ToVisit.insert(L);
     else
       WorkList.insert(L);
   }
 
   /// \brief Number of label analyzed so far
-  size_t size() const { return State.size(); }
+  size_t size() const {
+    if constexpr (Indexed) {
+      using OptionalElement = llvm::Optional<LatticeElement>;
+      return std::count_if(State.begin(),
+                           State.end(),
+                           [](const OptionalElement &Element) {
+                             return Element.hasValue();
+                           });
+    } else {
+      return State.size();
+    }
+  }
 
   /// \brief Register a new extremal label
   void registerExtremal(Label L) { Extremals.insert(L); }
@@ -609,29 +749,29 @@ public:
         if (DynamicGraph)
           NewSuccessors.push_back(Successor);
 
-        auto It = State.find(Successor);
-        if (It == State.end()) {
+        LatticeElement *SuccessorState = getState(Successor);
+        if (SuccessorState == nullptr) {
           // We have never seen this Label, register it in the analysis state
 
           // If this is the only successor or we got a new element we can use
           // move semantics, otherwise create a copy
           if (SuccessorsCount == 1 or GotNewElement)
-            insert_or_assign(State, Successor, std::move(ActualElement));
+            setState(Successor, std::move(ActualElement));
           else
-            insert_or_assign(State, Successor, ActualElement.copy());
+            setState(Successor, ActualElement.copy());
 
           // Enqueue the successor
           WorkList.insert(Successor);
 
-        } else if (not ActualElement.lowerThanOrEqual(It->second)) {
+        } else if (not ActualElement.lowerThanOrEqual(*SuccessorState)) {
           // We have already seen this Label but the result of the transfer
           // function is larger than its previous initial state
 
           // Update the state merging ActualElement
-          It->second.combine(ActualElement);
+          SuccessorState->combine(ActualElement);
 
           // Assert we're now actually lower than or equal
-          assertLowerThanOrEqual(ActualElement, It->second);
+          assertLowerThanOrEqual(ActualElement, *SuccessorState);
 
           // Re-enqueue
           WorkList.insert(Successor);
@@ -662,7 +802,7 @@ public:
     } else {
       // OK, we already have at least a return label
 
-      if (DynamicGraph) {
+      if constexpr (DynamicGraph) {
         // We have dynamic graph, we need to compute the set of labels reachable
         // from the extremal labels and therefore exclude from FinalResult
         // results obtained from return labels that are no longer reachable.
@@ -730,6 +870,17 @@ public:
       return createSummaryInterrupt();
     }
   }
+
+private:
+  void setState(Label L, LatticeElement &&Element) {
+    if constexpr (Indexed) {
+      llvm::Optional<unsigned> Index = WorkList.index(L);
+      revng_assert(Index);
+      State[*Index] = std::move(Element);
+    } else {
+      insert_or_assign(State, L, std::move(Element));
+    }
+  }
 };
 
 /// \brief Base class for lattices for MonotoneFrameworks built over a set of T
@@ -9,6 +9,7 @@
 #include <csignal>
 #include <cstdlib>
 #include <map>
+#include <mutex>
 #include <string>
 extern "C" {
 #include <strings.h>
@@ -16,6 +17,7 @@ extern "C" {
 #include <vector>
 
 // LLVM includes
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/ManagedStatic.h"
 
@@ -48,43 +50,85 @@ private:
   using Container = std::map<K, T>;
   Container Map;
   std::string Name;
+  /// Analyses may push from several threads, once per function at most
+  mutable std::mutex Lock;
 
 public:
   CounterMap(const llvm::Twine &Name) : Name(Name.str()) { init(); }
   virtual ~CounterMap() {}
 
-  void push(K Key) { Map[Key]++; }
-  void push(K Key, T Value) { Map[Key] += Value; }
-  void clear(K Key) { Map.erase(Key); }
-  void clear() { Map.clear(); }
+  void push(K Key) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Map[Key]++;
+  }
 
-  virtual void onQuit() { dump(); }
+  void push(K Key, T Value) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Map[Key] += Value;
+  }
 
-  template<typename O>
-  void dump(size_t Max, O &Output) {
-    if (not Name.empty())
-      Output << Name << ":\n";
+  void clear(K Key) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Map.erase(Key);
+  }
 
+  void clear() {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Map.clear();
+  }
+
+  virtual void onQuit() { dump(); }
+
+  /// \brief The \p Max entries with the largest counters, largest first
+  ///
+  /// Entries with the same counter are sorted by descending key.
+  std::vector<std::pair<K, T>> top(size_t Max) const {
     using Pair = std::pair<K, T>;
     std::vector<Pair> Sorted;
-    Sorted.reserve(Map.size());
-    std::copy(Map.begin(), Map.end(), std::back_inserter(Sorted));
+    {
+      std::lock_guard<std::mutex> Guard(Lock);
+      Sorted.reserve(Map.size());
+      std::copy(Map.begin(), Map.end(), std::back_inserter(Sorted));
+    }
 
     auto Compare = [](const Pair &A, const Pair &B) {
-      return A.second < B.second;
+      if (A.second != B.second)
+        return A.second > B.second;
+      return B.first < A.first;
     };
     std::sort(Sorted.begin(), Sorted.end(), Compare);
+    if (Sorted.size() > Max)
+      Sorted.resize(Max);
+    return Sorted;
+  }
+
+  T get(const K &Key) const {
+    std::lock_guard<std::mutex> Guard(Lock);
+    auto It = Map.find(Key);
+    return It == Map.end() ? T() : It->second;
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> Guard(Lock);
+    return Map.size();
+  }
+
+  template<typename O>
+  void dump(size_t Max, O &Output) {
+    if (not Name.empty())
+      Output << Name << ":\n";
+
+    using Pair = std::pair<K, T>;
+    std::vector<Pair> Sorted = top(Max);
 
     size_t MaxLength = 0;
     size_t MaxDigits = 0;
-    for (unsigned I = 0; I < std::min(Max, Sorted.size()); I++) {
-      Pair &P = Sorted[Sorted.size() - 1 - I];
+    for (Pair &P : Sorted) {
       MaxLength = std::max(MaxLength, P.first.size());
       MaxDigits = std::max(MaxDigits, digitsCount(P.second));
     }
 
-    for (unsigned I = 0; I < std::min(Max, Sorted.size()); I++) {
-      Pair &P = Sorted[Sorted.size() - 1 - I];
+    for (Pair &P : Sorted) {
       Output << "  " << P.first << ": ";
       Output << std::string(MaxLength - P.first.size(), ' ');
       Output << std::string(MaxDigits - digitsCount(P.second), ' ');
@@ -99,6 +143,8 @@ private:
   void init();
 };
 
+class ThreadStatistics;
+
 /// \brief Collect mean and variance about a certain event.
 ///
 /// To use this class, simply create a global variable, call push with the value
@@ -107,6 +153,9 @@ private:
 ///
 /// If a name is provided, the results will be registered for printing at
 /// program termination.
+///
+/// This class is not thread-safe: threads other than the main one have to push
+/// through a ThreadStatistics.
 class RunningStatistics : public OnQuitInteraface {
 public:
   RunningStatistics() : RunningStatistics(llvm::Twine(), false) {}
@@ -129,21 +178,30 @@ public:
   void clear() { N = 0; }
 
   /// \brief Record a new value
-  void push(double X) {
-    N++;
+  void push(double X);
+
+  /// \brief Record the values recorded by \p Other too
+  void merge(const RunningStatistics &Other) {
+    if (Other.N == 0)
+      return;
+
+    if (N == 0) {
+      N = Other.N;
+      OldM = NewM = Other.OldM;
+      OldS = NewS = Other.OldS;
+      return;
+    }
 
-    // See Knuth TAOCP vol 2, 3rd edition, page 232
-    if (N == 1) {
-      OldM = NewM = X;
-      OldS = 0.0;
-    } else {
-      NewM = OldM + (X - OldM) / N;
-      NewS = OldS + (X - OldM) * (X - NewM);
+    // See Chan, Golub and LeVeque, "Updating formulae and a pairwise algorithm
+    // for computing sample variances"
+    double Total = N + Other.N;
+    double Delta = Other.OldM - OldM;
+    NewM = OldM + Delta * Other.N / Total;
+    NewS = OldS + Other.OldS + Delta * Delta * N * Other.N / Total;
+    N += Other.N;
 
-      // Set up for next iteration
-      OldM = NewM;
-      OldS = NewS;
-    }
+    OldM = NewM;
+    OldS = NewS;
   }
 
   /// \return the total number of recorded values.
@@ -170,12 +228,73 @@ public:
 private:
   void init();
 
+  void record(double X) {
+    N++;
+
+    // See Knuth TAOCP vol 2, 3rd edition, page 232
+    if (N == 1) {
+      OldM = NewM = X;
+      OldS = 0.0;
+    } else {
+      NewM = OldM + (X - OldM) / N;
+      NewS = OldS + (X - OldM) * (X - NewM);
+
+      // Set up for next iteration
+      OldM = NewM;
+      OldS = NewS;
+    }
+  }
+
 private:
   std::string Name;
   int N;
   double OldM, NewM, OldS, NewS;
 };
 
+/// \brief Private copies of the RunningStatistics a worker thread pushes to
+///
+/// Within the scope of a ThreadStatistics::Scope, the pushes of the current
+/// thread to any RunningStatistics go to a copy owned by the ThreadStatistics,
+/// without synchronization. Once the thread is done (e.g., after join), call
+/// merge to fold the copies into the original statistics.
+class ThreadStatistics {
+public:
+  ThreadStatistics() = default;
+  ThreadStatistics(const ThreadStatistics &) = delete;
+  ThreadStatistics &operator=(const ThreadStatistics &) = delete;
+
+  /// \brief Redirect the pushes of the current thread to a ThreadStatistics
+  class Scope {
+  public:
+    Scope(ThreadStatistics &Target) : Previous(Current) { Current = &Target; }
+    ~Scope() { Current = Previous; }
+
+  private:
+    ThreadStatistics *Previous;
+  };
+
+  /// \brief Record the collected values in the original statistics, and
+  ///        forget them
+  void merge() {
+    for (auto &P : Copies)
+      P.first->merge(P.second);
+    Copies.clear();
+  }
+
+private:
+  friend class RunningStatistics;
+
+  static thread_local ThreadStatistics *Current;
+  llvm::DenseMap<RunningStatistics *, RunningStatistics> Copies;
+};
+
+inline void RunningStatistics::push(double X) {
+  if (ThreadStatistics::Current != nullptr)
+    ThreadStatistics::Current->Copies[this].record(X);
+  else
+    record(X);
+}
+
 // TODO: this is duplicated
 template<typename T, typename... Args>
 inline std::array<T, sizeof...(Args)> make_array(Args &&... args) {
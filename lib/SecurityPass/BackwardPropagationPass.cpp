@@ -20,57 +20,127 @@ BackwardPropagationPass::BackwardPropagationPass() : ModulePass(ID) {
 }
 
 void BackwardPropagationPass::getAnalysisUsage(AnalysisUsage &AU) const {
-	// AU.addRequired<MaxStepsPass>();
+	AU.addRequired<MaxStepsPass>();
 	AU.setPreservesAll();
 }
 
 
 bool BackwardPropagationPass::runOnModule(Module &M) {
-	unsigned int itCounter = 0;
-	unsigned int MaxSteps = MaxStepsPass::getMaxLength();
-	std::map<Function*, MarkedFunInfo> *newCallers;
-	do {
-		get_print_stream(3) << "\n\n\nPropagating to caller for the " << itCounter+1 << " time...\n";
-		printNextCallers();
-		newCallers = new std::map<Function*, MarkedFunInfo>();
-		for( auto KV : *nextCallers) {
-			Function* caller = std::get<0>(KV);
-			MarkedFunInfo &calledInfo = std::get<1>(KV);
-			// nextCallers.erase(caller);
-			if( caller == nullptr) {
-				continue;
-			}
-			get_print_stream(3) << "Analizing " << caller->getName() << " calling " << "<" << std::get<0>(calledInfo) << "," << std::get<1>(calledInfo) <<"," << std::get<2>(calledInfo) << ">...\n";
-			fScraper.analyze(caller);
-			const Value* inputValue = getInputValue(*caller, calledInfo);
-			if( inputValue == nullptr) {
-				get_print_stream(3) << "ERROR! Caller " << caller->getName() << " has no input value!!!\n";
+	MaxStepsPass &MSP = getAnalysis<MaxStepsPass>();
+	// Input flows from callees to callers: visit tainted functions bottom-up,
+	// following the SCC post-order of the call graph
+	auto schedule = [this, &MSP](Function* F) {
+		worklist.emplace(MSP.getSCCIndex(F), functionPositions.lookup(F));
+	};
+	for(auto &P : markedFunctions) {
+		if( std::get<0>(P) == nullptr) {
+			security_log(3, "ERROR! Null function in markedFunctions!!!\n");
+			continue;
+		}
+		schedule(std::get<0>(P));
+	}
+	printNextCallers();
+
+	// A function is tainted at most once, so each call edge is evaluated at
+	// most once and the worklist reaches a fixpoint without any depth cap
+	while(!worklist.empty()) {
+		Function* callee = moduleFunctions[worklist.begin()->second];
+		worklist.erase(worklist.begin());
+		MarkedFunInfo calledInfo = markedFunctions.at(callee);
+		for( Function* caller : findCallersInCG(callee) ) {
+			markCaller(caller, std::get<1>(calledInfo));
+			if( markedFunctions.count(caller) ) {
 				continue;
 			}
+			security_log(3, "Analizing " << caller->getName() << " calling " << "<" << std::get<0>(calledInfo) << "," << std::get<1>(calledInfo) <<"," << std::get<2>(calledInfo) << ">...\n");
 			int argIndex = 0;
 			std::string argName;
-			std::tie(std::ignore, argIndex, argName) =  isReturnedByFun(*caller, inputValue);
-			if(argIndex == -1) {
-				if (addMarkedFunction(caller, argIndex, argName, newCallers) ) {
-					auto callers = findCallersInCG(caller);
-					continue;
-				}
-			}
-			std::tie( std::ignore, argIndex, argName) = getReachedParamIndex(*caller,inputValue);
-			if( argIndex > 0 ) {
-				if (addMarkedFunction(caller, argIndex, argName, newCallers) ) {
-					continue;
+			std::tie(std::ignore, argIndex, argName) = propagateToCaller(*caller, calledInfo);
+			if( argIndex == -1 || argIndex > 0 ) {
+				if( addMarkedFunction(caller, argIndex, argName) ) {
+					schedule(caller);
 				}
+				continue;
 			}
-			get_print_stream(3) << "Function " << caller->getName() << " does not propagate the input\n";
+			security_log(3, "Function " << caller->getName() << " does not propagate the input\n");
 		}
-		delete nextCallers;
-		nextCallers = newCallers;
-		itCounter++;
-	} while(itCounter != MaxSteps && !nextCallers->empty());
+	}
 	return false;
 }
 
+MarkedFunInfo BackwardPropagationPass::propagateToCaller(Function &caller, MarkedFunInfo &calledInfo) {
+	MarkedFunInfo noPropagation { caller.getName().str(), 0, "" };
+	const Value* inputValue = getInputValue(caller, calledInfo);
+	if( inputValue == nullptr) {
+		security_log(3, "ERROR! Caller " << caller.getName() << " has no input value!!!\n");
+		return noPropagation;
+	}
+	MarkedFunInfo returned = isReturnedByFun(caller, inputValue);
+	if( std::get<1>(returned) == -1 ) {
+		return returned;
+	}
+	MarkedFunInfo reached = getReachedParamIndex(caller, inputValue);
+	if( std::get<1>(reached) > 0 ) {
+		return reached;
+	}
+	return noPropagation;
+}
+
+// Values from which a return instruction of F can be reached, walking the
+// operands backward from every return
+const TaintSummary& BackwardPropagationPass::getSummary(const Function &F) {
+	auto inserted = summaries.try_emplace(&F);
+	TaintSummary &summary = inserted.first->second;
+	if( !inserted.second ) {
+		return summary;
+	}
+	std::vector<const Instruction*> worklist;
+	for( const Instruction &I : instructions(F) ) {
+		if( isa<ReturnInst>(I) && summary.returning.insert(&I).second ) {
+			worklist.push_back(&I);
+		}
+	}
+	while( !worklist.empty() ) {
+		const Instruction *I = worklist.back();
+		worklist.pop_back();
+		for( const Value *operand : I->operands() ) {
+			if( !summary.returning.insert(operand).second ) {
+				continue;
+			}
+			// Def-use chains are followed through instructions only
+			if( const Instruction *operandI = dyn_cast<Instruction>(operand) ) {
+				worklist.push_back(operandI);
+			}
+		}
+	}
+	return summary;
+}
+
+// Values derived from argument \p argIndex (1-based) of F, walking the users
+// forward from the argument
+const ParamSummary& BackwardPropagationPass::getParamSummary(const Function &F, unsigned int argIndex) {
+	auto inserted = paramSummaries.try_emplace({ &F, argIndex });
+	ParamSummary &summary = inserted.first->second;
+	if( !inserted.second ) {
+		return summary;
+	}
+	const Argument *A = F.getArg(argIndex - 1);
+	std::vector<const Value*> worklist { A };
+	summary.derived.insert(A);
+	while( !worklist.empty() ) {
+		const Value *V = worklist.back();
+		worklist.pop_back();
+		for( const User *U : V->users() ) {
+			const Instruction *I = dyn_cast<Instruction>(U);
+			if( I == nullptr || I->getFunction() != &F || !summary.derived.insert(I).second ) {
+				continue;
+			}
+			worklist.push_back(I);
+		}
+	}
+	return summary;
+}
+
 void BackwardPropagationPass::print(raw_ostream &OS, const Module *M) const {
 
 
@@ -79,123 +149,141 @@ void BackwardPropagationPass::print(raw_ostream &OS, const Module *M) const {
 
 bool BackwardPropagationPass::doInitialization(Module &M) {
 	moduleCG = new CallGraph(M);
+	reverseCG.build(*moduleCG);
+	classifyFunctions(M);
 	parseInputFiles(M);
 	markInputFunctions(M);
-	nextCallers = new std::map<Function*, MarkedFunInfo>();
-	for(auto P : markedFunctions) {
-		Function *F = std::get<0>(P);
-		MarkedFunInfo &mfInfo = std::get<1>(P) ;
-		if( F == nullptr) {
-			get_print_stream(3) << "ERROR! Null function in markedFunctions inside do initialization!!!\n";
+	summaries.clear();
+	paramSummaries.clear();
+	worklist.clear();
+	DUReachability.reset(nullptr);
+	moduleFunctions.clear();
+	functionPositions.clear();
+	for (Function &F : M) {
+		functionPositions[&F] = moduleFunctions.size();
+		moduleFunctions.push_back(&F);
+	}
+	printMarkedFunctions();
+	return false;
+}
+
+// Call \p onRecord on the comma separated fields of each line of \p fileName,
+// reading the whole file at once. Returns false if the file cannot be read.
+static bool forEachCSVRecord(StringRef fileName, function_ref<void(ArrayRef<StringRef>)> onRecord) {
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(fileName);
+	if (!buffer) {
+		return false;
+	}
+	SmallVector<StringRef, 4> fields;
+	StringRef rest = (*buffer)->getBuffer();
+	while (!rest.empty()) {
+		StringRef line;
+		std::tie(line, rest) = rest.split('\n');
+		line = line.rtrim("\r");
+		if (line.empty()) {
 			continue;
 		}
-		auto callers = findCallersInCG(F);
-		for( Function* F: callers ) {
-			nextCallers->emplace(F, mfInfo);
-			markPassFunction(F, true);
-		}
+		fields.clear();
+		line.split(fields, ',');
+		onRecord(fields);
+	}
+	return true;
+}
 
+// Map the entry address of every isolated function, as recorded in its
+// revng.func.entry metadata, to the function
+static DenseMap<uint64_t, Function*> indexFunctionsByAddress(Module &M) {
+	DenseMap<uint64_t, Function*> index;
+	for (Function &F : M) {
+		if (uint64_t PC = getFunctionEntryAddress(F)) {
+			index.try_emplace(PC, &F);
+		}
 	}
-	printMarkedFunctions();
-	printNextCallers();
-	while( MaxStepsPass::getMaxLength == 0 ) {};  // Naive synchronization
-	return false;
+	return index;
 }
 
 void BackwardPropagationPass::parseInputFiles(Module &M) {
-	RelocationsMap relocationMappings;
-	std::error_code FileError;
-	get_print_stream(1) << "Reading input functions from file " << MarkedFunctionsInputFile.c_str() << "...\n";
-	std::ifstream namesFile (MarkedFunctionsInputFile.c_str());
-	std::string fileLine;
 	std::map<std::string, MarkedFunInfo> tempMap;
-	if(namesFile.is_open()) {
-		while( std::getline(namesFile, fileLine) ) {
-			std::vector<std::string> fields;
-			std::stringstream ss(fileLine);
-			std::array<char, 128> token;
-			while (ss.getline(&token[0], 128, ',')) {
-				fields.push_back(std::string(&token[0]));
-			}
-			std::string name(fields[0]);
-			int index = std::stoi(fields[1]);
-			std::string argName(fields[2]);
-
-			MarkedFunInfo newInfo(name, index, argName);
-			tempMap.emplace(name, newInfo);
-
+	security_log(1, "Reading input functions from file " << MarkedFunctionsInputFile.c_str() << "...\n");
+	forEachCSVRecord(MarkedFunctionsInputFile, [&](ArrayRef<StringRef> fields) {
+		int index;
+		if (fields.size() < 3 || fields[1].trim().getAsInteger(10, index)) {
+			security_log(2, "Skipping malformed input function record\n");
+			return;
 		}
-		namesFile.close();
-	}
+		std::string name(fields[0]);
+		tempMap.emplace(name, MarkedFunInfo(name, index, fields[2].str()));
+	});
 
 	// parse relocation mappings
-	get_print_stream(1) << "Reading relocations from file " << MarkedFunctionsInputFile.c_str() << "...\n";
-	std::ifstream relocsFile (RelocationsMappingsInputFile.c_str());
-	if(relocsFile.is_open()) {
-		while( std::getline(relocsFile, fileLine) ) {
-			std::vector<std::string> fields;
-			std::stringstream ss(fileLine);
-			std::array<char, 128> token;
-			while (ss.getline(&token[0], 128, ',')) {
-				fields.push_back(std::string(&token[0]));
-			}
-			std::string address(fields[0])  ;
-			// std::remove_if(address.begin(), address.end(), isspace);
-			address.erase(std::remove(address.begin(), address.end(), ' '), address.end());
-			std::string name(fields[1]);
-			relocationMappings.emplace(address,name);
+	RelocationsMap relocationMappings;
+	security_log(1, "Reading relocations from file " << RelocationsMappingsInputFile.c_str() << "...\n");
+	forEachCSVRecord(RelocationsMappingsInputFile, [&](ArrayRef<StringRef> fields) {
+		if (fields.size() < 2) {
+			security_log(2, "Skipping malformed relocation record\n");
+			return;
+		}
+		std::string address(fields[0]);
+		address.erase(std::remove(address.begin(), address.end(), ' '), address.end());
+		relocationMappings.emplace(address, fields[1].str());
+	});
+
+	// resolve each relocation once: relocated name -> module functions
+	DenseMap<uint64_t, Function*> functionsByAddress = indexFunctionsByAddress(M);
+	StringMap<SmallVector<Function*, 1>> relocatedFunctions;
+	for (auto &P : relocationMappings) {
+		const std::string &bb = std::get<0>(P);
+		const std::string &relName = std::get<1>(P);
+		security_log(2, "Analyzing relocation <" << bb << ", " << relName << ">... ");
+		if (Function *F = searchFunctionByAddress(functionsByAddress, bb)) {
+			security_log(2, "Found module function " << F->getName() << "!");
+			relocatedFunctions[relName].push_back(F);
 		}
-		relocsFile.close();
+		security_log(2, "\n");
 	}
 
 	// merge relocations and function names
-
-	for(auto P : tempMap) {
-		std::string fName = std::get<0>(P);
+	for (auto &P : tempMap) {
+		const std::string &fName = std::get<0>(P);
 		MarkedFunInfo &fInfo = std::get<1>(P);
-		if( M.getFunction(fName) != nullptr) {
-			markedFunctions.emplace(M.getFunction(fName), fInfo);
-		} else if (M.getFunction("bb." + fName) != nullptr ){
+		if (Function *F = M.getFunction(fName)) {
+			markedFunctions.emplace(F, fInfo);
+		} else if (Function *wrapped = M.getFunction("bb." + fName)) {
 			MarkedFunInfo wrappedfInfo { "bb." + fName, std::get<1>(fInfo), std::get<2>(fInfo) };
-			markedFunctions.emplace(M.getFunction("bb." + fName), wrappedfInfo);
+			markedFunctions.emplace(wrapped, wrappedfInfo);
 		} else {
-			get_print_stream(2) << "No module function found for " << fName << " or bb." << fName << "!\n";
-
+			security_log(2, "No module function found for " << fName << " or bb." << fName << "!\n");
 		}
-		get_print_stream(1) << "Searching plt for " << fName << "...\n";
-		for( auto P2 : relocationMappings) {
-
-
-			std::string bb = std::get<0>(P2);
-			std::string relName = std::get<1>(P2);
-
- 			get_print_stream(2) << "Analyzing relocation <" << bb << ", " << relName << ">... ";
-			Function *F = searchFunctionByAddress(M, bb);
-
-			if ( fName.compare(relName) == 0 && F != nullptr ) {
-
-				MarkedFunInfo &oldInfo = std::get<1>(P);
-				int argIndex = std::get<1>(oldInfo);
-
-				std::string argName = std::get<2>(oldInfo);
-
-				MarkedFunInfo newInfo {F->getName().str(), argIndex, argName} ;
-				get_print_stream(2) << "Found module function " << F->getName() <<"!";
-				auto ins_res = markedFunctions.emplace(F, newInfo);
-			}
-			get_print_stream(2) << "\n";
+		security_log(1, "Searching plt for " << fName << "...\n");
+		auto relocatedIt = relocatedFunctions.find(fName);
+		if (relocatedIt == relocatedFunctions.end()) {
+			continue;
+		}
+		for (Function *F : relocatedIt->second) {
+			MarkedFunInfo newInfo {F->getName().str(), std::get<1>(fInfo), std::get<2>(fInfo)};
+			markedFunctions.emplace(F, newInfo);
 		}
 	}
 }
 
-Function* BackwardPropagationPass::searchFunctionByAddress(Module &M, std::string address) {
-	Function *F = M.getFunction("bb.0x" + address);
-	if ( F != nullptr ) {
-		return F;
+// Relocation addresses are hex strings without prefix; PLT entries of
+// position independent binaries may be loaded with a 0x5000 prefix
+// prepended to the address
+Function* BackwardPropagationPass::searchFunctionByAddress(const DenseMap<uint64_t, Function*> &functionsByAddress, StringRef address) {
+	uint64_t value;
+	if (address.empty() || address.getAsInteger(16, value)) {
+		return nullptr;
+	}
+	auto it = functionsByAddress.find(value);
+	if (it != functionsByAddress.end()) {
+		return it->second;
 	}
-	F = M.getFunction("bb.0x5000" + address);
-	if ( F != nullptr ) {
-		return F;
+	if (address.size() <= 12) {
+		uint64_t rebased = (uint64_t(0x5000) << (4 * address.size())) | value;
+		it = functionsByAddress.find(rebased);
+		if (it != functionsByAddress.end()) {
+			return it->second;
+		}
 	}
 	return nullptr;
 }
@@ -205,7 +293,7 @@ void BackwardPropagationPass::markInputFunctions(Module &M) {
 	for(Function &F: M) {
 		std::string fName = F.getName().str();
 		if(markedFunctions.find(&F) != markedFunctions.end()) {
-			get_print_stream(3) << F.getName() << " is a marked function!\n";
+			security_log(3, F.getName() << " is a marked function!\n");
 			markInputFunction(&F);
 		}
 	}
@@ -215,28 +303,12 @@ void BackwardPropagationPass::markInputFunctions(Module &M) {
 
 std::vector<Function*> BackwardPropagationPass::findCallersInCG(Function *F) {
 	assert(this->moduleCG && "Null CG pointer, findCallersInCG cannot be performed!\n");
-	std::vector<Function*> res;
-	for(auto it= df_begin(moduleCG), it_end=df_end(moduleCG); it!=it_end; it++) {
-
-		Function *nodeF = it->getFunction();
-		if( nodeF == nullptr) {
-		        continue;
-		}
-		for(auto calledIt=it->begin(), called_end=it->end(); calledIt != called_end ; calledIt++) {
-			CallGraphNode *calledNode = calledIt->second;
-			Function* calledF = calledNode->getFunction();
-			if( calledF == nullptr) {
-				continue;
-			}
-			if( calledF == F ) {
-			        res.push_back(nodeF);
-			}
-		}
-	}
+	ArrayRef<Function*> callers = reverseCG.getCallers(F);
+	std::vector<Function*> res(callers.begin(), callers.end());
 	if (res.empty() ) {
-		get_print_stream(3) << "No callers for " << F->getName() << "\n";
+		security_log(3, "No callers for " << F->getName() << "\n");
 	} else {
-		get_print_stream(3) << "Found " << res.size() << " callers for " << F->getName() << "\n";
+		security_log(3, "Found " << res.size() << " callers for " << F->getName() << "\n");
 	}
 	return res;
 }
@@ -244,6 +316,7 @@ std::vector<Function*> BackwardPropagationPass::findCallersInCG(Function *F) {
 bool BackwardPropagationPass::doFinalization(Module &M) {
 	printMarkedFunctions();
 	printNextCallers();
+	flushSecurityLogs();
 	return false;
 }
 
@@ -257,26 +330,18 @@ MarkedFunInfo  BackwardPropagationPass::getReachedParamIndex(Function &F, const
 	if (V == nullptr) {
 		return nullResult;
 	}
-	std::deque<const Value*> nextValues;
-	nextValues.push_back(V);
-	do {
-		const User* currentUser = dyn_cast<User>(nextValues.front());
-		nextValues.pop_front();
-		if(currentUser == nullptr) {
-			continue;
-		}
-		int index = getArgIndex(F,dyn_cast<Value>(currentUser));
-		if( index > 0 )  {
-			MarkedFunInfo res { F.getName().str(), index, currentUser->getName().str()};
+	// the lowest-index argument whose forward summary contains V. The old
+	// backward walk returned the argument nearest to V instead: when V
+	// derives from several arguments the two can differ.
+	int index = 1;
+	for (Argument &A : F.args()) {
+		if (getParamSummary(F, index).derived.count(V)) {
+			security_log(3, "Found function "  << F.getName() << " argument!\n");
+			MarkedFunInfo res { F.getName().str(), index, A.getName().str()};
 			return res;
 		}
-		for( const Value* usedVal : currentUser->operand_values()) {
-
-			if(std::find(nextValues.begin(), nextValues.end(), usedVal) == nextValues.end() ) {
-				nextValues.push_back(usedVal);
-			}
-		}
-	} while(! nextValues.empty());
+		index++;
+	}
 	return nullResult;
 
 }
@@ -285,25 +350,20 @@ const Value* BackwardPropagationPass::searchForNamedParameter(Function &F, const
 	if (startPoint == nullptr) {
 		return nullptr;
 	}
-	std::deque<const Value*> nextValues;
-	nextValues.push_back(startPoint);
-	do {
-		const User* currentUser = dyn_cast<User>(nextValues.front());
-		nextValues.pop_front();
-		if(currentUser == nullptr) {
-			continue;
-		}
-		if( currentUser->getName().compare(name) == 0 ) {
-			return dyn_cast<Value>(currentUser);
-		}
-
-		for( const Value* usedVal : currentUser->operand_values()) {
-
-			if(std::find(nextValues.begin(), nextValues.end(), usedVal) == nextValues.end() ) {
-				nextValues.push_back(usedVal);
-			}
+	// Names are unique in a function, and among globals: at most two
+	// candidates, checked against the def-use graph
+	const Value *candidates[] = { nullptr, F.getParent()->getNamedValue(name) };
+	if (ValueSymbolTable *symTable = F.getValueSymbolTable()) {
+		candidates[0] = symTable->lookup(name);
+	}
+	if (DUReachability.getFunction() != &F) {
+		DUReachability.reset(&F);
+	}
+	for (const Value *candidate : candidates) {
+		if (candidate != nullptr && isa<User>(candidate) && DUReachability.reaches(candidate, startPoint)) {
+			return candidate;
 		}
-	} while(! nextValues.empty());
+	}
 	return nullptr;
 
 }
@@ -313,36 +373,10 @@ MarkedFunInfo BackwardPropagationPass::isReturnedByFun(Function &F, const Value*
 	if(V == nullptr) {
 		return nullResult;
 	}
-	std::deque<const Value*> nextValues;
-	nextValues.push_back(V);
-	do {
-		const Value* currentVal = nextValues.front();
-		nextValues.pop_front();
-		if (currentVal == nullptr) {
-			continue;
-		}
-		if ( isa<ReturnInst>(currentVal) ) {
-			MarkedFunInfo res { F.getName().str(), -1, "rax" };
-			return res;
-		}
-
-		for( const Use &U : currentVal->uses()) {
-			if(U.getUser() == nullptr) {
-				continue;
-			}
-			const User* currentUser = U.getUser();
-			if( ! isa<Instruction>(currentUser) )
-				continue;
-			if( dyn_cast<Instruction>(currentUser)->getFunction() != &F) {
-				continue;
-			}
-			const Value* nextVal = dyn_cast<Value>(currentUser);
-			if(std::find(nextValues.begin(), nextValues.end(), nextVal) == nextValues.end() ) {
-				nextValues.push_back(nextVal);
-
-			}
-		}
-	} while( !nextValues.empty() );
+	if( getSummary(F).returning.count(V) ) {
+		MarkedFunInfo res { F.getName().str(), -1, "rax" };
+		return res;
+	}
 	return nullResult;
 }
 
@@ -409,7 +443,7 @@ int BackwardPropagationPass::getArgIndex(Function &F, const Value* V) {
 	int index = 1;
 	for( Argument &A: F.args()) {
 		if( V == dyn_cast<Value>(&A)) {
-			get_print_stream(3) << "Found function "  <<F.getName() << " argument!\n";
+			security_log(3, "Found function "  <<F.getName() << " argument!\n");
 			return index;
 		}
 		index++;
@@ -431,6 +465,7 @@ void BackwardPropagationPass::markInputFunction(Function* F) {
 	}
 	N = MDNode::get(C, MDString::get(C, "true"));
 	F->setMetadata(REVNG_INPUT_MD, N);
+	reclassifyFunction(*F);
 }
 
 
@@ -440,74 +475,73 @@ void BackwardPropagationPass::markPassFunction(Function* F, bool status) {
 	std::string formattedStatus =  formatv("{0}", status);
 	N = MDNode::get(C, MDString::get(C, formattedStatus));
 	F->setMetadata(REVNG_SECURITY_MARKED_MD, N);
+	reclassifyFunction(*F);
 	MarkedFunctions++;
 }
 
 const Value* BackwardPropagationPass::getInputValue(Function &F, MarkedFunInfo &mfInfo) {
 	std::string markedName = std::get<0>(mfInfo);
 	int argIndex = std::get<1>(mfInfo);
-	for( BasicBlock &BB : F) {
-		for(const Instruction &I : BB) {
-			if( const CallInst *CI = dyn_cast<CallInst>(&I) ) {
-				const Function* calledF = CI->getCalledFunction();
-				if( calledF == nullptr)
-					continue;
-				if(calledF->getName().compare(markedName) != 0) {
-					continue;
+	const Function* markedF = F.getParent()->getFunction(markedName);
+	if( markedF == nullptr ) {
+		return nullptr;
+	}
+	// Call sites are indexed in instruction order, the first one wins
+	for( const Instruction *callSite : reverseCG.getCallSites(markedF, &F) ) {
+		if( const CallInst *CI = dyn_cast<CallInst>(callSite) ) {
+			const Instruction &I = *CI;
+			security_log(3, "Found call site for " << markedName << " in " << F.getName() << ", input value is : ");
+			if( argIndex > 0 ) {
+				const Value* res = nullptr;
+				if( argIndex >= CI->getNumArgOperands()) {
+					security_log(3, "WARNING! ");
+					security_log(3, *CI);
+					security_log(3, " has not argument number " << argIndex);
+				} else {
+					res = CI->getArgOperand(argIndex-1);
 				}
-				get_print_stream(3) << "Found call site for " << markedName << " in " << F.getName() << ", input value is : ";
-				if( argIndex > 0 ) {
-					const Value* res = nullptr;
-					if( argIndex >= CI->getNumArgOperands()) {
-						get_print_stream(3) << "WARNING! ";
-						CI->print(get_print_stream(3));
-						get_print_stream(3) << " has not argument number " << argIndex;
-					} else {
-						res = CI->getArgOperand(argIndex-1);
-					}
-					if( res != nullptr) {
-						res->print(get_print_stream(3));
-						get_print_stream(3) << "\n";
-						return res;
-
-					}
-					get_print_stream(3) << "WARNING! Argument " << argIndex << "for call to " << F.getName() << " is null, searching by name... ";
-					res = searchForNamedParameter(F,dyn_cast<Value>(&I),std::get<2>(mfInfo));
-					if( res != nullptr) {
-						res->print(get_print_stream(3));
-						get_print_stream(3) << "\n";
-						return res;
-					}
-					get_print_stream(3) << "ERROR! Argument was not found even with name " << std::get<2>(mfInfo) << "!!!\n";
+				if( res != nullptr) {
+					security_log(3, *res);
+					security_log(3, "\n");
 					return res;
-				} else {
-					const Value *res = nullptr;
-					FunctionType *fType = CI->getFunctionType();
-					if( fType == nullptr) {
-						return nullptr;
-					}
-					Type *resType = fType->getReturnType() ;
-					if(resType == nullptr) {
-						return nullptr;
-					}
-					if( resType->isVoidTy()) {
-						get_print_stream(3) << "WARNING! Actual return type for call " ;
-						CI->print(get_print_stream(3));
-						get_print_stream(3) << " is void, searching for return register... ";
-						res = searchForReturnRegister(F,dyn_cast<Value>(&I),std::get<2>(mfInfo));
-					} else {
-						res = dyn_cast<Value>(&I);
-					}
-					if( res == nullptr) {
-						get_print_stream(3) << "ERROR! Return value not found for call to " << F.getName() << "\n";
 
-					} else {
-						res->print(get_print_stream(3));
-						get_print_stream(3) << "\n";
-					}
+				}
+				security_log(3, "WARNING! Argument " << argIndex << "for call to " << F.getName() << " is null, searching by name... ");
+				res = searchForNamedParameter(F,dyn_cast<Value>(&I),std::get<2>(mfInfo));
+				if( res != nullptr) {
+					security_log(3, *res);
+					security_log(3, "\n");
 					return res;
+				}
+				security_log(3, "ERROR! Argument was not found even with name " << std::get<2>(mfInfo) << "!!!\n");
+				return res;
+			} else {
+				const Value *res = nullptr;
+				FunctionType *fType = CI->getFunctionType();
+				if( fType == nullptr) {
+					return nullptr;
+				}
+				Type *resType = fType->getReturnType() ;
+				if(resType == nullptr) {
+					return nullptr;
+				}
+				if( resType->isVoidTy()) {
+					security_log(3, "WARNING! Actual return type for call " );
+					security_log(3, *CI);
+					security_log(3, " is void, searching for return register... ");
+					res = searchForReturnRegister(F,dyn_cast<Value>(&I),std::get<2>(mfInfo));
+				} else {
+					res = dyn_cast<Value>(&I);
+				}
+				if( res == nullptr) {
+					security_log(3, "ERROR! Return value not found for call to " << F.getName() << "\n");
 
+				} else {
+					security_log(3, *res);
+					security_log(3, "\n");
 				}
+				return res;
+
 			}
 		}
 	}
@@ -515,57 +549,46 @@ const Value* BackwardPropagationPass::getInputValue(Function &F, MarkedFunInfo &
 }
 
 
-bool BackwardPropagationPass::addMarkedFunction(Function *markedF, int argIndex, std::string argName, std::map<Function*,MarkedFunInfo> *newCallers = nullptr) {
+bool BackwardPropagationPass::addMarkedFunction(Function *markedF, int argIndex, std::string argName) {
 	if( markedF == nullptr) {
-		get_print_stream(3) << "Not adding a nullptr function\n";
+		security_log(3, "Not adding a nullptr function\n");
 		return false;
 	}
-	get_print_stream(3) << markedF->getName() << " is a new markedFunctions with input argument " << argIndex << " with name " << argName << "...\n";
+	security_log(3, markedF->getName() << " is a new markedFunctions with input argument " << argIndex << " with name " << argName << "...\n");
 
 	std::string fName = markedF->getName().str();
 	MarkedFunInfo newInfo { fName,  argIndex, argName };
-	markedFunctions.emplace(markedF,  newInfo);
+	bool isNew = markedFunctions.emplace(markedF,  newInfo).second;
 	markInputFunction(markedF);
 	InputFunctions++;
-	if(newCallers != nullptr) {
-		auto callers = findCallersInCG(markedF);
-		for (Function* newCaller : callers) {
-			if( newCaller == nullptr) {
-				continue;
-			}
-			newCallers->emplace(newCaller, newInfo);
-			markPassFunction(newCaller, true);
-		}
-	}
-	return true;
+	return isNew;
 }
 
 // DEBUG ONLY
 void BackwardPropagationPass::printMarkedFunctions() {
 
 	// // debug
-	get_print_stream(3) << "Input marked functions: \n";
-	for(auto P : markedFunctions) {
-		MarkedFunInfo &info = std::get<1>(P);
-		get_print_stream(3) << "- " << std::get<0>(info) << " : argumentPos=" << std::get<1>(info) << ", argumentName=" << std::get<2>(info) << "\n";
+	security_log(3, "Input marked functions: \n");
+	// in module order, markedFunctions is keyed by pointer
+	for(Function *F : moduleFunctions) {
+		auto it = markedFunctions.find(F);
+		if( it == markedFunctions.end() ) {
+			continue;
+		}
+		MarkedFunInfo &info = it->second;
+		security_log(3, "- " << std::get<0>(info) << " : argumentPos=" << std::get<1>(info) << ", argumentName=" << std::get<2>(info) << "\n");
 	}
 }
 
 void BackwardPropagationPass::printNextCallers() {
-	if(nextCallers->empty()) {
-		get_print_stream(3) << "No callers!\n";
+	if(worklist.empty()) {
+		security_log(3, "No callers!\n");
 		return;
 	}
-	for(auto P : *nextCallers) {
-		Function* F = std::get<0>(P);
-		MarkedFunInfo &mfInfo = std::get<1>(P);
-		if (F == nullptr) {
-			get_print_stream(3) << "ERROR! Null function in nextCallers as key!!!\n";
-		} else {
-			get_print_stream(3) << "Function " << F->getName() << " calls marked function " << std::get<0>(mfInfo) << ", input value on " << std::get<2>(mfInfo) << "(CALL_POS = " << std::get<1>(mfInfo) << ")\n";
-
-		}
-
+	for(auto &P : worklist) {
+		Function* F = moduleFunctions[std::get<1>(P)];
+		MarkedFunInfo &mfInfo = markedFunctions.at(F);
+		security_log(3, "Callers of " << F->getName() << " receive input on " << std::get<2>(mfInfo) << "(CALL_POS = " << std::get<1>(mfInfo) << ")\n");
 	}
 }
 
@@ -578,18 +601,20 @@ bool FunctionScraper::analyze(const Function *F) {
 		return false;
 	}
 	currentF = F;
+	DUClosure.reset(F);
 	rgScraper.runOnFunction(*F);
 	currentRF = rgScraper.getRevngFunction();
 
-	get_print_stream(3) << "Scraping Function " << currentF->getName() << "...\n";
+	security_log(3, "Scraping Function " << currentF->getName() << "...\n");
 	currentStackVarsFlows.clear();
 	currentVarsFlows.clear();
 	currentRiskyStores.clear();
+	riskyStoreSet.clear();
 
 
 
 	if( !(currentRF->getFunctionName() == currentF->getName() && currentRF->getType() == RevngFunction::TYPE::ISOLATED)) {
-		get_print_stream(3) << "Function arguments not found for "<< currentF->getName() <<"!\n";
+		security_log(3, "Function arguments not found for "<< currentF->getName() <<"!\n");
 		return false;
 	}
 	analyzePromotedArgsUsage(currentRF, currentF);
@@ -602,13 +627,12 @@ bool FunctionScraper::analyze(const Function *F) {
 	// analyzes uses of stack painter
 	// analyzeStackArgsUsage(currentRF, &F);
 
-	findRiskyStores();
 	return false;
 }
 
 bool FunctionScraper::isaUserOfParameter(const User *UR, const Value *param) const {
 	if (UR == nullptr || param == nullptr) {
-		get_print_stream(3) << "Null pointer in isaUserOfParameter\n";
+		security_log(3, "Null pointer in isaUserOfParameter\n");
 		return false;
 	}
 	for(auto OP = UR->op_begin(); OP!=UR->op_end(); OP++) {
@@ -621,7 +645,7 @@ bool FunctionScraper::isaUserOfParameter(const User *UR, const Value *param) con
 
 bool FunctionScraper::isaUserOfParams(const User *UR) const {
 	if (UR == nullptr) {
-		get_print_stream(3) << "Null pointer in isaUserOfParameter\n";
+		security_log(3, "Null pointer in isaUserOfParameter\n");
 		return false;
 	}
 	bool result = false;
@@ -733,75 +757,15 @@ void FunctionScraper::print(raw_ostream &OS, const Module *M) const {
 
 
 std::vector<DefUseChain> FunctionScraper::getValueFlows(const Value* startValue) const {
-	std::vector<DefUseChain> result;
-	DefUseChain currentChain;
-	for(const User* U: startValue->users()) {
-		currentChain.clear();
-		if(const Instruction *I = dyn_cast<Instruction>(U)) {
-			if(I->getFunction() == currentF) {
-				DefUse newDefUse(&cast<User>(*I), startValue);
-				currentChain.push_back(newDefUse);
-				std::vector<DefUse> tempDefUse = traverseDefUseChain(&cast<Value>(*I)); // try to find new def-uses
-				for (auto DU : tempDefUse) {
-					currentChain.push_back(DU);
-				}
-				result.push_back(currentChain);
-			}
-		}
-	}
-	get_print_stream(3) << "Found " << result.size() << " flows for " << startValue->getName() << "\n";
+	std::vector<DefUseChain> result = DUClosure.getValueFlows(startValue);
+	security_log(3, "Found " << result.size() << " flows for " << startValue->getName() << "\n");
 	return result;
 }
 
 
 
 std::vector<DefUse> FunctionScraper::traverseDefUseChain(const Value *V) const  {
-	std::vector<DefUse> result;
-	if (V == nullptr || currentF == nullptr) {
-		get_print_stream(3) << "Null pointer in traverseDefUseChain\n";
-		return result;
-	}
-	std::queue<const Value *> nextValues;
-	nextValues.push(V);
-	const Value* currentValue;
-	bool cycleDetected=false;
-	while(!nextValues.empty()) {
-		currentValue = nextValues.front();
-		nextValues.pop();
-		for(const Use& use : currentValue->uses()) {
-			const User* U = use.getUser();
-			if (const Instruction *I = dyn_cast<Instruction>(U)) {
-				if (I->getFunction() == currentF) {
-					DefUse *newDefUse = nullptr;
-					if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
-						const Value* destVal = SI->getPointerOperand();
-						newDefUse = new DefUse(&cast<User>(*I), destVal);
-					} else {
-						newDefUse = new DefUse(&cast<User>(*I), currentValue);
-					}
-					// avoid having duplicates in chain
-					if(!isInChain(result, *newDefUse)) {
-						result.push_back(*newDefUse);
-						nextValues.push(&cast<Value>(*I));
-					}
-				}
-			}
-		}
-	}
-	return result;
-
-}
-
-bool FunctionScraper::isInChain(std::vector<DefUse> &chain, DefUse &V) const {
-	for(auto DU : chain) {
-		auto l_user = std::get<0>(DU);
-		auto r_user = std::get<0>(V);
-		auto l_value = std::get<1>(DU);
-		auto r_value = std::get<1>(V);
-		if (l_user == r_user && l_value == r_value)
-			return true;
-	}
-	return false;
+	return DUClosure.getClosure(V);
 }
 
 
@@ -824,42 +788,20 @@ void FunctionScraper::printValueRange(raw_ostream &OS, Value *V, const BasicBloc
 
 }
 
-void FunctionScraper::findRiskyStores() {
-	const Value* GV = nullptr;
-	for(VariableFlow VF: currentVarsFlows) {
-		GV = std::get<0>(VF);
-		for (auto DUChain : std::get<1>(VF)) {
-			for(auto DU : DUChain) {
-				const User* U = std::get<0>(DU);
-				if(isaRiskyStore(DU)) {
-					if(!(containsRiskyStore(currentRiskyStores, dyn_cast<StoreInst>(U)))) {
-						RiskyStore tempRiskyStore ( cast<Value>(GV), dyn_cast<StoreInst>(U) );
-
-						currentRiskyStores.push_back(tempRiskyStore);
-						TotalStores++;
-					}
+// Pick up the risky stores of a flow while it is recorded, so the chains
+// are walked only once
+void FunctionScraper::scanFlow(const Value *origin, const std::vector<DefUseChain> &chains) {
+	for (const DefUseChain &DUChain : chains) {
+		for (const DefUse &DU : DUChain) {
+			if (isaRiskyStore(DU)) {
+				const StoreInst *store = cast<StoreInst>(std::get<0>(DU));
+				if (riskyStoreSet.insert(store).second) {
+					currentRiskyStores.emplace_back(origin, store);
+					TotalStores++;
 				}
 			}
 		}
 	}
-
-	const Value* V = nullptr;
-	for(StackVarFlow SVF: currentStackVarsFlows) {
-		V = std::get<0>(SVF)->getValue();
-		for (auto DUChain : std::get<1>(SVF)) {
-			for(auto DU : DUChain) {
-				const User* U = std::get<0>(DU);
-				if(isaRiskyStore(DU)) {
-					if(!(containsRiskyStore(currentRiskyStores, dyn_cast<StoreInst>(U)))) {
-						RiskyStore tempRiskyStore (V, dyn_cast<StoreInst>(U) );
-						currentRiskyStores.push_back(tempRiskyStore);
-						TotalStores++;
-					}
-				}
-			}
-		}
-	}
-
 }
 
 bool FunctionScraper::isaRiskyStore(const DefUse &DU) const {
@@ -874,35 +816,25 @@ bool FunctionScraper::isaRiskyStore(const DefUse &DU) const {
 
 }
 
-bool FunctionScraper::containsRiskyStore(std::vector<RiskyStore>& vector, const StoreInst* store) const {
-	const StoreInst* currStore = nullptr;
-	for(auto RS : vector) {
-		currStore = std::get<1>(RS);
-		if(currStore == store)
-			return true;
-	}
-	return false;
-}
-
 void FunctionScraper::analyzeArgsUsage(const RevngFunction* currentRF, const Function *F) {
 
-	get_print_stream(3) << "Analyzing arguments for " << F->getName() << "\n";
+	security_log(3, "Analyzing arguments for " << F->getName() << "\n");
 	bool firstUsageFound = false;
 	for(const GlobalVariable *GV: currentRF->getArguments()) {
 		// Reinitialize
 		std::vector<DefUseChain> defUseChains = analyzeSingleArgUsage(F, GV);
-		VariableFlow vflow(GV, defUseChains);
-		currentVarsFlows.push_back(vflow);
+		scanFlow(GV, defUseChains);
+		currentVarsFlows.emplace_back(GV, std::move(defUseChains));
 		TotalVarChains++;
 	}
 }
 
 void FunctionScraper::analyzePromotedArgsUsage(const RevngFunction* currentRF, const Function *F) {
-	get_print_stream(3) << F->getName() << " has " << F->arg_size() << " promoted arguments\n";
+	security_log(3, F->getName() << " has " << F->arg_size() << " promoted arguments\n");
 	for( Function::const_arg_iterator A = F->arg_begin(), A_end = F->arg_end(); A != A_end ;  A++) {
 		std::vector<DefUseChain> defUseChains = analyzeSingleArgUsage(F, dyn_cast<Value>(A));
-		VariableFlow vflow(dyn_cast<Value>(A), defUseChains);
-		currentVarsFlows.push_back(vflow);
+		scanFlow(dyn_cast<Value>(A), defUseChains);
+		currentVarsFlows.emplace_back(dyn_cast<Value>(A), std::move(defUseChains));
 		TotalVarChains++;
 	}
 }
@@ -917,7 +849,7 @@ std::vector<DefUseChain> FunctionScraper::getSSAValueFlows(const Value* V) const
 		startValue =  symTable->lookup(initName);
 	}
 	if ( startValue != nullptr) {
-		get_print_stream(3) << "Found an inital memoryssa value for " << V->getName() << ": " << startValue->getName() << "\n";
+		security_log(3, "Found an inital memoryssa value for " << V->getName() << ": " << startValue->getName() << "\n");
 		return getValueFlows(startValue);
 	} else {
 		return nullResult;
@@ -940,11 +872,12 @@ void FunctionScraper::analyzeVSPUsage(const RevngFunction* currentRF, const Func
 
 	const GlobalVariable* stackPointer = currentRF->getStackPointer();
 	if (stackPointer == nullptr) {
-		get_print_stream(3) << "stack pointer variable not found\n";
+		security_log(3, "stack pointer variable not found\n");
 	}
 	else {
-		VariableFlow vflow(stackPointer, getValueFlows(dyn_cast<Value>(stackPointer)));
-		currentVarsFlows.push_back(vflow);
+		std::vector<DefUseChain> defUseChains = getValueFlows(stackPointer);
+		scanFlow(stackPointer, defUseChains);
+		currentVarsFlows.emplace_back(stackPointer, std::move(defUseChains));
 	}
 }
 
@@ -954,8 +887,9 @@ void FunctionScraper::analyzeStackArgsUsage(const RevngFunction* currentRF, cons
 	for(const VirtualStackParam *VSP: currentRF->getStackParams()) {
 		// Reinitialize variables
 		const Value* VSPval = VSP->getValue();
-		StackVarFlow svflow(VSP, getValueFlows(VSPval));
-		currentStackVarsFlows.push_back(svflow);
+		std::vector<DefUseChain> defUseChains = getValueFlows(VSPval);
+		scanFlow(VSPval, defUseChains);
+		currentStackVarsFlows.emplace_back(VSP, std::move(defUseChains));
 		TotalStackChains++;
 	}
 }
@@ -992,7 +926,7 @@ void RevngFunctionScraper::scanVirtualStack(std::vector<const VirtualStackParam*
 		const Value *virtVar = findVirtStackParam(U);
 		if( virtVar ) {
 			virtualStackParamIndex++;
-			res.push_back(new VirtualStackParam(virtVar, virtualStackParamIndex, 0));
+			res.push_back(stackParams.create(virtVar, virtualStackParamIndex, 0));
 		}
 	}
 }
@@ -1009,7 +943,7 @@ const Value* RevngFunctionScraper::findVirtStackParam(const User *U) {
 	}
        	const User* currentUser = nullptr;
 	while(!nextUsers.empty()) {
-		get_print_stream(3) << "Remaining users: " << nextUsers.size() << "\n";
+		security_log(3, "Remaining users: " << nextUsers.size() << "\n");
 		currentUser = nextUsers.front();
 		nextUsers.pop_front();
 		if (const Instruction* I = dyn_cast<Instruction>(currentUser)) {
@@ -1065,23 +999,20 @@ void RevngFunctionScraper::printMDTuple(raw_ostream &OS, MDTuple &tuple) {
 }
 
 bool RevngFunctionScraper::runOnFunction(const Function &F) {
-	get_print_stream(3) << "Starting RevngFunctionScraper on function" << F.getName() << "...\n";
+	security_log(3, "Starting RevngFunctionScraper on function" << F.getName() << "...\n");
 
   res.functionName = F.getName();
   res.functionArguments.clear();
   res.functionVirtStackParams.clear();
-  MDNode *funcMetadata = F.getMetadata("revng.func.entry");
-  get_print_stream(3) << "Analyzing " << F.getName() << "...\n";
-  if (funcMetadata == nullptr || F.isDeclaration()) {
-    get_print_stream(3) << F.getName() <<  " is not a revng isolated function\n";
-    res.type = RevngFunction::TYPE::NOT_ISOLATED;
-    return false;
-  }
-  if (!revngFunctionRegex.match(F.getName())) {
-	      get_print_stream(3) << F.getName() <<  " does not start with \"bb.\", maybe is a QEMU helper\n";
+  stackParams.reset();
+  security_log(3, "Analyzing " << F.getName() << "...\n");
+  FunctionClass FC = getFunctionClass(&F);
+  if (!FC.isolated) {
+    security_log(3, F.getName() <<  " is not a revng isolated function, or maybe is a QEMU helper\n");
     res.type = RevngFunction::TYPE::NOT_ISOLATED;
     return false;
   }
+  MDNode *funcMetadata = FC.entry;
   scrapedFun = &F;
   res.type = RevngFunction::TYPE::ISOLATED;
   const MDOperand *op_it = funcMetadata->op_begin(); // Metadata for name
@@ -1098,10 +1029,10 @@ bool RevngFunctionScraper::runOnFunction(const Function &F) {
 
     Metadata *meta = op_it->get(); // print metadata operand
     if( isa<MDString>(meta) ) {
-      get_print_stream(3) << "Metadata string ";
+      security_log(3, "Metadata string ");
     }
     else if (isa<ValueAsMetadata>(meta)){
-      get_print_stream(3) << "value as metadata";
+      security_log(3, "value as metadata");
       ValueAsMetadata* valueMD = dyn_cast<ValueAsMetadata>(meta);
     }
     else if (isa<MDTuple>(meta)) {
@@ -1116,18 +1047,18 @@ bool RevngFunctionScraper::runOnFunction(const Function &F) {
    }
 
   if(res.virtStackPointer){
-       get_print_stream(3) << "Scanning virtual stack for passed arguments \n";
+       security_log(3, "Scanning virtual stack for passed arguments \n");
        scanVirtualStack(res.functionVirtStackParams, res.virtStackPointer);
   }
 
   filterOutRevngVars();
-  get_print_stream(3) << "Function params found for " << scrapedFun->getName() << ": \n";
+  security_log(3, "Function params found for " << scrapedFun->getName() << ": \n");
   for (const GlobalVariable *GV: res.functionArguments) {
-   get_print_stream(3) << "- ";
-   GV->print(get_print_stream(3));
-   get_print_stream(3) << "\n";
+   security_log(3, "- ");
+   security_log(3, *GV);
+   security_log(3, "\n");
   }
-  get_print_stream(3) << "Function stack params found for " << scrapedFun->getName() << ": \n";
+  security_log(3, "Function stack params found for " << scrapedFun->getName() << ": \n");
   return false;
 }
 
@@ -1259,7 +1190,7 @@ void RevngFunctionScraper::filterOutRevngVars() {
 bool RevngFunctionScraper::isaRevngVar(const Value* V) {
   assert(V != nullptr && "Nullptr passed to isaRevngVar");
   StringRef name = V->getName();
-  get_print_stream(3) << "Variable name : " << name << "\n";
+  security_log(3, "Variable name : " << name << "\n");
   if(name.equals("ExceptionFlag")) {
     return true;
   }
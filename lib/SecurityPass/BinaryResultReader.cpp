@@ -0,0 +1,130 @@
+#include "revng/SecurityPass/BinaryResultFormat.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstring>
+
+using namespace llvm;
+using namespace revng;
+
+static Error malformed(const Twine &reason) {
+	return createStringError(std::make_error_code(std::errc::invalid_argument), "Malformed security results: " + reason);
+}
+
+// table of count records of T at offset, checked against the buffer
+template<typename T>
+static Error getTable(StringRef data, uint64_t offset, uint64_t count, ArrayRef<T> &table, const char *name) {
+	if (offset % alignof(uint64_t) != 0 || offset > data.size() || count > (data.size() - offset) / sizeof(T)) {
+		return malformed(Twine(name) + " table out of bounds");
+	}
+	table = makeArrayRef(reinterpret_cast<const T*>(data.data() + offset), count);
+	return Error::success();
+}
+
+Expected<std::unique_ptr<BinaryResultReader>> BinaryResultReader::open(StringRef fileName) {
+	// large files are mapped, not read
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(fileName, -1, /* RequiresNullTerminator */ false);
+	if (!buffer) {
+		return errorCodeToError(buffer.getError());
+	}
+	return create(std::move(*buffer));
+}
+
+Expected<std::unique_ptr<BinaryResultReader>> BinaryResultReader::create(std::unique_ptr<MemoryBuffer> buffer) {
+	std::unique_ptr<BinaryResultReader> reader(new BinaryResultReader(std::move(buffer)));
+	if (Error error = reader->validate()) {
+		return error;
+	}
+	return reader;
+}
+
+Error BinaryResultReader::validate() {
+	StringRef data = buffer->getBuffer();
+	if (data.size() < sizeof(binary::Header)) {
+		return malformed("truncated header");
+	}
+	const binary::Header &header = *reinterpret_cast<const binary::Header*>(data.data());
+	if (std::memcmp(header.magic, binary::Magic, sizeof(binary::Magic)) != 0) {
+		return malformed("bad magic");
+	}
+	if (header.version != binary::Version) {
+		return malformed("unsupported version " + Twine(uint32_t(header.version)));
+	}
+	if (Error error = getTable(data, header.functionsOffset, header.numFunctions, functionTable, "function")) {
+		return error;
+	}
+	if (Error error = getTable(data, header.loopsOffset, header.numLoops, loopTable, "loop")) {
+		return error;
+	}
+	if (Error error = getTable(data, header.locationsOffset, header.numLocations, locationTable, "location")) {
+		return error;
+	}
+	if (header.stringsOffset > data.size() || header.stringsSize > data.size() - header.stringsOffset) {
+		return malformed("string table out of bounds");
+	}
+	strings = data.substr(header.stringsOffset, header.stringsSize);
+	// the writer always starts with the empty string
+	if (strings.empty() || strings.back() != '\0') {
+		return malformed("unterminated string table");
+	}
+
+	// check every reference once, so that accessors need no checks
+	for (const binary::FunctionRecord &function : functionTable) {
+		if (function.name >= strings.size()) {
+			return malformed("bad function name");
+		}
+		if (function.firstLoop > loopTable.size() || function.numLoops > loopTable.size() - function.firstLoop) {
+			return malformed("bad loop range");
+		}
+	}
+	for (const binary::LoopRecord &loop : loopTable) {
+		if (loop.name >= strings.size()) {
+			return malformed("bad loop name");
+		}
+		if (loop.firstBranch > locationTable.size() || loop.numBranches > locationTable.size() - loop.firstBranch
+		    || loop.firstStore > locationTable.size() || loop.numStores > locationTable.size() - loop.firstStore) {
+			return malformed("bad location range");
+		}
+	}
+	return Error::success();
+}
+
+StringRef BinaryResultReader::getString(uint32_t offset) const {
+	if (offset >= strings.size()) {
+		return StringRef();
+	}
+	// the table is NUL terminated, checked by validate()
+	return StringRef(strings.data() + offset);
+}
+
+static json::Value toJSON(ArrayRef<binary::LocationRecord> locations) {
+	json::Array result;
+	for (const binary::LocationRecord &location : locations) {
+		std::string address;
+		raw_string_ostream(address) << format_hex(uint64_t(location.address), 0);
+		result.push_back(json::Object{ { "address", address }, { "offset", int64_t(location.offset) } });
+	}
+	return json::Value(std::move(result));
+}
+
+json::Value BinaryResultReader::toJSON() const {
+	json::Object result;
+	for (const binary::FunctionRecord &function : functions()) {
+		json::Object loopsJSON;
+		for (const binary::LoopRecord &loop : loops(function)) {
+			// names are copied, the result outlives the mapped file
+			loopsJSON.try_emplace(getName(loop).str(), json::Object{
+				{ "candidateBranches", ::toJSON(branches(loop)) },
+				{ "riskyStores", ::toJSON(stores(loop)) } });
+		}
+		std::string entry;
+		raw_string_ostream(entry) << format_hex(uint64_t(function.entryAddress), 0);
+		json::Object functionJSON;
+		functionJSON.try_emplace("entryAddress", entry);
+		functionJSON.try_emplace("loopDependenciesAnalysis", json::Object{ { "vulnerableLoops", std::move(loopsJSON) } });
+		functionJSON.try_emplace("isMarked", (function.flags & binary::IsMarked) != 0);
+		functionJSON.try_emplace("isSafe", (function.flags & binary::IsSafe) != 0);
+		functionJSON.try_emplace("numRiskyStores", int64_t(function.numRiskyStores));
+		result.try_emplace(getName(function).str(), std::move(functionJSON));
+	}
+	return json::Value(std::move(result));
+}
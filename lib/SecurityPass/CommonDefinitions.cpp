@@ -1,7 +1,292 @@
 #include "revng/SecurityPass/CommonDefinitions.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IR/Constants.h"
+#include <sstream>
 
 
 using namespace llvm;
 using namespace revng;
 
+bool revng::only_marked_funs = false;
+bool revng::input_slice_only = false;
+
 static cl::opt<bool, true> OnlyMarkedFunctions("only-marked-funs", cl::desc("Analyze only functions reached by inputs"), cl::location(only_marked_funs));
+static cl::opt<bool, true> AnalyzeInputSlice("analyze-input-slice", cl::desc("Analyze only functions tagged by revng-input-slice as reachable from inputs"), cl::location(input_slice_only));
+
+thread_local raw_ostream* revng::threadPrintStream = nullptr;
+
+Logger<> revng::SecurityLog("security");
+Logger<> revng::SecurityVerboseLog("security-verbose");
+Logger<> revng::SecurityDebugLog("security-debug");
+
+namespace {
+
+	/// Output of all the security loggers, in the order it was written
+	///
+	/// Logger writes each message to dbg, which is unbuffered: complete
+	/// lines are kept here along with their logger and flush() formats them
+	/// all through their loggers, then hands them to dbg with a single write.
+	class SecurityLogSink {
+	public:
+		~SecurityLogSink() { flush(); }
+
+		void append(Logger<> &L, StringRef line) {
+			text.append(line.data(), line.size());
+			lines.emplace_back(&L, text.size());
+			if (text.size() >= flushThreshold) {
+				flush();
+			}
+		}
+
+		void flush() {
+			if (lines.empty()) {
+				return;
+			}
+
+			std::stringbuf formatted;
+			std::streambuf *original = dbg.rdbuf(&formatted);
+			size_t begin = 0;
+			for (auto &line : lines) {
+				*line.first << text.substr(begin, line.second - begin) << DoLog;
+				begin = line.second;
+			}
+			dbg.rdbuf(original);
+
+			text.clear();
+			lines.clear();
+			dbg << formatted.str();
+			dbg.flush();
+		}
+
+	private:
+		static const size_t flushThreshold = 64 * 1024;
+
+		std::string text;
+		// the logger of each line and where the line ends in text
+		std::vector<std::pair<Logger<>*, size_t>> lines;
+	};
+
+	SecurityLogSink SecurityLogOutput;
+
+	/// raw_ostream handing complete lines to a Logger through SecurityLogOutput
+	///
+	/// The security passes write partial lines and LLVM objects through
+	/// raw_ostream, Logger wants whole messages: text is accumulated until a
+	/// newline and each line becomes a log message.
+	class LoggerStream : public raw_ostream {
+	public:
+		// unbuffered: the lines are assembled in pending and buffered in
+		// the shared sink, which keeps the order among the levels
+		explicit LoggerStream(Logger<> &L) : L(L) { SetUnbuffered(); }
+		~LoggerStream() override {
+			flush();
+			if (!pending.empty()) {
+				SecurityLogOutput.append(L, pending);
+			}
+		}
+
+	private:
+		void write_impl(const char *ptr, size_t size) override {
+			written += size;
+			StringRef rest(ptr, size);
+			size_t newline;
+			while ((newline = rest.find('\n')) != StringRef::npos) {
+				pending.append(rest.data(), newline);
+				SecurityLogOutput.append(L, pending);
+				pending.clear();
+				rest = rest.drop_front(newline + 1);
+			}
+			pending.append(rest.data(), rest.size());
+		}
+
+		uint64_t current_pos() const override { return written; }
+
+		Logger<> &L;
+		std::string pending;
+		uint64_t written = 0;
+	};
+
+	LoggerStream SecurityLogStream(SecurityLog);
+	LoggerStream SecurityVerboseLogStream(SecurityVerboseLog);
+	LoggerStream SecurityDebugLogStream(SecurityDebugLog);
+
+	// Levels enabled through -debug-log are left alone, only the default
+	// level is turned off by -security-verbosity=0
+	void enableSecurityLogs(unsigned int verbosity) {
+		Logger<> *levels[] = { &SecurityLog, &SecurityVerboseLog, &SecurityDebugLog };
+		for (unsigned int i = 0; i < MAX_PASS_VERBOSITY_LEVEL && i < verbosity; i++) {
+			levels[i]->enable();
+		}
+		if (verbosity == 0) {
+			SecurityLog.disable();
+		}
+	}
+
+	/// -security-verbosity, enables the loggers up to the selected level
+	struct SecurityVerbosityOption : public cl::opt<unsigned int> {
+		using opt = cl::opt<unsigned int>;
+		SecurityVerbosityOption() :
+			opt("security-verbosity",
+			    cl::desc("Verbosity of the security passes output (0-3)"),
+			    cl::init(1)) {
+			enableSecurityLogs(1);
+		}
+
+		virtual bool addOccurrence(unsigned pos, StringRef ArgName, StringRef Value, bool MultiArg = false) override {
+			bool error = opt::addOccurrence(pos, ArgName, Value, MultiArg);
+			if (!error) {
+				enableSecurityLogs(getValue());
+			}
+			return error;
+		}
+	};
+
+	SecurityVerbosityOption SecurityVerbosity;
+
+}
+
+raw_ostream& revng::getSecurityLogStream(int verbosity) {
+	switch (verbosity) {
+	case 0:
+	case 1:
+		return SecurityLogStream;
+	case 2:
+		return SecurityVerboseLogStream;
+	default:
+		return SecurityDebugLogStream;
+	}
+}
+
+void revng::flushSecurityLogs() {
+	SecurityLogStream.flush();
+	SecurityVerboseLogStream.flush();
+	SecurityDebugLogStream.flush();
+	SecurityLogOutput.flush();
+}
+
+uint64_t revng::getFunctionEntryAddress(const Function &F) {
+	MDNode *entryMD = getFunctionClass(&F).entry;
+	if (entryMD == nullptr || entryMD->getNumOperands() < 2) {
+		return 0;
+	}
+	if (ConstantInt *PC = mdconst::dyn_extract_or_null<ConstantInt>(entryMD->getOperand(1))) {
+		return PC->getZExtValue();
+	}
+	return 0;
+}
+
+InstructionLocation revng::getInstructionLocation(const Instruction *I) {
+	InstructionLocation location;
+	SmallPtrSet<const BasicBlock*, 8> visited;
+	const Instruction *current = I;
+	while (current != nullptr) {
+		if (const CallInst *call = dyn_cast<CallInst>(current)) {
+			const Function *callee = call->getCalledFunction();
+			if (callee != nullptr && callee->getName() == "newpc" && call->getNumArgOperands() > 0) {
+				if (const ConstantInt *PC = dyn_cast<ConstantInt>(call->getArgOperand(0))) {
+					location.address = PC->getZExtValue();
+				}
+				return location;
+			}
+		}
+		const Instruction *previous = current->getPrevNode();
+		if (previous == nullptr) {
+			visited.insert(current->getParent());
+			const BasicBlock *predecessor = current->getParent()->getSinglePredecessor();
+			if (predecessor == nullptr || visited.count(predecessor) != 0) {
+				break;
+			}
+			previous = predecessor->getTerminator();
+		}
+		current = previous;
+		location.offset++;
+	}
+	return location;
+}
+
+namespace {
+
+	/// Metadata kinds of the classification, by ID
+	struct ClassificationKinds {
+		explicit ClassificationKinds(LLVMContext &C) :
+			entry(C.getMDKindID("revng.func.entry")),
+			input(C.getMDKindID(REVNG_INPUT_MD)),
+			marked(C.getMDKindID(REVNG_SECURITY_MARKED_MD)),
+			slice(C.getMDKindID(REVNG_SECURITY_SLICE_MD)) {}
+
+		unsigned int entry;
+		unsigned int input;
+		unsigned int marked;
+		unsigned int slice;
+	};
+
+	struct ClassificationTable {
+		const Module *M = nullptr;
+		Optional<ClassificationKinds> kinds;
+		DenseMap<const Function*, FunctionClass> classes;
+	};
+
+}
+
+static ClassificationTable FunctionClasses;
+
+// what the Regex "bb..*" of the passes matched: "bb" and one more character
+static bool hasRevngFunctionName(StringRef name) {
+	size_t position = name.find("bb");
+	return position != StringRef::npos && position + 2 < name.size();
+}
+
+static StringRef getMDStringOperand(const Function &F, unsigned int kind) {
+	if (MDNode *N = F.getMetadata(kind)) {
+		if (N->getNumOperands() > 0) {
+			if (MDString *S = dyn_cast_or_null<MDString>(N->getOperand(0).get())) {
+				return S->getString();
+			}
+		}
+	}
+	return StringRef();
+}
+
+static FunctionClass computeFunctionClass(const Function &F, const ClassificationKinds &kinds) {
+	FunctionClass FC;
+	StringRef name = F.getName();
+	FC.entry = F.getMetadata(kinds.entry);
+	FC.isolated = !F.isDeclaration() && FC.entry != nullptr && hasRevngFunctionName(name);
+	FC.skipped = !name.startswith("bb.") || name.startswith("bb.__") || name.startswith("bb.vasnprintf");
+	FC.hasInputMD = F.getMetadata(kinds.input) != nullptr;
+	FC.input = getMDStringOperand(F, kinds.input) == "true";
+	FC.marked = getMDStringOperand(F, kinds.marked) == "true";
+	FC.outsideSlice = getMDStringOperand(F, kinds.slice) == "false";
+	return FC;
+}
+
+void revng::classifyFunctions(const Module &M) {
+	FunctionClasses.M = &M;
+	FunctionClasses.kinds.emplace(M.getContext());
+	FunctionClasses.classes.clear();
+	FunctionClasses.classes.reserve(M.size());
+	for (const Function &F : M) {
+		FunctionClasses.classes[&F] = computeFunctionClass(F, *FunctionClasses.kinds);
+	}
+}
+
+void revng::reclassifyFunction(const Function &F) {
+	if (FunctionClasses.M != F.getParent()) {
+		return;
+	}
+	FunctionClasses.classes[&F] = computeFunctionClass(F, *FunctionClasses.kinds);
+}
+
+FunctionClass revng::getFunctionClass(const Function *F) {
+	assert(F != nullptr && "Passed a nullptr to getFunctionClass");
+	if (FunctionClasses.M == F->getParent()) {
+		auto it = FunctionClasses.classes.find(F);
+		if (it != FunctionClasses.classes.end()) {
+			return it->second;
+		}
+		return computeFunctionClass(*F, *FunctionClasses.kinds);
+	}
+	return computeFunctionClass(*F, ClassificationKinds(F->getContext()));
+}
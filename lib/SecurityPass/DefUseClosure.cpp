@@ -0,0 +1,70 @@
+#include "revng/SecurityPass/DefUseClosure.h"
+
+using namespace llvm;
+using namespace revng;
+
+void DefUseClosure::reset(const Function *F) {
+	currentF = F;
+	pool.clear();
+	closures.clear();
+	visited.clear();
+	worklist.clear();
+}
+
+const DefUseChain& DefUseClosure::getClosure(const Value *V) {
+	auto cached = closures.find(V);
+	if (cached != closures.end()) {
+		return *(cached->second);
+	}
+
+	pool.emplace_back();
+	DefUseChain &result = pool.back();
+	closures.try_emplace(V, &result);
+	if (V == nullptr || currentF == nullptr) {
+		security_log(3, "Null pointer in traverseDefUseChain\n");
+		return result;
+	}
+
+	// The worklist is a FIFO queue: values are appended and consumed in order,
+	// so it can be walked by index and reused across closures
+	visited.clear();
+	worklist.clear();
+	worklist.push_back(V);
+	for (size_t next = 0; next < worklist.size(); next++) {
+		const Value *currentValue = worklist[next];
+		for (const Use &use : currentValue->uses()) {
+			const Instruction *I = dyn_cast<Instruction>(use.getUser());
+			if (I == nullptr || I->getFunction() != currentF) {
+				continue;
+			}
+			const Value *usedVal = currentValue;
+			if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
+				usedVal = SI->getPointerOperand();
+			}
+			DefUse newDefUse(I, usedVal);
+			// avoid having duplicates in chain
+			if (visited.insert(newDefUse).second) {
+				result.push_back(newDefUse);
+				worklist.push_back(I);
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<DefUseChain> DefUseClosure::getValueFlows(const Value *startValue) {
+	std::vector<DefUseChain> result;
+	for (const User *U : startValue->users()) {
+		const Instruction *I = dyn_cast<Instruction>(U);
+		if (I == nullptr || I->getFunction() != currentF) {
+			continue;
+		}
+		const DefUseChain &closure = getClosure(I); // try to find new def-uses
+		result.emplace_back();
+		DefUseChain &currentChain = result.back();
+		currentChain.reserve(closure.size() + 1);
+		currentChain.push_back(DefUse(I, startValue));
+		currentChain.insert(currentChain.end(), closure.begin(), closure.end());
+	}
+	return result;
+}
@@ -0,0 +1,216 @@
+#include "revng/SecurityPass/DefUseReachability.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Instructions.h"
+
+using namespace llvm;
+using namespace revng;
+
+void DefUseReachability::reset(const Function *F) {
+	currentF = F;
+	built = false;
+	nodeIDs.clear();
+	nodes.clear();
+	edgeBegin.clear();
+	edgeTargets.clear();
+	nodeSCC.clear();
+	numSCCs = 0;
+	SCCEdgeBegin.clear();
+	SCCEdgeTargets.clear();
+	reachableSCCs.clear();
+}
+
+bool DefUseReachability::reaches(const Value *from, const Value *to) {
+	if (from == to) {
+		return true;
+	}
+	if (from == nullptr || to == nullptr || currentF == nullptr) {
+		return false;
+	}
+	if (!built) {
+		build();
+	}
+	auto fromIt = nodeIDs.find(from);
+	auto toIt = nodeIDs.find(to);
+	if (fromIt == nodeIDs.end() || toIt == nodeIDs.end()) {
+		return false;
+	}
+	unsigned int fromSCC = nodeSCC[fromIt->second];
+	unsigned int toSCC = nodeSCC[toIt->second];
+	if (fromSCC == toSCC) {
+		return true;
+	}
+	// Tarjan numbers a component after everything it reaches
+	if (fromSCC < toSCC) {
+		return false;
+	}
+	return getReachableSCCs(fromSCC).test(toSCC);
+}
+
+unsigned int DefUseReachability::addNode(const Value *V) {
+	auto it = nodeIDs.try_emplace(V, nodes.size());
+	if (it.second) {
+		nodes.push_back(V);
+	}
+	return it.first->second;
+}
+
+void DefUseReachability::build() {
+	built = true;
+	// collect (def, user) pairs, then lay them out by def
+	std::vector<std::pair<unsigned int, unsigned int>> edges;
+	for (const Argument &A : currentF->args()) {
+		addNode(&A);
+	}
+	for (const BasicBlock &BB : *currentF) {
+		for (const Instruction &I : BB) {
+			addNode(&I);
+		}
+	}
+	// instructions first, then the constants reached through them
+	for (unsigned int i = 0; i < nodes.size(); i++) {
+		const User *U = dyn_cast<User>(nodes[i]);
+		if (U == nullptr || isa<GlobalValue>(U)) {
+			continue;
+		}
+		if (isa<Constant>(U) && !isa<Instruction>(U) && U->getNumOperands() == 0) {
+			continue;
+		}
+		for (const Value *operand : U->operand_values()) {
+			if (isa<BasicBlock>(operand) || isa<MetadataAsValue>(operand) || isa<InlineAsm>(operand)) {
+				continue;
+			}
+			if (const Instruction *I = dyn_cast<Instruction>(operand)) {
+				if (I->getFunction() != currentF) {
+					continue;
+				}
+			}
+			edges.emplace_back(addNode(operand), i);
+		}
+	}
+
+	unsigned int numNodes = nodes.size();
+	edgeBegin.assign(numNodes + 1, 0);
+	for (auto &E : edges) {
+		edgeBegin[E.first + 1]++;
+	}
+	for (unsigned int i = 0; i < numNodes; i++) {
+		edgeBegin[i + 1] += edgeBegin[i];
+	}
+	edgeTargets.resize(edges.size());
+	std::vector<unsigned int> fill(edgeBegin.begin(), edgeBegin.end() - 1);
+	for (auto &E : edges) {
+		edgeTargets[fill[E.first]++] = E.second;
+	}
+	computeSCCs();
+}
+
+// Iterative Tarjan: components are numbered in reverse topological order,
+// so every edge of the condensed graph goes to a smaller number
+void DefUseReachability::computeSCCs() {
+	const unsigned int unvisited = ~0u;
+	unsigned int numNodes = nodes.size();
+	std::vector<unsigned int> index(numNodes, unvisited);
+	std::vector<unsigned int> lowLink(numNodes, 0);
+	std::vector<bool> onStack(numNodes, false);
+	std::vector<unsigned int> stack;
+	std::vector<std::pair<unsigned int, unsigned int>> frames; // node, next edge
+	nodeSCC.assign(numNodes, 0);
+	numSCCs = 0;
+	unsigned int nextIndex = 0;
+
+	for (unsigned int root = 0; root < numNodes; root++) {
+		if (index[root] != unvisited) {
+			continue;
+		}
+		frames.emplace_back(root, edgeBegin[root]);
+		index[root] = lowLink[root] = nextIndex++;
+		stack.push_back(root);
+		onStack[root] = true;
+		while (!frames.empty()) {
+			unsigned int node = frames.back().first;
+			unsigned int &next = frames.back().second;
+			if (next < edgeBegin[node + 1]) {
+				unsigned int target = edgeTargets[next++];
+				if (index[target] == unvisited) {
+					index[target] = lowLink[target] = nextIndex++;
+					stack.push_back(target);
+					onStack[target] = true;
+					frames.emplace_back(target, edgeBegin[target]);
+				} else if (onStack[target]) {
+					lowLink[node] = std::min(lowLink[node], index[target]);
+				}
+				continue;
+			}
+			frames.pop_back();
+			if (!frames.empty()) {
+				unsigned int parent = frames.back().first;
+				lowLink[parent] = std::min(lowLink[parent], lowLink[node]);
+			}
+			if (lowLink[node] != index[node]) {
+				continue;
+			}
+			unsigned int member;
+			do {
+				member = stack.back();
+				stack.pop_back();
+				onStack[member] = false;
+				nodeSCC[member] = numSCCs;
+			} while (member != node);
+			numSCCs++;
+		}
+	}
+
+	// condensed edges, same CSR layout
+	SCCEdgeBegin.assign(numSCCs + 1, 0);
+	for (unsigned int node = 0; node < numNodes; node++) {
+		for (unsigned int e = edgeBegin[node]; e < edgeBegin[node + 1]; e++) {
+			if (nodeSCC[node] != nodeSCC[edgeTargets[e]]) {
+				SCCEdgeBegin[nodeSCC[node] + 1]++;
+			}
+		}
+	}
+	for (unsigned int i = 0; i < numSCCs; i++) {
+		SCCEdgeBegin[i + 1] += SCCEdgeBegin[i];
+	}
+	SCCEdgeTargets.resize(SCCEdgeBegin[numSCCs]);
+	std::vector<unsigned int> fill(SCCEdgeBegin.begin(), SCCEdgeBegin.end() - 1);
+	for (unsigned int node = 0; node < numNodes; node++) {
+		for (unsigned int e = edgeBegin[node]; e < edgeBegin[node + 1]; e++) {
+			unsigned int from = nodeSCC[node];
+			unsigned int to = nodeSCC[edgeTargets[e]];
+			if (from != to) {
+				SCCEdgeTargets[fill[from]++] = to;
+			}
+		}
+	}
+}
+
+const BitVector& DefUseReachability::getReachableSCCs(unsigned int SCC) {
+	auto it = reachableSCCs.find(SCC);
+	if (it != reachableSCCs.end()) {
+		return it->second;
+	}
+	BitVector reachable(numSCCs);
+	std::vector<unsigned int> worklist;
+	reachable.set(SCC);
+	worklist.push_back(SCC);
+	while (!worklist.empty()) {
+		unsigned int current = worklist.back();
+		worklist.pop_back();
+		for (unsigned int e = SCCEdgeBegin[current]; e < SCCEdgeBegin[current + 1]; e++) {
+			unsigned int target = SCCEdgeTargets[e];
+			// already computed sets are merged instead of walked again
+			auto knownIt = reachableSCCs.find(target);
+			if (knownIt != reachableSCCs.end()) {
+				reachable |= knownIt->second;
+				continue;
+			}
+			if (!reachable.test(target)) {
+				reachable.set(target);
+				worklist.push_back(target);
+			}
+		}
+	}
+	return reachableSCCs.try_emplace(SCC, std::move(reachable)).first->second;
+}
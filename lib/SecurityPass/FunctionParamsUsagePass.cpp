@@ -15,6 +15,21 @@ static RegisterPass<FunctionParamsUsagePass> Y("revng-params-usage", "Analyze fu
 FunctionParamsUsagePass::FunctionParamsUsagePass() : FunctionPass(ID), currentVarsFlows(), currentStackVarsFlows() {
 }
 
+// by StatisticKind
+static Statistic *const FPUStatistics[] = { &FPUSkippedFunctions, &TotalStackChains, &TotalVarChains, &TotalStores };
+
+void FunctionParamsUsagePass::count(StatisticKind kind) {
+	++*FPUStatistics[kind];
+	statistics[kind]++;
+}
+
+void FunctionParamsUsagePass::addStatistics(ArrayRef<unsigned int> counts) {
+	assert(counts.size() == StatisticsCount && "Statistics of another pass");
+	for (unsigned int i = 0; i < StatisticsCount; i++) {
+		*FPUStatistics[i] += counts[i];
+	}
+}
+
 
 
 bool FunctionParamsUsagePass::doInitialization(Module &M) {
@@ -27,33 +42,57 @@ bool FunctionParamsUsagePass::doFinalization(Module &M) {
 }
 
 bool FunctionParamsUsagePass::runOnFunction(Function &F) {
-	get_print_stream(1) << "Starting FunctionParamsUsage pass on function " << F.getName() << "...\n";
+  SCEV = nullptr;
+  if (!analyze(F, getAnalysis<RevngFunctionParamsPass>().getRevngFunction())) {
+    return false;
+  }
+  if (printsValueRanges()) {
+    SCEV = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+  }
+  return false;
+}
+
+bool FunctionParamsUsagePass::printsValueRanges() {
+  return VerboseFPAnalysis;
+}
+
+bool FunctionParamsUsagePass::analyze(Function &F, const RevngFunction *RF) {
+	SecurityStageTimer timer(SecurityStage::FunctionParamsUsage, F);
+	security_log(1, "Starting FunctionParamsUsage pass on function " << F.getName() << "...\n");
 	currentF = &F;
+	DUClosure.reset(&F);
 
-  currentRF = getAnalysis<RevngFunctionParamsPass>().getRevngFunction();
+  currentRF = RF;
   currentStackVarsFlows.clear();
   currentVarsFlows.clear();
   currentRiskyStores.clear();
+  riskyStoresByBlock.clear();
+  riskyStoreSet.clear();
+  taintedValues.clear();
+  visitedStores = 0;
+  std::fill(std::begin(statistics), std::end(statistics), 0);
 
 
   if( !(currentRF->getFunctionName() == F.getName() && currentRF->getType() == RevngFunction::TYPE::ISOLATED)) {
-	  get_print_stream(1) << "Function arguments not found for "<< F.getName() <<"!\n";
+	  security_log(1, "Function arguments not found for "<< F.getName() <<"!\n");
     return false;
   }
   if( isaSkippedFunction(&F) ) {
-    FPUSkippedFunctions++;
-    get_print_stream(1) << "Not a function in the analysis scope, skipping FPU...\n";
+    count(SkippedFunctionsStat);
+    security_log(1, "Not a function in the analysis scope, skipping FPU...\n");
     return false;
   }
 
   if (!isMarked(&F) && only_marked_funs) {
-	  FPUSkippedFunctions++;
-	  get_print_stream(1) << "Function not rached by input, skipping FPU...\n";
+	  count(SkippedFunctionsStat);
+	  security_log(1, "Function not rached by input, skipping FPU...\n");
+	  return false;
+  }
+  if (isOutsideInputSlice(&F)) {
+	  count(SkippedFunctionsStat);
+	  security_log(1, "Function outside the input slice, skipping FPU...\n");
 	  return false;
   }
-
-  LVI = &getAnalysis<LazyValueInfoWrapperPass>().getLVI();
-  SCEV = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
 
   analyzePromotedArgsUsage(currentRF, &F);
 
@@ -64,20 +103,30 @@ bool FunctionParamsUsagePass::runOnFunction(Function &F) {
   // analyzes uses of stack painter
   // analyzeStackArgsUsage(currentRF, &F);
 
-  findRiskyStores();
-  return false;
+  indexRiskyStores();
+
+  for (const VariableFlow &VF : currentVarsFlows) {
+    timer.addDefUseChains(std::get<1>(VF).size());
+  }
+  for (const StackVarFlow &SVF : currentStackVarsFlows) {
+    timer.addDefUseChains(std::get<1>(SVF).size());
+  }
+  timer.addStoresVisited(visitedStores);
+  return true;
 }
 
 void FunctionParamsUsagePass::getAnalysisUsage(AnalysisUsage &AU) const {
-  AU.addRequired<LazyValueInfoWrapperPass>();
   AU.addRequired<RevngFunctionParamsPass>();
-  AU.addRequired<ScalarEvolutionWrapperPass>();
+  // SCEV is only used to print value ranges
+  if (printsValueRanges()) {
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+  }
   AU.setPreservesAll();
 }
 
 bool FunctionParamsUsagePass::isaUserOfParameter(const User *UR, const Value *param) const {
   if (UR == nullptr || param == nullptr) {
-    get_print_stream(1) << "Null pointer in isaUserOfParameter\n";
+    security_log(1, "Null pointer in isaUserOfParameter\n");
     return false;
   }
   for(auto OP = UR->op_begin(); OP!=UR->op_end(); OP++) {
@@ -90,38 +139,35 @@ bool FunctionParamsUsagePass::isaUserOfParameter(const User *UR, const Value *pa
 
 bool FunctionParamsUsagePass::isaUserOfParams(const User *UR) const {
   if (UR == nullptr) {
-    get_print_stream(1) << "Null pointer in isaUserOfParameter\n";
+    security_log(1, "Null pointer in isaUserOfParameter\n");
     return false;
   }
-  bool result = false;
-  for (auto VFlow : currentVarsFlows) {
-    const Value* GV = std::get<0>(VFlow);
-    auto VChains = std::get<1>(VFlow);
-    for(auto DUChain : VChains) {
-	for (auto DU : DUChain) {
-      const Instruction *user = cast<Instruction>(std::get<0>(DU));
-      const Value *use = std::get<1>(DU);
-      result =  result || isaUserOfParameter(UR, use);
-      if(result) {
-	return result;
-      }
-	}
-    }
+  for (const Value *OP : UR->operand_values()) {
+    if (isTainted(OP))
+      return true;
   }
+  return false;
+}
 
-  for (auto SVFlow : currentStackVarsFlows) {
-    const Value *stackVar = std::get<0>(SVFlow)->getValue();
-    auto SPChains  = std::get<1>(SVFlow);
-      for (auto SPChain : SPChains) {
-	for (auto DU : SPChain) {
-	  const Value *use = std::get<1>(DU);
-	  result =  result || isaUserOfParameter(UR, use);
-	  if (result)
-	    return result;
-	}
+// Every value used along a def-use chain of a parameter (or of a stack
+// parameter) derives from it: taint it, and pick up the risky stores, while
+// the flow is recorded, so the chains are walked only once
+void FunctionParamsUsagePass::scanFlow(const Value *origin, const std::vector<DefUseChain> &chains) {
+  for (const DefUseChain &DUChain : chains) {
+    for (const DefUse &DU : DUChain) {
+      taintedValues.insert(std::get<1>(DU));
+      const StoreInst *store = dyn_cast<StoreInst>(std::get<0>(DU));
+      if (store == nullptr) {
+        continue;
+      }
+      visitedStores++;
+      // the pointer is on the chain, hence tainted
+      if (isaRiskyStore(DU) && riskyStoreSet.insert(store).second) {
+        currentRiskyStores.emplace_back(origin, store);
+        count(StoresStat);
       }
+    }
   }
-  return result;
 }
 
 void FunctionParamsUsagePass::print(raw_ostream &OS, const Module *M) const {
@@ -204,82 +250,20 @@ void FunctionParamsUsagePass::print(raw_ostream &OS, const Module *M) const {
 
 
 std::vector<DefUseChain> FunctionParamsUsagePass::getValueFlows(const Value* startValue) const {
-	std::vector<DefUseChain> result;
-	DefUseChain currentChain;
-	for(const User* U: startValue->users()) {
-		currentChain.clear();
-		if(const Instruction *I = dyn_cast<Instruction>(U)) {
-			if(I->getFunction() == currentF) {
-				DefUse newDefUse(&cast<User>(*I), startValue);
-				currentChain.push_back(newDefUse);
-				std::vector<DefUse> tempDefUse = traverseDefUseChain(&cast<Value>(*I)); // try to find new def-uses
-				for (auto DU : tempDefUse) {
-					currentChain.push_back(DU);
-				}
-				result.push_back(currentChain);
-			}
-		}
-	}
-	get_print_stream(2) << "Found " << result.size() << " flows for " << startValue->getName() << "\n";
+	std::vector<DefUseChain> result = DUClosure.getValueFlows(startValue);
+	security_log(2, "Found " << result.size() << " flows for " << startValue->getName() << "\n");
 	return result;
 }
 
 
 
 std::vector<DefUse> FunctionParamsUsagePass::traverseDefUseChain(const Value *V) const  {
-  std::vector<DefUse> result;
-  if (V == nullptr || currentF == nullptr) {
-    get_print_stream(3) << "Null pointer in traverseDefUseChain\n";
-    return result;
-  }
-  std::queue<const Value *> nextValues;
-  nextValues.push(V);
-  const Value* currentValue;
-  bool cycleDetected=false;
-  while(!nextValues.empty()) {
-     currentValue = nextValues.front();
-     nextValues.pop();
-      for(const Use& use : currentValue->uses()) {
-	      const User* U = use.getUser();
-	      if (const Instruction *I = dyn_cast<Instruction>(U)) {
-		      if (I->getFunction() == currentF) {
-			      DefUse *newDefUse = nullptr;
-			      if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
-				      const Value* destVal = SI->getPointerOperand();
-				      newDefUse = new DefUse(&cast<User>(*I), destVal);
-			      } else {
-				      newDefUse = new DefUse(&cast<User>(*I), currentValue);
-			      }
-			      // avoid having duplicates in chain
-			      if(!isInChain(result, *newDefUse)) {
-				      result.push_back(*newDefUse);
-				      nextValues.push(&cast<Value>(*I));
-			      }
-		      }
-	      }
-      }
-  }
-  return result;
-
-}
-
-bool FunctionParamsUsagePass::isInChain(std::vector<DefUse> &chain, DefUse &V) const {
-	for(auto DU : chain) {
-		auto l_user = std::get<0>(DU);
-		auto r_user = std::get<0>(V);
-		auto l_value = std::get<1>(DU);
-		auto r_value = std::get<1>(V);
-		if (l_user == r_user && l_value == r_value)
-			return true;
-	}
-	return false;
+	return DUClosure.getClosure(V);
 }
 
 
 void FunctionParamsUsagePass::printOperandsRange(raw_ostream &OS, const Instruction *UR) const { // instruction is treated as a user, but we need its type to get back basic block
 	assert(UR != nullptr && "Nullptr passed t printOperandsRange");
-	assert(LVI != nullptr && "LVI analysis not obtained");
-	assert(SCEV != nullptr && "Scalar Evolution analysis not obtained");
 	for(auto OP = UR->op_begin(); OP!=UR->op_end(); OP++) {
 		Value *OPV = OP->get();
 		OS << "\t\tOperand " << OPV->getName() << ": ";
@@ -291,9 +275,8 @@ void FunctionParamsUsagePass::printOperandsRange(raw_ostream &OS, const Instruct
 
 void FunctionParamsUsagePass::printValueRange(raw_ostream &OS, Value *V, const BasicBlock* context) const { // instruction is treated as a user, but we need its type to get back basic block
 	assert(V != nullptr && "Nullptr passed t printValueRange");
-	assert(LVI != nullptr && "LVI analysis not obtained");
-	assert(SCEV != nullptr && "Scalar Evolution analysis not obtained");
-	if (SCEV->isSCEVable(V->getType())){
+	// SCEV is not available when the pass is not run by the pass manager
+	if (SCEV != nullptr && SCEV->isSCEVable(V->getType())){
 		auto SCEVexp = SCEV->getSCEV(V);
 		if(SCEVexp->getType()->isIntegerTy()) {
 			ConstantRange SCEVRange = SCEV->getUnsignedRange(SCEVexp);
@@ -337,15 +320,15 @@ json::Object FunctionParamsUsagePass::toJSON() {
 	json::Object fobj;
 	json::Object varsFlows;
 	unsigned int chainNum ;
-	get_print_stream(1) << "Dumping " << currentVarsFlows.size() << " variables flows to json...";
+	security_log(1, "Dumping " << currentVarsFlows.size() << " variables flows to json...");
 	for(auto VF : currentVarsFlows) {
 		chainNum = 1;
 		const Value* GVvar = std::get<0>(VF);
 		json::ObjectKey GVKey ( GVvar->getName());
 		json::Object GVobj;
-		get_print_stream(2) << "Converting a list of " << std::get<1>(VF).size() << " def-use chains for " << GVvar->getName() << " ...\n";
+		security_log(2, "Converting a list of " << std::get<1>(VF).size() << " def-use chains for " << GVvar->getName() << " ...\n");
 		for( auto DFC: std::get<1>(VF)) {
-			get_print_stream(3) << "Traversing a def-use chain of " << DFC.size() << " def-uses for " << GVvar->getName() << "...\n";
+			security_log(3, "Traversing a def-use chain of " << DFC.size() << " def-uses for " << GVvar->getName() << "...\n");
 			json::ObjectKey defChainsKey(formatv("chain{0}", chainNum));
 			json::Array defChainsVal;
 			for( auto DF : DFC) {
@@ -359,7 +342,7 @@ json::Object FunctionParamsUsagePass::toJSON() {
 		varsFlows.try_emplace(std::move(GVKey), std::move(GVobj));
 	}
 	fobj.try_emplace("variablesFlows", std::move(varsFlows));
-	get_print_stream(1) << "Dumping " << currentVarsFlows.size() << " stack variables flows to json...\n";
+	security_log(1, "Dumping " << currentVarsFlows.size() << " stack variables flows to json...\n");
 	json::Object stackVarsFlows;
 	for(auto SVF : currentStackVarsFlows) {
 		const VirtualStackParam* SVvar = std::get<0>(SVF);
@@ -378,69 +361,30 @@ json::Object FunctionParamsUsagePass::toJSON() {
 		}
 		stackVarsFlows.try_emplace(std::move(SVKey), std::move(SVobj));
 	}
-	get_print_stream(1) << "Done!\n";
+	security_log(1, "Done!\n");
 	fobj.try_emplace("stackVariablesFlows", std::move(stackVarsFlows));
 	return fobj;
 }
 
-void FunctionParamsUsagePass::findRiskyStores() {
-	const Value* GV = nullptr;
-	for(VariableFlow VF: currentVarsFlows) {
-		GV = std::get<0>(VF);
-		for (auto DUChain : std::get<1>(VF)) {
-			for(auto DU : DUChain) {
-				const User* U = std::get<0>(DU);
-				if(isaRiskyStore(DU)) {
-					if(!(containsRiskyStore(currentRiskyStores, dyn_cast<StoreInst>(U)))) {
-						RiskyStore tempRiskyStore ( cast<Value>(GV), dyn_cast<StoreInst>(U) );
-
-						currentRiskyStores.push_back(tempRiskyStore);
-						TotalStores++;
-					}
-				}
-			}
-		}
+void FunctionParamsUsagePass::indexRiskyStores() {
+	for (const RiskyStore &RS : currentRiskyStores) {
+		riskyStoresByBlock[std::get<1>(RS)->getParent()].push_back(RS);
 	}
-
-	const Value* V = nullptr;
-	for(StackVarFlow SVF: currentStackVarsFlows) {
-		V = std::get<0>(SVF)->getValue();
-		for (auto DUChain : std::get<1>(SVF)) {
-			for(auto DU : DUChain) {
-				const User* U = std::get<0>(DU);
-				if(isaRiskyStore(DU)) {
-					if(!(containsRiskyStore(currentRiskyStores, dyn_cast<StoreInst>(U)))) {
-						RiskyStore tempRiskyStore (V, dyn_cast<StoreInst>(U) );
-						currentRiskyStores.push_back(tempRiskyStore);
-						TotalStores++;
-					}
-				}
-			}
-		}
-	}
-
 }
 
 bool FunctionParamsUsagePass::isaRiskyStore(const DefUse &DU) const {
 	const User* U = std::get<0>(DU);
 	const Value* V = std::get<1>(DU);
-	if(isa<StoreInst>(U)) {
-		const StoreInst* store = dyn_cast<StoreInst>(U);
+	if(const StoreInst* store = dyn_cast<StoreInst>(U)) {
 		if (store->getPointerOperand() == V)
-			return true;
+			return isaRiskyStore(store);
 	}
 	return false;
 
 }
 
-bool FunctionParamsUsagePass::containsRiskyStore(std::vector<RiskyStore>& vector, const StoreInst* store) const {
-	const StoreInst* currStore = nullptr;
-	for(auto RS : vector) {
-		currStore = std::get<1>(RS);
-		if(currStore == store)
-			return true;
-	}
-	return false;
+bool FunctionParamsUsagePass::isaRiskyStore(const StoreInst *store) const {
+	return isTainted(store->getPointerOperand());
 }
 
 void FunctionParamsUsagePass::dumpAnalysis(raw_fd_ostream &FOS, Function &F) const {
@@ -524,24 +468,24 @@ void FunctionParamsUsagePass::dumpAnalysis(raw_fd_ostream &FOS, Function &F) con
 
 void FunctionParamsUsagePass::analyzeArgsUsage(const RevngFunction* currentRF, Function *F) {
 
-	get_print_stream(1) << "Analyzing arguments for " << F->getName() << "\n";
+	security_log(1, "Analyzing arguments for " << F->getName() << "\n");
 	bool firstUsageFound = false;
 	for(const GlobalVariable *GV: currentRF->getArguments()) {
 		// Reinitialize
 		std::vector<DefUseChain> defUseChains = analyzeSingleArgUsage(F, GV);
-		VariableFlow vflow(GV, defUseChains);
-		currentVarsFlows.push_back(vflow);
-		TotalVarChains++;
+		scanFlow(GV, defUseChains);
+		currentVarsFlows.emplace_back(GV, std::move(defUseChains));
+		count(VarChainsStat);
 	}
 }
 
 void FunctionParamsUsagePass::analyzePromotedArgsUsage(const RevngFunction* currentRF, Function *F) {
-	get_print_stream(3) << F->getName() << " has " << F->arg_size() << " promoted arguments\n";
+	security_log(3, F->getName() << " has " << F->arg_size() << " promoted arguments\n");
 	for( Function::arg_iterator A = F->arg_begin(), A_end = F->arg_end(); A != A_end ;  A++) {
 		std::vector<DefUseChain> defUseChains = analyzeSingleArgUsage(F, dyn_cast<Value>(A));
-		VariableFlow vflow(dyn_cast<Value>(A), defUseChains);
-		currentVarsFlows.push_back(vflow);
-		TotalVarChains++;
+		scanFlow(dyn_cast<Value>(A), defUseChains);
+		currentVarsFlows.emplace_back(dyn_cast<Value>(A), std::move(defUseChains));
+		count(VarChainsStat);
 	}
 }
 
@@ -555,7 +499,7 @@ std::vector<DefUseChain> FunctionParamsUsagePass::getSSAValueFlows(const Value*
 		startValue =  symTable->lookup(initName);
 	}
 	if ( startValue != nullptr) {
-		get_print_stream(2) << "Found an inital memoryssa value for " << V->getName() << ": " << startValue->getName() << "\n";
+		security_log(2, "Found an inital memoryssa value for " << V->getName() << ": " << startValue->getName() << "\n");
 		return getValueFlows(startValue);
 	} else {
 		return nullResult;
@@ -578,11 +522,12 @@ void FunctionParamsUsagePass::analyzeVSPUsage(const RevngFunction* currentRF, Fu
 
 	const GlobalVariable* stackPointer = currentRF->getStackPointer();
 	if (stackPointer == nullptr) {
-		get_print_stream(3) << "stack pointer variable not found\n";
+		security_log(3, "stack pointer variable not found\n");
 	}
 	else {
-		VariableFlow vflow(stackPointer, getValueFlows(dyn_cast<Value>(stackPointer)));
-		currentVarsFlows.push_back(vflow);
+		std::vector<DefUseChain> defUseChains = getValueFlows(stackPointer);
+		scanFlow(stackPointer, defUseChains);
+		currentVarsFlows.emplace_back(stackPointer, std::move(defUseChains));
 	}
 }
 
@@ -592,8 +537,9 @@ void FunctionParamsUsagePass::analyzeStackArgsUsage(const RevngFunction* current
   for(const VirtualStackParam *VSP: currentRF->getStackParams()) {
     // Reinitialize variables
     const Value* VSPval = VSP->getValue();
-    StackVarFlow svflow(VSP, getValueFlows(VSPval));
-    currentStackVarsFlows.push_back(svflow);
-    TotalStackChains++;
+    std::vector<DefUseChain> defUseChains = getValueFlows(VSPval);
+    scanFlow(VSPval, defUseChains);
+    currentStackVarsFlows.emplace_back(VSP, std::move(defUseChains));
+    count(StackChainsStat);
   }
 }
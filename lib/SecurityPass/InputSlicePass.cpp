@@ -0,0 +1,111 @@
+#include "revng/SecurityPass/InputSlicePass.h"
+
+using namespace llvm;
+using namespace revng;
+
+char InputSlicePass::ID = 0;
+
+static RegisterPass<InputSlicePass> X("revng-input-slice", "Tag the functions reachable from input sources",
+				       false /* Only looks at CFG */,
+				       false /* Analysis Pass */);
+
+
+InputSlicePass::InputSlicePass() : ModulePass(ID) {
+}
+
+void InputSlicePass::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<CallGraphWrapperPass>();
+	AU.setPreservesAll();
+}
+
+bool InputSlicePass::runOnModule(Module &M) {
+	slice.clear();
+	numFunctions = 0;
+	classifyFunctions(M);
+	ReverseCallGraph RCG;
+	RCG.build(getAnalysis<CallGraphWrapperPass>().getCallGraph());
+
+	std::vector<const Function*> sources;
+	std::vector<const Function*> propagators;
+	for (const Function &F : M) {
+		if (F.isDeclaration()) {
+			continue;
+		}
+		numFunctions++;
+		if (getFunctionClass(&F).input) {
+			sources.push_back(&F);
+		} else if (isMarked(&F)) {
+			propagators.push_back(&F);
+		}
+	}
+
+	std::vector<const Function*> worklist;
+	for (const Function *F : sources) {
+		if (slice.insert(F).second) {
+			worklist.push_back(F);
+		}
+	}
+	if (propagators.empty()) {
+		// input propagation did not run: every caller may receive input
+		visitCallers(RCG, worklist);
+	} else {
+		for (const Function *F : propagators) {
+			if (slice.insert(F).second) {
+				worklist.push_back(F);
+			}
+		}
+	}
+
+	// callees may be passed tainted values
+	for (const Function *F : slice) {
+		worklist.push_back(F);
+	}
+	visitCallees(RCG, worklist);
+
+	LLVMContext &C = M.getContext();
+	MDNode *inSlice = MDNode::get(C, MDString::get(C, "true"));
+	MDNode *outOfSlice = MDNode::get(C, MDString::get(C, "false"));
+	for (Function &F : M) {
+		if (F.isDeclaration()) {
+			continue;
+		}
+		bool tagged = isInSlice(&F);
+		F.setMetadata(REVNG_SECURITY_SLICE_MD, tagged ? inSlice : outOfSlice);
+		reclassifyFunction(F);
+		if (tagged) {
+			SliceFunctions++;
+		} else {
+			SliceExcludedFunctions++;
+		}
+	}
+	security_log(1, "Input slice contains " << slice.size() << " out of " << numFunctions << " functions\n");
+	return true;
+}
+
+void InputSlicePass::visitCallers(const ReverseCallGraph &RCG, std::vector<const Function*> &worklist) {
+	while (!worklist.empty()) {
+		const Function *F = worklist.back();
+		worklist.pop_back();
+		for (const Function *caller : RCG.getCallers(F)) {
+			if (slice.insert(caller).second) {
+				worklist.push_back(caller);
+			}
+		}
+	}
+}
+
+void InputSlicePass::visitCallees(const ReverseCallGraph &RCG, std::vector<const Function*> &worklist) {
+	while (!worklist.empty()) {
+		const Function *F = worklist.back();
+		worklist.pop_back();
+		for (const Function *callee : RCG.getCallees(F)) {
+			if (!callee->isDeclaration() && slice.insert(callee).second) {
+				worklist.push_back(callee);
+			}
+		}
+	}
+}
+
+void InputSlicePass::print(raw_ostream &OS, const Module *M) const {
+	OS << "Input slice contains " << slice.size() << " out of " << numFunctions << " functions\n";
+}
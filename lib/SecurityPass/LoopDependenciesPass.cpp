@@ -34,54 +34,107 @@ bool LoopDependenciesPass::doFinalization(Module &M) {
 }
 
 bool LoopDependenciesPass::runOnFunction(Function &F) {
-	errs() << "Starting LoopDependencies pass on " << F.getName() << "...\n";
-	candidateBranches.clear();
-	vulnerableLoops.clear();
-	VulnerableLoopItem* currentVlItem = nullptr;
-	std::pair<const StringRef, VulnerableLoopItem*> *vulnerableLoop = nullptr;
-	currentRF = getAnalysis<RevngFunctionParamsPass>().getRevngFunction();
+	resetResults();
+	if (isOutsideInputSlice(&F)) {
+		// do not even ask for LoopInfo
+		count(SkippedFunctionsStat);
+		security_log(2, "Function outside the input slice, skipping analysis ...\n");
+		return false;
+	}
+	const RevngFunction *RF = getAnalysis<RevngFunctionParamsPass>().getRevngFunction();
+	FunctionParamsUsagePass &FPU = getAnalysis<FunctionParamsUsagePass>();
+	LoopInfo &functionLI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+	analyze(F, RF, FPU, functionLI);
+	return false;
+}
+
+bool LoopDependenciesPass::analyze(Function &F, const RevngFunction *RF, FunctionParamsUsagePass &FPU, LoopInfo &functionLI) {
+	security_log(2, "Starting LoopDependencies pass on " << F.getName() << "...\n");
+	SecurityStageTimer timer(SecurityStage::LoopDependencies, F);
+	resetResults();
+	currentRF = RF;
 	if( !(currentRF->getFunctionName() == F.getName() && currentRF->getType() == RevngFunction::TYPE::ISOLATED)) {
-		errs() << "Function arguments not found for "<< F.getName() <<"!\n";
+		security_log(2, "Function arguments not found for "<< F.getName() <<"!\n");
 		return false;
 	} if ( isaSkippedFunction(&F) ) {
-	  LDPSkippedFunctions++;
-	  errs() << "Not a function in the scope of analysis, skipping...\n" ;
+	  count(SkippedFunctionsStat);
+	  security_log(2, "Not a function in the scope of analysis, skipping...\n" );
 	  return false;
 	}if (!isMarked(&F) && only_marked_funs) {
-		LDPSkippedFunctions++;
-		errs() << "Function not reached by any input, skipping analysis ...\n";
+		count(SkippedFunctionsStat);
+		security_log(2, "Function not reached by any input, skipping analysis ...\n");
 		return false;
 	}
-	OverallFunctions++;
-	FunctionParamsUsagePass &FPU = getAnalysis<FunctionParamsUsagePass>();
-	LoopInfo &functionLI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
-	errs() << "Obtained LoopInfo for "<< F.getName() << "\n";
-	for(const Loop *L : functionLI) {
+	if (isOutsideInputSlice(&F)) {
+		count(SkippedFunctionsStat);
+		security_log(2, "Function outside the input slice, skipping analysis ...\n");
+		return false;
+	}
+	count(OverallFunctionsStat);
+	security_log(2, "Obtained LoopInfo for "<< F.getName() << "\n");
+	// every loop of each nest, outer loops first: an inner loop may be
+	// controlled by a parameter even if the outer one is not
+	SmallVector<const Loop*, 8> loops;
+	for(const Loop *topLevel : functionLI) {
+		for(const Loop *L : topLevel->getLoopsInPreorder()) {
+			loops.push_back(L);
+		}
+	}
+	for(const Loop *L : loops) {
 		if(L->getName().empty()) {
 			continue; // Skip unnamed loop because lead to infinite loops
 		}
-		currentVlItem = new VulnerableLoopItem();
-		TotalLoops++;
-		if (analyzeLoop(L, FPU, *currentVlItem))
+		// only vulnerable loops are moved to the arena
+		VulnerableLoopItem currentVlItem;
+		count(LoopsStat);
+		if (analyzeLoop(L, FPU, currentVlItem))
 		{
-			errs() << "Loop " << L->getName() << " is vulnerable!\n";
-			vulnerableLoop = new std::pair<const StringRef, VulnerableLoopItem*>(L->getName(), currentVlItem);
-			vulnerableLoops.insert(std::move(*vulnerableLoop));
+			security_log(2, "Loop " << L->getName() << " is vulnerable!\n");
+			vulnerableLoops.emplace(L->getName(), loopItems.create(std::move(currentVlItem)));
 		}
 		else {
-			errs() << "Loop " << L->getName() << " is not vulnerable!\n";
-			delete currentVlItem;
+			security_log(2, "Loop " << L->getName() << " is not vulnerable!\n");
 		}
 
 	}
+	timer.addDefUseChains(traversedChains);
+	timer.addStoresVisited(visitedStores);
 	if( !isFunctionSafe() ) {
-	  VulnerableFunctions++;
+	  count(VulnerableFunctionsStat);
 	  if ( isMarked(&F)) {
-	    InputVulnerableFunctions++;
+	    count(InputVulnerableFunctionsStat);
 	  }
 
 	}
-	return false;
+	return true;
+}
+
+void LoopDependenciesPass::resetResults() {
+	candidateBranches.clear();
+	vulnerableLoops.clear();
+	loopItems.reset();
+	loopRiskyStores.reset();
+	traversedChains = 0;
+	visitedStores = 0;
+	std::fill(std::begin(statistics), std::end(statistics), 0);
+}
+
+// by StatisticKind
+static Statistic *const LDPStatistics[] = {
+	&LDPSkippedFunctions, &FilteredStores, &TotalLoops, &CandidateLoops,
+	&VulnerableFunctions, &InputVulnerableFunctions, &OverallFunctions
+};
+
+void LoopDependenciesPass::count(StatisticKind kind) {
+	++*LDPStatistics[kind];
+	statistics[kind]++;
+}
+
+void LoopDependenciesPass::addStatistics(ArrayRef<unsigned int> counts) {
+	assert(counts.size() == StatisticsCount && "Statistics of another pass");
+	for (unsigned int i = 0; i < StatisticsCount; i++) {
+		*LDPStatistics[i] += counts[i];
+	}
 }
 
 bool LoopDependenciesPass::analyzeLoop(const Loop* L, FunctionParamsUsagePass& FPU, VulnerableLoopItem& vlItem) {
@@ -92,37 +145,33 @@ bool LoopDependenciesPass::analyzeLoop(const Loop* L, FunctionParamsUsagePass& F
   std::vector<const RiskyStore*> &riskyStores = std::get<1>(vlItem);
 
 	bool analysisResult = false;
-	errs() << "Analyzing loop " << L->getName() << "\n";
+	security_log(2, "Analyzing loop " << L->getName() << "\n");
 
   lHeader = L->getHeader();
 
 
   if(lHeader == nullptr) {
-    errs() << "No header for the loop (please apply -loop-simplify transformation)";
+    security_log(2, "No header for the loop (please apply -loop-simplify transformation)");
     return false;
   }  else {
 	  if(analyzeLoopBasicBlock(lHeader, FPU)) {
 		  analysisResult = true;
 		  vlCandidateBranches.push_back(lHeader->getTerminator());
-		  CandidateLoops++;
+		  count(CandidateLoopsStat);
 	  }
   }
 
-  auto fpuRiskyStores = FPU.getRiskyStores();
   unsigned int loopStores = 0;
   if(analysisResult) {
-	  errs() << "Analyzing Risky stores of Function Params Usage pass\n";
+	  security_log(2, "Analyzing Risky stores of Function Params Usage pass\n");
+	  // ask the per-block index of FPU, blocks without risky stores cost a lookup
 	  for(const BasicBlock* BB: L->getBlocks() ) {
-		  errs() << "Searching stores inside Basic Block " << BB->getName() << "\n";
-		  for( RiskyStore R: fpuRiskyStores) {
-			  if(std::get<1>(R)->getParent() == BB ) {
-				  std::get<1>(R)->print(errs());
-				  errs() << " is inside the Basic block!\n";
-				  RiskyStore *clonedStore = new RiskyStore(std::get<0>(R), std::get<1>(R));
-				  riskyStores.push_back(clonedStore);
-				  loopStores++;
-				  FilteredStores++;
-			  }
+		  for(const RiskyStore &R: FPU.getRiskyStores(BB)) {
+			  security_log(2, *std::get<1>(R) << " is inside the Basic block " << BB->getName() << "!\n");
+			  riskyStores.push_back(loopRiskyStores.create(std::get<0>(R), std::get<1>(R)));
+			  loopStores++;
+			  visitedStores++;
+			  count(FilteredStoresStat);
 		  }
 	  }
   }
@@ -136,7 +185,7 @@ bool LoopDependenciesPass::analyzeLoop(const Loop* L, FunctionParamsUsagePass& F
 bool LoopDependenciesPass::analyzeLoopBasicBlock(const BasicBlock* BB, FunctionParamsUsagePass& FPU) {
 	assert(BB != nullptr && "Nullpointer passed to analyzeLoopBasicBlock");
 	bool analysisResult = false;
-	errs() << "Analyzing basic block " << BB->getName() << "...\n";
+	security_log(2, "Analyzing basic block " << BB->getName() << "...\n");
 	const Instruction* tInst = BB->getTerminator();
 	if(isa<BranchInst>(tInst)) {
 		const BranchInst* bInst = dyn_cast<BranchInst>(tInst);
@@ -144,23 +193,24 @@ bool LoopDependenciesPass::analyzeLoopBasicBlock(const BasicBlock* BB, FunctionP
 			const Value* condition = bInst->getCondition();
 			const CmpInst* cmp;
 			if(isa<CmpInst>(condition)) {
-				errs() << "Found compare instruction as terminator instruction in basic block\n";
-				errs() << "Analyzing conditons for " ;
+				security_log(2, "Found compare instruction as terminator instruction in basic block\n");
+				security_log(2, "Analyzing conditons for " );
 				const CmpInst* cmp = dyn_cast<CmpInst>(condition);
-				cmp->print(errs());
-				errs() << "...\n";
+				security_log(2, *cmp);
+				security_log(2, "...\n");
 				analysisResult = analyzeLoopCondition(cmp, FPU);
 			} else {
 				if(const User* U = dyn_cast<User>(condition)) {
 					auto backwardChain = traverseBackwardDefUseChain(U);
+					traversedChains++;
 					for(auto DU : backwardChain) {
 						const Value* inst = std::get<1>(DU);
 						cmp = dyn_cast<CmpInst>(inst);
 						if(cmp) {
-							errs() << "Found compare instruction traverse back def use of terminator instruction\n";
-							errs() << "Analyzing conditons for " ;
-							cmp->print(errs());
-							errs() << "...\n";
+							security_log(2, "Found compare instruction traverse back def use of terminator instruction\n");
+							security_log(2, "Analyzing conditons for " );
+							security_log(2, *cmp);
+							security_log(2, "...\n");
 							analysisResult = analyzeLoopCondition(cmp, FPU);
 						}
 					}
@@ -180,12 +230,12 @@ bool LoopDependenciesPass::analyzeLoopCondition(const CmpInst* condition, Functi
 	while(OPit != condition->op_end()) {
 		currOp = *OPit;
 		if(FPU.isaUserOfParams(dyn_cast<User>(currOp))) {
-			errs() << "Condition uses one of the function parameters!\n";
+			security_log(2, "Condition uses one of the function parameters!\n");
 			return true;
 		}
 		OPit++;
 	}
-	errs() << "No uses of parameters found for this condition!\n";
+	security_log(2, "No uses of parameters found for this condition!\n");
 	return false;
 }
 
@@ -259,7 +309,7 @@ json::Object LoopDependenciesPass::toJSON() const {
 	json::Object result;
 	json::ObjectKey vlsKey("vulnerableLoops");
 	json::Object vlsVal;
-	get_print_stream(1) << "Dumping "<< vulnerableLoops.size() << " vulnerable loops...\n";
+	security_log(1, "Dumping "<< vulnerableLoops.size() << " vulnerable loops...\n");
 	for(auto VL : vulnerableLoops) {
 		json::ObjectKey vlKey(std::get<0>(VL));
 		json::Object vlObj;
@@ -267,7 +317,7 @@ json::Object LoopDependenciesPass::toJSON() const {
 		json::ObjectKey brKey("candidateBranches");
 		json::Array brVal;
 
-		get_print_stream(2) << "Dumping " << std::get<0>(*vlItem).size() << " branches for "<< std::get<0>(VL) << " ...\n";
+		security_log(2, "Dumping " << std::get<0>(*vlItem).size() << " branches for "<< std::get<0>(VL) << " ...\n");
 		for( const Instruction* TI : std::get<0>(*vlItem)) {
 			std::string serializedTI;
 			serializedTI = formatv("{0}", *TI);
@@ -277,7 +327,7 @@ json::Object LoopDependenciesPass::toJSON() const {
 		vlObj.try_emplace(std::move(brKey), std::move(brVal));
 		json::ObjectKey rsKey("riskyStores");
 		json::Array rsVal;
-		get_print_stream(2) << "Dumping " << std::get<1>(*vlItem).size() << " branches for "<< std::get<0>(VL) << " ...\n";
+		security_log(2, "Dumping " << std::get<1>(*vlItem).size() << " branches for "<< std::get<0>(VL) << " ...\n");
 		for( auto RS : std::get<1>(*vlItem)) {
 			const Value* VAL = std::get<0>(*RS);
 			const StoreInst* ST = std::get<1>(*RS);
@@ -295,6 +345,24 @@ json::Object LoopDependenciesPass::toJSON() const {
 }
 
 
+std::vector<LoopFindings> LoopDependenciesPass::getLoopFindings() const {
+	std::vector<LoopFindings> result;
+	result.reserve(vulnerableLoops.size());
+	for (auto VL : vulnerableLoops) {
+		LoopFindings loop;
+		loop.name = std::get<0>(VL).str();
+		for (const Instruction *TI : std::get<0>(*std::get<1>(VL))) {
+			loop.branches.push_back(getInstructionLocation(TI));
+		}
+		for (const RiskyStore *RS : std::get<1>(*std::get<1>(VL))) {
+			loop.stores.push_back(getInstructionLocation(std::get<1>(*RS)));
+		}
+		result.push_back(std::move(loop));
+	}
+	return result;
+}
+
+
 bool LoopDependenciesPass::isFunctionSafe() const {
 	unsigned countStores = 0;
 	for (auto VL : vulnerableLoops) {
@@ -10,37 +10,126 @@ static RegisterPass<MaxStepsPass> X("revng-max-cg-length", "Search for the max l
 					  false /* Only looks at CFG */,
 					  true /* Analysis Pass */);
 
-// find read function or input generator inside a single scc
 
-
-MaxStepsPass::MaxStepsPass() : CallGraphSCCPass(ID) {
+MaxStepsPass::MaxStepsPass() : ModulePass(ID) {
 
 }
-bool MaxStepsPass::runOnSCC(CallGraphSCC &SCC) {
-	// Find callsite for read
-	updateMaxLength(SCC.size());
+
+bool MaxStepsPass::runOnModule(Module &M) {
+	maxLength = 0;
+	nodeSCC.clear();
+	SCCLength.clear();
+	functionSCC.clear();
+	computeLongestPath(getAnalysis<CallGraphWrapperPass>().getCallGraph());
+	security_log(1, "Max Length found in module CG is " << maxLength << "\n");
 	return false;
 }
 
 
-// Analyze whole CallGraph Deep First to propagate marked functions
-bool MaxStepsPass::doFinalization(CallGraph& CG) {
-	// should avoid cycles
-	// traverse deep first the callgraph
+// Iterative Tarjan over every node of the call graph. SCCs are closed in
+// reverse topological order, so when an SCC is closed all the SCCs it calls
+// already have their longest chain computed.
+void MaxStepsPass::computeLongestPath(const CallGraph &CG) {
+	struct Frame {
+		const CallGraphNode *node;
+		CallGraphNode::const_iterator next;
+	};
+
+	DenseMap<const CallGraphNode*, unsigned int> index;
+	DenseMap<const CallGraphNode*, unsigned int> lowLink;
+	std::vector<const CallGraphNode*> stack;
+	std::vector<Frame> frames;
+	std::vector<const CallGraphNode*> SCC;
+	unsigned int nextIndex = 0;
+
+	auto visit = [&](const CallGraphNode *node) {
+		index[node] = nextIndex;
+		lowLink[node] = nextIndex;
+		nextIndex++;
+		stack.push_back(node);
+		frames.push_back(Frame { node, node->begin() });
+	};
+
+	// CallGraph is keyed by pointer: pick the roots in module order, so that
+	// the SCC numbering does not change between runs
+	std::vector<const CallGraphNode*> roots { CG.getExternalCallingNode() };
+	for (const Function &F : CG.getModule()) {
+		roots.push_back(CG[&F]);
+	}
+
+	for (const CallGraphNode *root : roots) {
+		if (root == nullptr || index.count(root)) {
+			continue;
+		}
+		visit(root);
+		while (!frames.empty()) {
+			Frame &top = frames.back();
+			const CallGraphNode *node = top.node;
+			if (top.next != node->end()) {
+				const CallGraphNode *callee = (top.next++)->second;
+				auto calleeIt = index.find(callee);
+				if (calleeIt == index.end()) {
+					visit(callee);
+				} else if (!nodeSCC.count(callee)) {
+					// still on the stack
+					lowLink[node] = std::min(lowLink[node], calleeIt->second);
+				}
+				continue;
+			}
 
-	unsigned int counter = 0;
-	for(auto it = df_begin(&CG), endIt = df_end(&CG); it!= endIt; it++) {
-		// found a leaf
-		if (it->empty()) {
-			updateMaxLength(counter+1);
-			counter = 1;
-		} else {
-			counter++;
+			frames.pop_back();
+			unsigned int nodeLowLink = lowLink[node];
+			if (!frames.empty()) {
+				const CallGraphNode *parent = frames.back().node;
+				lowLink[parent] = std::min(lowLink[parent], nodeLowLink);
+			}
+			if (nodeLowLink != index[node]) {
+				continue;
+			}
+			SCC.clear();
+			const CallGraphNode *member = nullptr;
+			do {
+				member = stack.back();
+				stack.pop_back();
+				SCC.push_back(member);
+			} while (member != node);
+			closeSCC(SCC);
 		}
 	}
-	SHARED_MAX_LENGTH = maxLength;
-	errs() << "Max Length found in module CG is " << maxLength << "\n";
-	return false;
+}
+
+void MaxStepsPass::closeSCC(const std::vector<const CallGraphNode*> &SCC) {
+	unsigned int id = SCCLength.size();
+	unsigned int weight = 0;
+	unsigned int longestCallee = 0;
+	for (const CallGraphNode *node : SCC) {
+		if (node->getFunction() != nullptr) {
+			weight++;
+		}
+		for (const CallGraphNode::CallRecord &record : *node) {
+			auto calleeIt = nodeSCC.find(record.second);
+			// callees in the same SCC are not numbered yet
+			if (calleeIt != nodeSCC.end()) {
+				longestCallee = std::max(longestCallee, SCCLength[calleeIt->second]);
+			}
+		}
+	}
+	SCCLength.push_back(weight + longestCallee);
+	for (const CallGraphNode *node : SCC) {
+		nodeSCC[node] = id;
+		if (const Function *F = node->getFunction()) {
+			functionSCC[F] = id;
+		}
+	}
+	updateMaxLength(SCCLength[id]);
+}
+
+unsigned int MaxStepsPass::getSCCIndex(const Function *F) const {
+	auto it = functionSCC.find(F);
+	if (it == functionSCC.end()) {
+		return SCCLength.size();
+	}
+	return it->second;
 }
 
 
@@ -52,6 +141,7 @@ void MaxStepsPass::updateMaxLength(unsigned int newLength ) {
 }
 
 void MaxStepsPass::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<CallGraphWrapperPass>();
 	AU.setPreservesAll();
 }
 
@@ -0,0 +1,217 @@
+#include "revng/SecurityPass/ParallelSecurityPass.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "ParallelSecurityPass"
+STATISTIC(ParallelAnalyzedFunctions, "Number of functions analyzed by the parallel driver");
+STATISTIC(ParallelSkippedFunctions, "Number of functions skipped by the parallel driver");
+
+using namespace llvm;
+using namespace revng;
+
+char ParallelSecurityPass::ID = 0;
+
+static cl::opt<unsigned int> SecurityThreads("security-threads", cl::desc("Number of threads of revng-security-analysis-parallel (0 = one per core)"), cl::init(0));
+
+static RegisterPass<ParallelSecurityPass> Z("revng-security-analysis-parallel", "Analyze function reached by vulnerable points on multiple threads",
+					       false /* Only looks at CFG */,
+					       true /* Analysis Pass */);
+
+
+ParallelSecurityPass::ParallelSecurityPass() : ModulePass(ID) {
+}
+
+
+void ParallelSecurityPass::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.setPreservesAll();
+}
+
+
+bool ParallelSecurityPass::runOnModule(Module &M) {
+	functions.clear();
+	// Looking up a metadata kind by name registers it on first use, which
+	// writes to the LLVMContext: register every kind the analyses look up
+	// here, so that the workers only read the context.
+	LLVMContext &context = M.getContext();
+	for (const char *kind : { "revng.func.entry", REVNG_INPUT_MD, REVNG_INPUT_NAME_MD, REVNG_INPUT_POS_MD,
+				  REVNG_INPUT_TOANALYZE_MD, REVNG_SECURITY_MARKED_MD, REVNG_SECURITY_SLICE_MD }) {
+		context.getMDKindID(kind);
+	}
+
+	classifyFunctions(M);
+	for (Function &F : M) {
+		if (F.isDeclaration() || isaSkippedFunction(&F)) {
+			continue;
+		}
+		functions.push_back(&F);
+	}
+	if (functions.empty()) {
+		return false;
+	}
+
+	std::unique_ptr<JSONResultWriter> resultWriter;
+	if (DumpAnalysis) {
+		resultWriter.reset(new JSONResultWriter(AnalysisOutputFilename, DumpFormat));
+		if (!resultWriter->isOpen()) {
+			security_log(1, "Cannot open " << AnalysisOutputFilename << ": " << resultWriter->getError().message() << "\n");
+		}
+	}
+
+	std::unique_ptr<BinaryResultWriter> binaryWriter;
+	if (!BinaryOutputFilename.empty()) {
+		binaryWriter.reset(new BinaryResultWriter(BinaryOutputFilename));
+	}
+
+	std::unique_ptr<FunctionResultCache> resultCache;
+	if (!SecurityCacheDir.empty()) {
+		resultCache.reset(new FunctionResultCache(SecurityCacheDir));
+	}
+
+	unsigned int numThreads = SecurityThreads;
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	numThreads = std::min<size_t>(numThreads, functions.size());
+	security_log(2, "Analyzing " << functions.size() << " functions on " << numThreads << " threads...\n");
+
+	std::vector<FunctionResult> results(functions.size());
+	std::vector<ShardStatistics> shards(numThreads);
+	std::vector<char> done(functions.size(), 0);
+	std::atomic<size_t> cursor(0);
+	std::mutex doneMutex;
+	std::condition_variable doneCV;
+
+	auto worker = [&](unsigned int shard) {
+		// every worker owns its analyses, nothing is shared but the IR
+		RevngFunctionParamsPass RFP;
+		FunctionParamsUsagePass FPU;
+		LoopDependenciesPass LDP;
+		// not doInitialization, it rebuilds the shared classification table
+		RFP.setVirtualStackPointer(RevngFunctionParamsPass::findVirtualStackPointer(M));
+		for (size_t i = cursor++; i < functions.size(); i = cursor++) {
+			analyzeFunction(*functions[i], RFP, FPU, LDP, resultCache.get(), resultWriter != nullptr, binaryWriter != nullptr, results[i], shards[shard]);
+			{
+				std::lock_guard<std::mutex> lock(doneMutex);
+				done[i] = 1;
+			}
+			doneCV.notify_one();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned int shard = 0; shard < numThreads; shard++) {
+		pool.emplace_back(worker, shard);
+	}
+
+	// Captured output is already filtered by level, it goes to the lowest
+	// enabled logger
+	int mergeLevel = 1;
+	while (mergeLevel < MAX_PASS_VERBOSITY_LEVEL && !isSecurityLogEnabled(mergeLevel)) {
+		mergeLevel++;
+	}
+	raw_ostream &mergedLog = getSecurityLogStream(mergeLevel);
+
+	// Merge in module order while the workers go on: output, and the
+	// records in the result file, are the same whatever the interleaving
+	for (size_t i = 0; i < functions.size(); i++) {
+		{
+			std::unique_lock<std::mutex> lock(doneMutex);
+			doneCV.wait(lock, [&] { return done[i] != 0; });
+		}
+		FunctionResult &result = results[i];
+		mergedLog << result.log;
+		if (result.analyzed && resultWriter) {
+			resultWriter->writeFunction(functions[i]->getName(), std::move(result.record));
+		}
+		if (result.analyzed && binaryWriter) {
+			binaryWriter->writeFunction(result.findings);
+		}
+		// release the memory of merged functions
+		result = FunctionResult();
+	}
+
+	for (std::thread &T : pool) {
+		T.join();
+	}
+
+	for (const ShardStatistics &stats : shards) {
+		ParallelAnalyzedFunctions += stats.analyzedFunctions;
+		ParallelSkippedFunctions += stats.skippedFunctions;
+	}
+
+	if (resultWriter) {
+		SecurityWrapperPass::writeStatistics(*resultWriter);
+		resultWriter->close();
+	}
+	if (binaryWriter) {
+		SecurityWrapperPass::closeBinaryWriter(*binaryWriter);
+	}
+	flushSecurityLogs();
+	return false;
+}
+
+
+void ParallelSecurityPass::analyzeFunction(Function &F, RevngFunctionParamsPass &RFP, FunctionParamsUsagePass &FPU, LoopDependenciesPass &LDP,
+					   const FunctionResultCache *cache, bool buildRecord, bool buildFindings, FunctionResult &result, ShardStatistics &stats) {
+	raw_string_ostream log(result.log);
+	threadPrintStream = &log;
+
+	security_log(3, "Starting ParallelSecurityPass on function " << F.getName() << "...\n");
+	RFP.runOnFunction(F);
+	const RevngFunction *RF = RFP.getRevngFunction();
+	if (!(RF->getFunctionName() == F.getName() && RF->getType() == RevngFunction::TYPE::ISOLATED)) {
+		security_log(3, "Skipping non-revng function " << F.getName() << "...\n");
+		stats.skippedFunctions++;
+	} else if (!isMarked(&F) && only_marked_funs) {
+		security_log(3, "Skipping not marked function " << F.getName() << "...\n");
+		stats.skippedFunctions++;
+	} else if (isOutsideInputSlice(&F)) {
+		security_log(3, "Skipping function outside the input slice " << F.getName() << "...\n");
+		stats.skippedFunctions++;
+	} else if (cache != nullptr) {
+		FunctionSecurityResult cached = cache->getOrCompute(F, [&]() {
+			FPU.analyze(F, RF);
+			DominatorTree DT(F);
+			LoopInfo LI(DT);
+			LDP.analyze(F, RF, FPU, LI);
+			return FunctionSecurityResult(FPU, LDP);
+		});
+		if (buildRecord) {
+			result.record = SecurityWrapperPass::buildFunctionRecord(F, RFP, cached);
+		}
+		if (buildFindings) {
+			result.findings = SecurityWrapperPass::buildFunctionFindings(F, cached);
+		}
+		SecurityWrapperPass::printFunctionInfo(F, cached.isSafe, cached.numRiskyStores);
+		result.analyzed = true;
+		stats.analyzedFunctions++;
+	} else {
+		FPU.analyze(F, RF);
+		DominatorTree DT(F);
+		LoopInfo LI(DT);
+		LDP.analyze(F, RF, FPU, LI);
+		if (buildRecord) {
+			result.record = SecurityWrapperPass::buildFunctionRecord(F, RFP, FPU, LDP);
+		}
+		if (buildFindings) {
+			result.findings = SecurityWrapperPass::buildFunctionFindings(F, LDP);
+		}
+		SecurityWrapperPass::printFunctionInfo(F, LDP);
+		result.analyzed = true;
+		stats.analyzedFunctions++;
+	}
+
+	threadPrintStream = nullptr;
+	log.flush();
+}
+
+
+void ParallelSecurityPass::print(raw_ostream &OS, const Module *M) const {
+	OS << "Analyzed " << functions.size() << " candidate functions in parallel\n";
+}
@@ -0,0 +1,465 @@
+#include "revng/SecurityPass/ResultCache.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "ResultCache"
+STATISTIC(ResultCacheHits, "Number of functions whose results were found in the cache");
+STATISTIC(ResultCacheMisses, "Number of functions analyzed because of a cache miss");
+
+using namespace llvm;
+using namespace revng;
+
+// Bump whenever the analyses, or the layout of their results, change
+static const uint64_t ResultCacheVersion = 4;
+
+// Metadata of a function that the analyses, or the drivers, look at
+static const char *const HashedFunctionMD[] = {
+	"revng.func.entry",
+	REVNG_INPUT_MD,
+	REVNG_INPUT_NAME_MD,
+	REVNG_INPUT_POS_MD,
+	REVNG_INPUT_TOANALYZE_MD,
+	REVNG_SECURITY_MARKED_MD
+};
+
+namespace {
+
+	/// Feed the structure of a function into an MD5 hash
+	///
+	/// Instructions, basic blocks and arguments are identified by their
+	/// position, globals by their name, so the hash does not depend on
+	/// anything else in the module. Local names, and the metadata attached
+	/// to instructions, are hashed too: the cached results print them.
+	class FunctionHasher {
+	public:
+		explicit FunctionHasher(MD5 &hash) : hash(hash) {}
+
+		void hashFunction(const Function &F) {
+			hashedFunction = &F;
+			// kind IDs depend on the order kinds were registered
+			F.getContext().getMDKindNames(kindNames);
+			add(ResultCacheVersion);
+			add(F.getName());
+			hashType(F.getFunctionType());
+			hashFunctionMetadata(F);
+			for (const Argument &arg : F.args()) {
+				add(arg.getName());
+			}
+
+			// number every local value first, phis refer to later ones
+			for (const BasicBlock &BB : F) {
+				unsigned int id = localIDs.size();
+				localIDs[&BB] = id;
+				for (const Instruction &I : BB) {
+					id = localIDs.size();
+					localIDs[&I] = id;
+				}
+			}
+			for (const BasicBlock &BB : F) {
+				add('B');
+				add(BB.getName());
+				add(BB.size());
+				for (const Instruction &I : BB) {
+					hashInstruction(I);
+				}
+			}
+		}
+
+	private:
+		void add(uint64_t value) {
+			uint8_t bytes[8];
+			support::endian::write64le(bytes, value);
+			hash.update(bytes);
+		}
+
+		void add(StringRef string) {
+			add(string.size());
+			hash.update(string);
+		}
+
+		void add(const APInt &value) {
+			add(value.getBitWidth());
+			for (unsigned int i = 0; i < value.getNumWords(); i++) {
+				add(value.getRawData()[i]);
+			}
+		}
+
+		void hashType(Type *T) {
+			auto it = typeIDs.find(T);
+			if (it != typeIDs.end()) {
+				add(it->second);
+				return;
+			}
+			unsigned int id = typeIDs.size();
+			typeIDs[T] = id;
+			add(id);
+			std::string name;
+			raw_string_ostream OS(name);
+			T->print(OS, false, true);
+			add(OS.str());
+		}
+
+		void hashFunctionMetadata(const GlobalObject &GO) {
+			for (const char *kind : HashedFunctionMD) {
+				hashMetadata(GO.getMetadata(kind));
+			}
+		}
+
+		void hashInstruction(const Instruction &I) {
+			add(I.getOpcode());
+			add(I.getName());
+			hashType(I.getType());
+			add(I.getRawSubclassOptionalData());
+			if (const CmpInst *cmp = dyn_cast<CmpInst>(&I)) {
+				add(cmp->getPredicate());
+			}
+			if (const GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+				hashType(GEP->getSourceElementType());
+			}
+			if (const AllocaInst *alloca = dyn_cast<AllocaInst>(&I)) {
+				hashType(alloca->getAllocatedType());
+			}
+			if (const ExtractValueInst *EV = dyn_cast<ExtractValueInst>(&I)) {
+				for (unsigned int index : EV->indices()) {
+					add(index);
+				}
+			}
+			if (const InsertValueInst *IV = dyn_cast<InsertValueInst>(&I)) {
+				for (unsigned int index : IV->indices()) {
+					add(index);
+				}
+			}
+			add(I.getNumOperands());
+			for (const Value *operand : I.operand_values()) {
+				hashValue(operand);
+			}
+			// incoming blocks of a phi are not operands
+			if (const PHINode *phi = dyn_cast<PHINode>(&I)) {
+				for (const BasicBlock *incoming : phi->blocks()) {
+					hashValue(incoming);
+				}
+			}
+			SmallVector<std::pair<unsigned int, MDNode*>, 4> attachments;
+			I.getAllMetadata(attachments);
+			add(attachments.size());
+			for (const auto &attachment : attachments) {
+				add(kindNames[attachment.first]);
+				hashMetadata(attachment.second);
+			}
+		}
+
+		void hashValue(const Value *V) {
+			if (V == nullptr) {
+				add('0');
+				return;
+			}
+			auto it = localIDs.find(V);
+			if (it != localIDs.end()) {
+				add('L');
+				add(it->second);
+			} else if (const Argument *arg = dyn_cast<Argument>(V)) {
+				add('A');
+				add(arg->getArgNo());
+			} else if (const GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
+				add('G');
+				add(GV->getName());
+				hashType(GV->getType());
+				// callees are analyzed through their input/marked status
+				if (const Function *callee = dyn_cast<Function>(GV)) {
+					if (callee != hashedFunction) {
+						hashFunctionMetadata(*callee);
+					}
+				}
+			} else if (const Constant *C = dyn_cast<Constant>(V)) {
+				hashConstant(C);
+			} else if (const MetadataAsValue *MV = dyn_cast<MetadataAsValue>(V)) {
+				add('M');
+				hashMetadata(MV->getMetadata());
+			} else if (const InlineAsm *IA = dyn_cast<InlineAsm>(V)) {
+				add('I');
+				add(IA->getAsmString());
+				add(IA->getConstraintString());
+			} else {
+				add('U');
+				add(V->getValueID());
+			}
+		}
+
+		void hashConstant(const Constant *C) {
+			add('C');
+			add(C->getValueID());
+			hashType(C->getType());
+			if (const ConstantInt *CI = dyn_cast<ConstantInt>(C)) {
+				add(CI->getValue());
+			} else if (const ConstantFP *CF = dyn_cast<ConstantFP>(C)) {
+				add(CF->getValueAPF().bitcastToAPInt());
+			} else if (const ConstantDataSequential *CDS = dyn_cast<ConstantDataSequential>(C)) {
+				add(CDS->getRawDataValues());
+			} else if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(C)) {
+				add(CE->getOpcode());
+				if (CE->isCompare()) {
+					add(CE->getPredicate());
+				}
+			}
+			add(C->getNumOperands());
+			for (const Value *operand : C->operand_values()) {
+				hashValue(operand);
+			}
+		}
+
+		void hashMetadata(const Metadata *MD) {
+			if (MD == nullptr) {
+				add('0');
+				return;
+			}
+			if (const MDString *S = dyn_cast<MDString>(MD)) {
+				add('S');
+				add(S->getString());
+			} else if (const ValueAsMetadata *VM = dyn_cast<ValueAsMetadata>(MD)) {
+				add('V');
+				hashValue(VM->getValue());
+			} else if (const MDNode *N = dyn_cast<MDNode>(MD)) {
+				add('N');
+				// metadata graphs may be cyclic
+				if (!visitingMD.insert(N).second) {
+					add('R');
+					return;
+				}
+				add(N->getNumOperands());
+				for (const MDOperand &op : N->operands()) {
+					hashMetadata(op.get());
+				}
+				visitingMD.erase(N);
+			} else {
+				add('U');
+				add(MD->getMetadataID());
+			}
+		}
+
+		MD5 &hash;
+		const Function *hashedFunction = nullptr;
+		DenseMap<const Value*, unsigned int> localIDs;
+		DenseMap<Type*, unsigned int> typeIDs;
+		SmallPtrSet<const MDNode*, 8> visitingMD;
+		SmallVector<StringRef, 32> kindNames;
+	};
+
+}
+
+
+FunctionSecurityResult::FunctionSecurityResult(FunctionParamsUsagePass &FPU, const LoopDependenciesPass &LDP) :
+	paramsUsage(FPU.toJSON()),
+	loopDependencies(LDP.toJSON()),
+	isSafe(LDP.isFunctionSafe()),
+	numRiskyStores(LDP.getNumRiskyStores()),
+	loops(LDP.getLoopFindings()),
+	paramsUsageStatistics(FPU.getStatistics().begin(), FPU.getStatistics().end()),
+	loopDependenciesStatistics(LDP.getStatistics().begin(), LDP.getStatistics().end()) {
+}
+
+void FunctionSecurityResult::replayStatistics() const {
+	FunctionParamsUsagePass::addStatistics(paramsUsageStatistics);
+	LoopDependenciesPass::addStatistics(loopDependenciesStatistics);
+}
+
+static json::Value statisticsToJSON(const std::vector<unsigned int> &counts) {
+	json::Array result;
+	for (unsigned int count : counts) {
+		result.push_back(int64_t(count));
+	}
+	return json::Value(std::move(result));
+}
+
+// entries written by another version of a pass are rejected by the size
+static bool statisticsFromJSON(const json::Value *value, size_t size, std::vector<unsigned int> &counts) {
+	const json::Array *array = value ? value->getAsArray() : nullptr;
+	if (array == nullptr || array->size() != size) {
+		return false;
+	}
+	for (const json::Value &element : *array) {
+		Optional<int64_t> count = element.getAsInteger();
+		if (!count || *count < 0) {
+			return false;
+		}
+		counts.push_back(unsigned(*count));
+	}
+	return true;
+}
+
+// locations are [address, offset] pairs, addresses keep their bits in an int64
+static json::Value locationsToJSON(const std::vector<InstructionLocation> &locations) {
+	json::Array result;
+	for (const InstructionLocation &location : locations) {
+		result.push_back(json::Array{ int64_t(location.address), int64_t(location.offset) });
+	}
+	return json::Value(std::move(result));
+}
+
+static bool locationsFromJSON(const json::Value *value, std::vector<InstructionLocation> &locations) {
+	const json::Array *array = value ? value->getAsArray() : nullptr;
+	if (array == nullptr) {
+		return false;
+	}
+	for (const json::Value &element : *array) {
+		const json::Array *pair = element.getAsArray();
+		if (pair == nullptr || pair->size() != 2) {
+			return false;
+		}
+		Optional<int64_t> address = (*pair)[0].getAsInteger();
+		Optional<int64_t> offset = (*pair)[1].getAsInteger();
+		if (!address || !offset) {
+			return false;
+		}
+		InstructionLocation location;
+		location.address = uint64_t(*address);
+		location.offset = uint32_t(*offset);
+		locations.push_back(location);
+	}
+	return true;
+}
+
+json::Value FunctionSecurityResult::toJSON() const {
+	json::Object entry;
+	entry.try_emplace("functionParamsUsageAnalysis", paramsUsage);
+	entry.try_emplace("loopDependenciesAnalysis", loopDependencies);
+	entry.try_emplace("isSafe", isSafe);
+	entry.try_emplace("numRiskyStores", int64_t(numRiskyStores));
+	json::Array loopsJSON;
+	for (const LoopFindings &loop : loops) {
+		loopsJSON.push_back(json::Object{
+			{ "name", loop.name },
+			{ "branches", locationsToJSON(loop.branches) },
+			{ "stores", locationsToJSON(loop.stores) } });
+	}
+	entry.try_emplace("loopFindings", std::move(loopsJSON));
+	entry.try_emplace("paramsUsageStatistics", statisticsToJSON(paramsUsageStatistics));
+	entry.try_emplace("loopDependenciesStatistics", statisticsToJSON(loopDependenciesStatistics));
+	return json::Value(std::move(entry));
+}
+
+Optional<FunctionSecurityResult> FunctionSecurityResult::fromJSON(const json::Value &value) {
+	const json::Object *entry = value.getAsObject();
+	if (entry == nullptr) {
+		return None;
+	}
+	const json::Value *paramsUsage = entry->get("functionParamsUsageAnalysis");
+	const json::Value *loopDependencies = entry->get("loopDependenciesAnalysis");
+	Optional<bool> isSafe = entry->getBoolean("isSafe");
+	Optional<int64_t> numRiskyStores = entry->getInteger("numRiskyStores");
+	const json::Array *loops = entry->getArray("loopFindings");
+	if (!paramsUsage || !loopDependencies || !isSafe || !numRiskyStores || !loops) {
+		return None;
+	}
+	FunctionSecurityResult result;
+	result.paramsUsage = *paramsUsage;
+	result.loopDependencies = *loopDependencies;
+	result.isSafe = *isSafe;
+	result.numRiskyStores = *numRiskyStores;
+	if (!statisticsFromJSON(entry->get("paramsUsageStatistics"), FunctionParamsUsagePass::StatisticsCount, result.paramsUsageStatistics)
+	    || !statisticsFromJSON(entry->get("loopDependenciesStatistics"), LoopDependenciesPass::StatisticsCount, result.loopDependenciesStatistics)) {
+		return None;
+	}
+	for (const json::Value &loopJSON : *loops) {
+		const json::Object *loopObject = loopJSON.getAsObject();
+		if (loopObject == nullptr) {
+			return None;
+		}
+		Optional<StringRef> name = loopObject->getString("name");
+		LoopFindings loop;
+		if (!name
+		    || !locationsFromJSON(loopObject->get("branches"), loop.branches)
+		    || !locationsFromJSON(loopObject->get("stores"), loop.stores)) {
+			return None;
+		}
+		loop.name = name->str();
+		result.loops.push_back(std::move(loop));
+	}
+	return result;
+}
+
+
+FunctionResultCache::FunctionResultCache(StringRef directory) : directory(directory) {
+	if (std::error_code error = sys::fs::create_directories(directory)) {
+		security_log(1, "Cannot create cache directory " << directory << ": " << error.message() << "\n");
+	}
+}
+
+std::string FunctionResultCache::computeKey(const Function &F) {
+	MD5 hash;
+	FunctionHasher(hash).hashFunction(F);
+	MD5::MD5Result digest;
+	hash.final(digest);
+	return std::string(digest.digest().str());
+}
+
+std::string FunctionResultCache::getEntryPath(StringRef key) const {
+	SmallString<128> path(directory);
+	sys::path::append(path, key + ".json");
+	return std::string(path.str());
+}
+
+Optional<FunctionSecurityResult> FunctionResultCache::lookup(StringRef key) const {
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(getEntryPath(key));
+	if (!buffer) {
+		return None;
+	}
+	Expected<json::Value> entry = json::parse((*buffer)->getBuffer());
+	if (!entry) {
+		// a damaged entry is just a miss, it will be overwritten
+		consumeError(entry.takeError());
+		return None;
+	}
+	return FunctionSecurityResult::fromJSON(*entry);
+}
+
+void FunctionResultCache::store(StringRef key, StringRef functionName, const FunctionSecurityResult &result) const {
+	SmallString<128> model(directory);
+	sys::path::append(model, key + "-%%%%%%.tmp");
+	SmallString<128> temporary;
+	int fd;
+	if (sys::fs::createUniqueFile(model, fd, temporary)) {
+		return;
+	}
+	{
+		raw_fd_ostream OS(fd, /* shouldClose */ true);
+		json::Value entry = result.toJSON();
+		// the name only helps who inspects the cache, it is not read back
+		entry.getAsObject()->try_emplace("function", functionName);
+		OS << entry;
+		if (OS.has_error()) {
+			OS.clear_error();
+			OS.close();
+			sys::fs::remove(temporary);
+			return;
+		}
+	}
+	if (sys::fs::rename(temporary, getEntryPath(key))) {
+		sys::fs::remove(temporary);
+	}
+}
+
+FunctionSecurityResult FunctionResultCache::getOrCompute(const Function &F, function_ref<FunctionSecurityResult()> compute) const {
+	std::string key = computeKey(F);
+	if (Optional<FunctionSecurityResult> cached = lookup(key)) {
+		security_log(2, "Cached results found for " << F.getName() << "\n");
+		ResultCacheHits++;
+		cached->replayStatistics();
+		return std::move(*cached);
+	}
+	ResultCacheMisses++;
+	FunctionSecurityResult result = compute();
+	store(key, F.getName(), result);
+	return result;
+}
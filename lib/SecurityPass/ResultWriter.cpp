@@ -0,0 +1,188 @@
+#include "revng/SecurityPass/ResultWriter.h"
+#include "llvm/ADT/SmallString.h"
+#include <cstring>
+
+using namespace llvm;
+using namespace revng;
+
+JSONResultWriter::JSONResultWriter(StringRef fileName, Format format) : format(format) {
+	output.reset(new raw_fd_ostream(fileName, error, sys::fs::OpenFlags::OF_None));
+	if (error) {
+		output.reset();
+		return;
+	}
+	if (format == Object) {
+		*output << "{";
+		output->flush();
+	}
+}
+
+JSONResultWriter::~JSONResultWriter() {
+	close();
+}
+
+void JSONResultWriter::writeMember(StringRef key, const json::Value &value) {
+	raw_fd_ostream &OS = *output;
+	if (format == Object) {
+		OS << (firstMember ? "\n" : ",\n");
+		OS << json::Value(key) << ":" << value;
+	} else {
+		OS << "{" << json::Value(key) << ":" << value << "}\n";
+	}
+	firstMember = false;
+	// make the record durable before moving to the next function
+	OS.flush();
+}
+
+bool JSONResultWriter::writeFunction(StringRef name, json::Value record) {
+	if (!isOpen()) {
+		return false;
+	}
+	if (!writtenFunctions.insert(name).second) {
+		return false;
+	}
+	writeMember(name, record);
+	return true;
+}
+
+void JSONResultWriter::writeStatistics(json::Object stats) {
+	if (!isOpen()) {
+		return;
+	}
+	writeMember("analysisStatistics", json::Value(std::move(stats)));
+}
+
+void JSONResultWriter::writeProfile(json::Object profile) {
+	if (!isOpen()) {
+		return;
+	}
+	writeMember("analysisProfile", json::Value(std::move(profile)));
+}
+
+void JSONResultWriter::close() {
+	if (!isOpen()) {
+		return;
+	}
+	if (format == Object) {
+		*output << "\n}\n";
+	}
+	output->close();
+	output.reset();
+}
+
+
+BinaryResultWriter::BinaryResultWriter(StringRef fileName) : fileName(fileName) {
+	// offset 0 is the empty string
+	strings.push_back('\0');
+	stringOffsets.try_emplace("", 0);
+}
+
+BinaryResultWriter::~BinaryResultWriter() {
+	close();
+}
+
+uint32_t BinaryResultWriter::addString(StringRef string) {
+	auto it = stringOffsets.try_emplace(string, strings.size());
+	if (it.second) {
+		strings.append(string.begin(), string.end());
+		strings.push_back('\0');
+	}
+	return it.first->second;
+}
+
+uint32_t BinaryResultWriter::addLocations(ArrayRef<InstructionLocation> newLocations) {
+	uint32_t first = locations.size();
+	for (const InstructionLocation &location : newLocations) {
+		binary::LocationRecord record;
+		record.address = location.address;
+		record.offset = location.offset;
+		record.reserved = 0;
+		locations.push_back(record);
+	}
+	return first;
+}
+
+bool BinaryResultWriter::writeFunction(const FunctionFindings &findings) {
+	if (closed || !writtenFunctions.insert(findings.name).second) {
+		return false;
+	}
+	binary::FunctionRecord function;
+	function.entryAddress = findings.entryAddress;
+	function.name = addString(findings.name);
+	function.flags = (findings.isMarked ? uint32_t(binary::IsMarked) : 0) | (findings.isSafe ? uint32_t(binary::IsSafe) : 0);
+	function.firstLoop = loops.size();
+	function.numLoops = findings.loops.size();
+	function.numRiskyStores = findings.numRiskyStores;
+	function.reserved = 0;
+	for (const LoopFindings &loopFindings : findings.loops) {
+		binary::LoopRecord loop;
+		loop.name = addString(loopFindings.name);
+		loop.firstBranch = addLocations(loopFindings.branches);
+		loop.numBranches = loopFindings.branches.size();
+		loop.firstStore = addLocations(loopFindings.stores);
+		loop.numStores = loopFindings.stores.size();
+		loop.reserved = 0;
+		loops.push_back(loop);
+	}
+	functions.push_back(function);
+	return true;
+}
+
+// write the bytes of table, then pad to the alignment of the next table
+template<typename T>
+static uint64_t writeTable(raw_ostream &OS, uint64_t offset, ArrayRef<T> table) {
+	OS.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+	offset += table.size() * sizeof(T);
+	for (; offset % alignof(uint64_t) != 0; offset++) {
+		OS << '\0';
+	}
+	return offset;
+}
+
+std::error_code BinaryResultWriter::close() {
+	if (closed) {
+		return std::error_code();
+	}
+	closed = true;
+
+	binary::Header header;
+	std::memcpy(header.magic, binary::Magic, sizeof(binary::Magic));
+	header.version = binary::Version;
+	header.numFunctions = functions.size();
+	header.numLoops = loops.size();
+	header.numLocations = locations.size();
+	header.functionsOffset = sizeof(binary::Header);
+	header.loopsOffset = header.functionsOffset + functions.size() * sizeof(binary::FunctionRecord);
+	header.locationsOffset = header.loopsOffset + loops.size() * sizeof(binary::LoopRecord);
+	header.stringsOffset = header.locationsOffset + locations.size() * sizeof(binary::LocationRecord);
+	header.stringsSize = strings.size();
+
+	SmallString<128> temporary;
+	int fd;
+	if (std::error_code error = sys::fs::createUniqueFile(fileName + "-%%%%%%.tmp", fd, temporary)) {
+		return error;
+	}
+	{
+		raw_fd_ostream OS(fd, /* shouldClose */ true);
+		uint64_t offset = writeTable(OS, 0, makeArrayRef(header));
+		offset = writeTable(OS, offset, makeArrayRef(functions));
+		offset = writeTable(OS, offset, makeArrayRef(loops));
+		offset = writeTable(OS, offset, makeArrayRef(locations));
+		OS << strings;
+		OS.close();
+		if (OS.has_error()) {
+			std::error_code error = OS.error();
+			OS.clear_error();
+			sys::fs::remove(temporary);
+			return error;
+		}
+	}
+	if (std::error_code error = sys::fs::rename(temporary, fileName)) {
+		sys::fs::remove(temporary);
+		return error;
+	}
+	functions.clear();
+	loops.clear();
+	locations.clear();
+	return std::error_code();
+}
@@ -0,0 +1,85 @@
+#include "revng/SecurityPass/ReverseCallGraph.h"
+
+using namespace llvm;
+using namespace revng;
+
+void ReverseCallGraph::clear() {
+	callersMap.clear();
+	calleesMap.clear();
+}
+
+void ReverseCallGraph::build(const CallGraph &CG) {
+	clear();
+	// CallGraph is keyed by pointer, walk the module to get a stable order
+	for (const Function &F : CG.getModule()) {
+		const CallGraphNode *node = CG[&F];
+		if (node != nullptr) {
+			addCallerNode(*node);
+		}
+	}
+}
+
+void ReverseCallGraph::addCallerNode(const CallGraphNode &node) {
+	Function *caller = node.getFunction();
+	if (caller == nullptr) {
+		return;
+	}
+	for (const CallGraphNode::CallRecord &record : node) {
+		Function *callee = record.second->getFunction();
+		if (callee == nullptr) {
+			continue;
+		}
+		const Value *callSite = record.first;
+		addCallEdge(caller, callee, dyn_cast_or_null<Instruction>(callSite));
+	}
+}
+
+void ReverseCallGraph::addCallEdge(Function *caller, Function *callee, const Instruction *callSite) {
+	CalleeEntry &calleeEntry = callersMap[callee];
+	auto inserted = calleeEntry.entryIndex.insert({ caller, calleeEntry.entries.size() });
+	if (inserted.second) {
+		calleeEntry.callers.push_back(caller);
+		calleeEntry.entries.push_back(CallerEntry { caller, {} });
+		calleesMap[caller].push_back(callee);
+	}
+	if (callSite != nullptr) {
+		calleeEntry.entries[inserted.first->second].callSites.push_back(callSite);
+	}
+}
+
+ArrayRef<Function*> ReverseCallGraph::getCallers(const Function *callee) const {
+	auto it = callersMap.find(callee);
+	if (it == callersMap.end()) {
+		return {};
+	}
+	return it->second.callers;
+}
+
+ArrayRef<Function*> ReverseCallGraph::getCallees(const Function *caller) const {
+	auto it = calleesMap.find(caller);
+	if (it == calleesMap.end()) {
+		return {};
+	}
+	return it->second;
+}
+
+ArrayRef<ReverseCallGraph::CallerEntry> ReverseCallGraph::getCallerEntries(const Function *callee) const {
+	auto it = callersMap.find(callee);
+	if (it == callersMap.end()) {
+		return {};
+	}
+	return it->second.entries;
+}
+
+ArrayRef<const Instruction*> ReverseCallGraph::getCallSites(const Function *callee, const Function *caller) const {
+	auto calleeIt = callersMap.find(callee);
+	if (calleeIt == callersMap.end()) {
+		return {};
+	}
+	const CalleeEntry &calleeEntry = calleeIt->second;
+	auto entryIt = calleeEntry.entryIndex.find(caller);
+	if (entryIt == calleeEntry.entryIndex.end()) {
+		return {};
+	}
+	return calleeEntry.entries[entryIt->second].callSites;
+}
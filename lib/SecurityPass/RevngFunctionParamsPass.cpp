@@ -44,7 +44,7 @@ void RevngFunctionParamsPass::scanVirtualStack(Function &F,std::vector<const Vir
 		const Value *virtVar = findVirtStackParam(F, U);
 		if( virtVar ) {
 			virtualStackParamIndex++;
-			res.push_back(new VirtualStackParam(virtVar, virtualStackParamIndex, 0));
+			res.push_back(stackParams.create(virtVar, virtualStackParamIndex, 0));
 		}
 	}
 }
@@ -61,7 +61,7 @@ const Value* RevngFunctionParamsPass::findVirtStackParam(Function &F, const User
 	}
        	const User* currentUser = nullptr;
 	while(!nextUsers.empty()) {
-			get_print_stream(3) << "Remaining users: " << nextUsers.size() << "\n";
+			security_log(3, "Remaining users: " << nextUsers.size() << "\n");
 			currentUser = nextUsers.front();
 			nextUsers.pop_front();
 			if (const Instruction* I = dyn_cast<Instruction>(currentUser)) {
@@ -116,35 +116,33 @@ void RevngFunctionParamsPass::printMDTuple(raw_ostream &OS, MDTuple &tuple) {
 }
 
 bool RevngFunctionParamsPass::doInitialization(Module &M) {
-	   for(const GlobalVariable &GV: M.globals() ) {
-		   if(GV.getName() == "rsp") { // x86-64
-			   virtualStackPointer = &GV;
-		   }
-		   if(GV.getName() == "esp") { // i386
-			   virtualStackPointer = &GV;
-		   }
-
-   }
-	   return false;
+	virtualStackPointer = findVirtualStackPointer(M);
+	classifyFunctions(M);
+	return false;
+}
+
+const GlobalVariable* RevngFunctionParamsPass::findVirtualStackPointer(const Module &M) {
+	if (const GlobalVariable *GV = M.getNamedGlobal("rsp")) { // x86-64
+		return GV;
+	}
+	return M.getNamedGlobal("esp"); // i386
 }
 
 bool RevngFunctionParamsPass::runOnFunction(Function &F) {
-	get_print_stream(3) << "Starting RevngFunctionParamsPass on function" << F.getName() << "...\n";
+	SecurityStageTimer timer(SecurityStage::RevngFunctionParams, F);
+	security_log(3, "Starting RevngFunctionParamsPass on function" << F.getName() << "...\n");
   res.functionName = F.getName();
   res.functionArguments.clear();
   res.functionVirtStackParams.clear();
-  MDNode *funcMetadata = F.getMetadata("revng.func.entry");
-  get_print_stream(3) << "Analyzing " << F.getName() << "...\n";
-  if (funcMetadata == nullptr || F.isDeclaration()) {
-    get_print_stream(3) << F.getName() <<  " is not a revng isolated function\n";
-    res.type = RevngFunction::TYPE::NOT_ISOLATED;
-    return false;
-  }
-  if (!revngFunctionRegex.match(F.getName())) {
-	      get_print_stream(3) << F.getName() <<  " does not start with \"bb.\", maybe is a QEMU helper\n";
+  stackParams.reset();
+  security_log(3, "Analyzing " << F.getName() << "...\n");
+  FunctionClass FC = getFunctionClass(&F);
+  if (!FC.isolated) {
+    security_log(3, F.getName() <<  " is not a revng isolated function, or maybe is a QEMU helper\n");
     res.type = RevngFunction::TYPE::NOT_ISOLATED;
     return false;
   }
+  MDNode *funcMetadata = FC.entry;
   res.type = RevngFunction::TYPE::ISOLATED;
   res.virtStackPointer = virtualStackPointer;
   const MDOperand *op_it = funcMetadata->op_begin(); // Metadata for name
@@ -161,10 +159,10 @@ bool RevngFunctionParamsPass::runOnFunction(Function &F) {
 
     Metadata *meta = op_it->get(); // print metadata operand
     if( isa<MDString>(meta) ) {
-      get_print_stream(3) << "Metadata string ";
+      security_log(3, "Metadata string ");
     }
     else if (isa<ValueAsMetadata>(meta)){
-      get_print_stream(3) << "value as metadata";
+      security_log(3, "value as metadata");
       ValueAsMetadata* valueMD = dyn_cast<ValueAsMetadata>(meta);
     }
     else if (isa<MDTuple>(meta)) {
@@ -175,18 +173,18 @@ bool RevngFunctionParamsPass::runOnFunction(Function &F) {
   }
 
   if(res.virtStackPointer){
-       get_print_stream(3) << "Scanning virtual stack for passed arguments \n";
+       security_log(3, "Scanning virtual stack for passed arguments \n");
        scanVirtualStack(F, res.functionVirtStackParams, res.virtStackPointer);
   }
 
   filterOutRevngVars();
-  get_print_stream(3) << "Function params found for " << F.getName() << ": \n";
+  security_log(3, "Function params found for " << F.getName() << ": \n");
   for (const GlobalVariable *GV: res.functionArguments) {
-   get_print_stream(3) << "- ";
-   GV->print(get_print_stream(3));
-   get_print_stream(3) << "\n";
+   security_log(3, "- ");
+   security_log(3, *GV);
+   security_log(3, "\n");
   }
-  get_print_stream(3) << "Function stack params found for " << F.getName() << ": \n";
+  security_log(3, "Function stack params found for " << F.getName() << ": \n");
   return false;
 }
 
@@ -325,7 +323,7 @@ void RevngFunctionParamsPass::filterOutRevngVars() {
 bool RevngFunctionParamsPass::isaRevngVar(const Value* V) {
   assert(V != nullptr && "Nullptr passed to isaRevngVar");
   StringRef name = V->getName();
-  get_print_stream(3) << "Variable name : " << name << "\n";
+  security_log(3, "Variable name : " << name << "\n");
   if(name.equals("ExceptionFlag")) {
     return true;
   }
@@ -0,0 +1,189 @@
+#include "revng/SecurityPass/SecurityAnalyses.h"
+#include "revng/SecurityPass/SecurityWrapperPass.h"
+
+using namespace llvm;
+using namespace revng;
+
+AnalysisKey RevngFunctionParamsAnalysis::Key;
+AnalysisKey FunctionParamsUsageAnalysis::Key;
+AnalysisKey LoopDependenciesAnalysis::Key;
+
+char SecurityPipelinePass::ID = 0;
+
+static RegisterPass<SecurityPipelinePass> Z("revng-security-analysis-npm", "Analyze function reached by vulnerable points through the new pass manager",
+					       false /* Only looks at CFG */,
+					       true /* Analysis Pass */);
+
+
+bool RevngFunctionParamsAnalysis::Result::isIsolated(const Function &F) const {
+	const RevngFunction *RF = getRevngFunction();
+	return RF->getFunctionName() == F.getName() && RF->getType() == RevngFunction::TYPE::ISOLATED;
+}
+
+RevngFunctionParamsAnalysis::Result RevngFunctionParamsAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	std::unique_ptr<RevngFunctionParamsPass> RFP(new RevngFunctionParamsPass());
+	RFP->setVirtualStackPointer(RevngFunctionParamsPass::findVirtualStackPointer(*F.getParent()));
+	RFP->runOnFunction(F);
+	return Result(std::move(RFP));
+}
+
+
+bool FunctionParamsUsageAnalysis::Result::invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &Inv) {
+	auto PAC = PA.getChecker<FunctionParamsUsageAnalysis>();
+	return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>())
+		|| Inv.invalidate<RevngFunctionParamsAnalysis>(F, PA);
+}
+
+FunctionParamsUsageAnalysis::Result FunctionParamsUsageAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	auto &RFP = FAM.getResult<RevngFunctionParamsAnalysis>(F);
+	std::unique_ptr<FunctionParamsUsagePass> FPU(new FunctionParamsUsagePass());
+	bool analyzed = FPU->analyze(F, RFP.getRevngFunction());
+	if (analyzed && FunctionParamsUsagePass::printsValueRanges()) {
+		FPU->setScalarEvolution(&FAM.getResult<ScalarEvolutionAnalysis>(F));
+	}
+	return Result(std::move(FPU), analyzed);
+}
+
+
+bool LoopDependenciesAnalysis::Result::invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &Inv) {
+	auto PAC = PA.getChecker<LoopDependenciesAnalysis>();
+	return !(PAC.preserved() || PAC.preservedSet<AllAnalysesOn<Function>>())
+		|| Inv.invalidate<FunctionParamsUsageAnalysis>(F, PA)
+		|| Inv.invalidate<LoopAnalysis>(F, PA);
+}
+
+LoopDependenciesAnalysis::Result LoopDependenciesAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+	auto &RFP = FAM.getResult<RevngFunctionParamsAnalysis>(F);
+	auto &FPU = FAM.getResult<FunctionParamsUsageAnalysis>(F);
+	std::unique_ptr<LoopDependenciesPass> LDP(new LoopDependenciesPass());
+	if (!FPU.isAnalyzed()) {
+		return Result(std::move(LDP), false);
+	}
+	LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+	bool analyzed = LDP->analyze(F, RFP.getRevngFunction(), FPU.getPass(), LI);
+	return Result(std::move(LDP), analyzed);
+}
+
+
+PreservedAnalyses SecurityAnalysisPrinterPass::run(Function &F, FunctionAnalysisManager &FAM) {
+	if (F.isDeclaration()) {
+		return PreservedAnalyses::all();
+	}
+	security_log(3, "Starting SecurityAnalysisPrinterPass on function " << F.getName() << "...\n");
+	// cheap checks first, the analyses are computed only for the functions
+	// that get through
+	if (isaSkippedFunction(&F) || (!isMarked(&F) && only_marked_funs)) {
+		security_log(3, "Skipping not marked function " << F.getName() << "...\n");
+		return PreservedAnalyses::all();
+	}
+	if (isOutsideInputSlice(&F)) {
+		security_log(3, "Skipping function outside the input slice " << F.getName() << "...\n");
+		return PreservedAnalyses::all();
+	}
+	auto &RFP = FAM.getResult<RevngFunctionParamsAnalysis>(F);
+	if (!RFP.isIsolated(F)) {
+		security_log(3, "Skipping non-revng function " << F.getName() << "...\n");
+		return PreservedAnalyses::all();
+	}
+
+	if (cache != nullptr) {
+		FunctionSecurityResult result = cache->getOrCompute(F, [&]() {
+			auto &LDP = FAM.getResult<LoopDependenciesAnalysis>(F);
+			auto &FPU = FAM.getResult<FunctionParamsUsageAnalysis>(F);
+			return FunctionSecurityResult(FPU.getPass(), LDP.getPass());
+		});
+		if (writer != nullptr) {
+			writer->writeFunction(F.getName(), SecurityWrapperPass::buildFunctionRecord(F, RFP.getPass(), result));
+		}
+		if (binaryWriter != nullptr) {
+			binaryWriter->writeFunction(SecurityWrapperPass::buildFunctionFindings(F, result));
+		}
+		SecurityWrapperPass::printFunctionInfo(F, result.isSafe, result.numRiskyStores);
+		return PreservedAnalyses::all();
+	}
+
+	auto &LDP = FAM.getResult<LoopDependenciesAnalysis>(F);
+	auto &FPU = FAM.getResult<FunctionParamsUsageAnalysis>(F);
+	if (writer != nullptr) {
+		writer->writeFunction(F.getName(), SecurityWrapperPass::buildFunctionRecord(F, RFP.getPass(), FPU.getPass(), LDP.getPass()));
+	}
+	if (binaryWriter != nullptr) {
+		binaryWriter->writeFunction(SecurityWrapperPass::buildFunctionFindings(F, LDP.getPass()));
+	}
+	SecurityWrapperPass::printFunctionInfo(F, LDP.getPass());
+	return PreservedAnalyses::all();
+}
+
+
+void revng::registerSecurityAnalyses(PassBuilder &PB) {
+	PB.registerAnalysisRegistrationCallback([](FunctionAnalysisManager &FAM) {
+		FAM.registerPass([] { return RevngFunctionParamsAnalysis(); });
+		FAM.registerPass([] { return FunctionParamsUsageAnalysis(); });
+		FAM.registerPass([] { return LoopDependenciesAnalysis(); });
+	});
+	PB.registerPipelineParsingCallback([](StringRef name, FunctionPassManager &FPM, ArrayRef<PassBuilder::PipelineElement>) {
+		if (name == "revng-security-analysis") {
+			// textual pipelines only print, the records need a writer
+			FPM.addPass(SecurityAnalysisPrinterPass(nullptr, nullptr, nullptr));
+			return true;
+		}
+		return false;
+	});
+}
+
+
+SecurityPipelinePass::SecurityPipelinePass() : ModulePass(ID) {
+}
+
+
+void SecurityPipelinePass::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.setPreservesAll();
+}
+
+
+bool SecurityPipelinePass::runOnModule(Module &M) {
+	std::unique_ptr<JSONResultWriter> resultWriter;
+	if (DumpAnalysis) {
+		resultWriter.reset(new JSONResultWriter(AnalysisOutputFilename, DumpFormat));
+		if (!resultWriter->isOpen()) {
+			security_log(1, "Cannot open " << AnalysisOutputFilename << ": " << resultWriter->getError().message() << "\n");
+		}
+	}
+	std::unique_ptr<BinaryResultWriter> binaryWriter;
+	if (!BinaryOutputFilename.empty()) {
+		binaryWriter.reset(new BinaryResultWriter(BinaryOutputFilename));
+	}
+	std::unique_ptr<FunctionResultCache> resultCache;
+	if (!SecurityCacheDir.empty()) {
+		resultCache.reset(new FunctionResultCache(SecurityCacheDir));
+	}
+
+	classifyFunctions(M);
+	LoopAnalysisManager LAM;
+	FunctionAnalysisManager FAM;
+	CGSCCAnalysisManager CGAM;
+	ModuleAnalysisManager MAM;
+	PassBuilder PB;
+	registerSecurityAnalyses(PB);
+	PB.registerModuleAnalyses(MAM);
+	PB.registerCGSCCAnalyses(CGAM);
+	PB.registerFunctionAnalyses(FAM);
+	PB.registerLoopAnalyses(LAM);
+	PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+	FunctionPassManager FPM;
+	FPM.addPass(SecurityAnalysisPrinterPass(resultWriter.get(), binaryWriter.get(), resultCache.get()));
+	ModulePassManager MPM;
+	MPM.addPass(createModuleToFunctionPassAdaptor(std::move(FPM)));
+	MPM.run(M, MAM);
+
+	if (resultWriter) {
+		SecurityWrapperPass::writeStatistics(*resultWriter);
+		resultWriter->close();
+	}
+	if (binaryWriter) {
+		SecurityWrapperPass::closeBinaryWriter(*binaryWriter);
+	}
+	flushSecurityLogs();
+	return false;
+}
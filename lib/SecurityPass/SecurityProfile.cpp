@@ -0,0 +1,76 @@
+#include "revng/SecurityPass/SecurityProfile.h"
+#include "revng/Support/Statistics.h"
+#include "llvm/Support/CommandLine.h"
+#include <mutex>
+
+using namespace llvm;
+using namespace revng;
+
+using StringIntCounter = CounterMap<std::string, uint64_t>;
+
+static cl::opt<unsigned int> SecurityProfileTop("security-profile-top", cl::desc("Number of slowest functions listed for each stage in the dumped results"), cl::init(10));
+
+namespace {
+
+	/// The counters of a stage
+	struct StageCounters {
+		explicit StageCounters(StringRef name) :
+			name(name),
+			time(name + "Time"),
+			defUseChains(name + "DefUseChains"),
+			storesVisited(name + "StoresVisited") {}
+
+		std::string name;
+		StringIntCounter time; // nanoseconds
+		StringIntCounter defUseChains;
+		StringIntCounter storesVisited;
+		uint64_t totalTime = 0;
+		uint64_t totalDefUseChains = 0;
+		uint64_t totalStoresVisited = 0;
+	};
+
+}
+
+static std::mutex ProfileMutex;
+
+// indexed by SecurityStage
+static StageCounters StageProfiles[] = {
+	StageCounters("RevngFunctionParams"),
+	StageCounters("FunctionParamsUsage"),
+	StageCounters("LoopDependencies")
+};
+
+SecurityStageTimer::~SecurityStageTimer() {
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+	std::lock_guard<std::mutex> lock(ProfileMutex);
+	StageCounters &counters = StageProfiles[static_cast<unsigned int>(stage)];
+	counters.time.push(function, nanoseconds);
+	counters.defUseChains.push(function, defUseChains);
+	counters.storesVisited.push(function, storesVisited);
+	counters.totalTime += nanoseconds;
+	counters.totalDefUseChains += defUseChains;
+	counters.totalStoresVisited += storesVisited;
+}
+
+json::Object revng::getSecurityProfile() {
+	std::lock_guard<std::mutex> lock(ProfileMutex);
+	json::Object profile;
+	for (StageCounters &counters : StageProfiles) {
+		json::Array slowest;
+		for (auto &entry : counters.time.top(SecurityProfileTop)) {
+			slowest.push_back(json::Object{
+				{ "function", entry.first },
+				{ "nanoseconds", int64_t(entry.second) },
+				{ "defUseChains", int64_t(counters.defUseChains.get(entry.first)) },
+				{ "storesVisited", int64_t(counters.storesVisited.get(entry.first)) } });
+		}
+		profile.try_emplace(counters.name, json::Object{
+			{ "functions", int64_t(counters.time.size()) },
+			{ "nanoseconds", int64_t(counters.totalTime) },
+			{ "defUseChains", int64_t(counters.totalDefUseChains) },
+			{ "storesVisited", int64_t(counters.totalStoresVisited) },
+			{ "slowestFunctions", std::move(slowest) } });
+	}
+	return profile;
+}
@@ -14,8 +14,14 @@ enum JSONOpts {
 
 
 cl::opt<bool> VerboseAnalysis("verbose-analysis", cl::desc("Write more informations about analysis"));
-cl::opt<std::string> AnalysisOutputFilename("dump-result-file", cl::desc("Specify output filename"), cl::value_desc("filename"));
-cl::opt<bool> DumpAnalysis("dump-result", cl::desc("Dump analysis results to json"), cl::value_desc("filename"));
+cl::opt<std::string> revng::AnalysisOutputFilename("dump-result-file", cl::desc("Specify output filename"), cl::value_desc("filename"));
+cl::opt<bool> revng::DumpAnalysis("dump-result", cl::desc("Dump analysis results to json"), cl::value_desc("filename"));
+cl::opt<JSONResultWriter::Format> revng::DumpFormat("dump-result-format", cl::desc("Layout of the dumped analysis results"),
+  cl::values(clEnumValN(JSONResultWriter::Object, "json", "A single JSON object, one member per function (default)"),
+	     clEnumValN(JSONResultWriter::Lines, "jsonl", "JSON Lines, one function per line")),
+  cl::init(JSONResultWriter::Object));
+cl::opt<std::string> revng::BinaryOutputFilename("dump-result-binary", cl::desc("Also dump compact binary results to this file"), cl::value_desc("filename"));
+cl::opt<std::string> revng::SecurityCacheDir("security-cache-dir", cl::desc("Reuse per-function results cached in this directory"), cl::value_desc("directory"));
 cl::bits<JSONOpts> JSONSectionsBits(cl::desc("JSON sections dumped"),
   cl::values(clEnumVal(fpu, "Dump function params usage pass to JSON"),
 	     clEnumVal(rfp, "Dump revng function params pass to json"),
@@ -31,72 +37,145 @@ SecurityWrapperPass::SecurityWrapperPass() : FunctionPass(ID) {
 
 
 bool SecurityWrapperPass::doInitialization(Module &M) {
-	AnalysisOutputJSON = new json::Object();
+	resultWriter.reset();
+	if (DumpAnalysis) {
+		resultWriter.reset(new JSONResultWriter(AnalysisOutputFilename, DumpFormat));
+		if (!resultWriter->isOpen()) {
+			security_log(1, "Cannot open " << AnalysisOutputFilename << ": " << resultWriter->getError().message() << "\n");
+		}
+	}
+	binaryWriter.reset();
+	if (!BinaryOutputFilename.empty()) {
+		binaryWriter.reset(new BinaryResultWriter(BinaryOutputFilename));
+	}
+	resultCache.reset();
+	if (!SecurityCacheDir.empty()) {
+		resultCache.reset(new FunctionResultCache(SecurityCacheDir));
+		cacheFPU.reset(new FunctionParamsUsagePass());
+		cacheLDP.reset(new LoopDependenciesPass());
+	}
 	return false;
 }
 
 
 bool SecurityWrapperPass::doFinalization(Module &M) {
 	// Add statistics to json
-	if (DumpAnalysis) {
-		json::ObjectKey statsKey("analysisStatistics");
-		json::Object stats;
-		if (AreStatisticsEnabled())
-		{
-			auto Stats = GetStatistics();
-			for( auto Stat : Stats) {
-				stats.try_emplace(std::get<0>(Stat), json::Value(std::get<1>(Stat)));
-			}
-			AnalysisOutputJSON->try_emplace(std::move(statsKey), std::move(stats));
-		}
-		json::Value valuewrp(std::move(*AnalysisOutputJSON));
-		std::error_code FileError;
-		StringRef FileName( AnalysisOutputFilename.c_str());
-		raw_fd_ostream Output(FileName, FileError, sys::fs::OpenFlags::OF_None);
-		if (!FileError)  {
-			Output << valuewrp;
-		}
+	if (resultWriter) {
+		writeStatistics(*resultWriter);
+		resultWriter->close();
+		resultWriter.reset();
 	}
+	if (binaryWriter) {
+		closeBinaryWriter(*binaryWriter);
+		binaryWriter.reset();
+	}
+	resultCache.reset();
+	cacheFPU.reset();
+	cacheLDP.reset();
+	flushSecurityLogs();
 	return false;
 
 }
 
+void SecurityWrapperPass::writeStatistics(JSONResultWriter &writer) {
+	writer.writeProfile(getSecurityProfile());
+	if (AreStatisticsEnabled())
+	{
+		json::Object stats;
+		auto Stats = GetStatistics();
+		for( auto Stat : Stats) {
+			stats.try_emplace(std::get<0>(Stat), json::Value(std::get<1>(Stat)));
+		}
+		writer.writeStatistics(std::move(stats));
+	}
+}
+
 bool SecurityWrapperPass::updateJSON(Function* F) {
-	get_print_stream(3) << "Updating json for " << F->getName() << "\n";
+	security_log(3, "Updating json for " << F->getName() << "\n");
 	assert( LDP != nullptr && "LDP analysis non obtained");
 	assert( FPU != nullptr && "FPU analysis non obtained");
 	assert( RFP != nullptr && "RFP analysis non obtained");
+	// the record goes to disk right away, nothing is kept across functions
+	return resultWriter->writeFunction(currentRF->getFunctionName(), buildFunctionRecord(*F, *RFP, *FPU, *LDP));
+}
+
+FunctionFindings SecurityWrapperPass::buildFunctionFindings(Function &F, const LoopDependenciesPass &LDP) {
+	FunctionFindings findings;
+	findings.name = F.getName().str();
+	findings.entryAddress = getFunctionEntryAddress(F);
+	findings.isMarked = isMarked(&F);
+	findings.isSafe = LDP.isFunctionSafe();
+	findings.numRiskyStores = LDP.getNumRiskyStores();
+	findings.loops = LDP.getLoopFindings();
+	return findings;
+}
+
+FunctionFindings SecurityWrapperPass::buildFunctionFindings(Function &F, const FunctionSecurityResult &result) {
+	FunctionFindings findings;
+	findings.name = F.getName().str();
+	findings.entryAddress = getFunctionEntryAddress(F);
+	findings.isMarked = isMarked(&F);
+	findings.isSafe = result.isSafe;
+	findings.numRiskyStores = result.numRiskyStores;
+	findings.loops = result.loops;
+	return findings;
+}
+
+void SecurityWrapperPass::closeBinaryWriter(BinaryResultWriter &writer) {
+	if (std::error_code error = writer.close()) {
+		security_log(1, "Cannot write " << BinaryOutputFilename << ": " << error.message() << "\n");
+	}
+}
+
+json::Value SecurityWrapperPass::buildFunctionRecord(Function &F, RevngFunctionParamsPass &RFP, FunctionParamsUsagePass &FPU, const LoopDependenciesPass &LDP) {
 	json::Object functionJSON;
 	if (JSONSectionsBits.isSet(ldp)) {
-		get_print_stream(3) << "Obtaining json from LoopDependencies pass...\n";
-		json::Value ldpJSON(LDP->toJSON()) ;
-		functionJSON.try_emplace("loopDependenciesAnalysis", ldpJSON);
+		security_log(3, "Obtaining json from LoopDependencies pass...\n");
+		functionJSON.try_emplace("loopDependenciesAnalysis", LDP.toJSON());
 	}
 	if (JSONSectionsBits.isSet(fpu)) {
-		get_print_stream(3) << "Obtaining json from FunctionParamsUsagePass pass...\n";
-		json::Value fpuJSON(FPU->toJSON());
-		functionJSON.try_emplace("functionParamsUsageAnalysis", fpuJSON);
+		security_log(3, "Obtaining json from FunctionParamsUsagePass pass...\n");
+		functionJSON.try_emplace("functionParamsUsageAnalysis", FPU.toJSON());
 	}
 	if (JSONSectionsBits.isSet(rfp)) {
-		get_print_stream(3) << "Obtaining json from RevngFunctionParams pass...\n";
-		json::Value rfpJSON(RFP->toJSON());
-		functionJSON.try_emplace("functionInfos", rfpJSON);
+		security_log(3, "Obtaining json from RevngFunctionParams pass...\n");
+		functionJSON.try_emplace("functionInfos", RFP.toJSON());
 	}
-	json::Value marked(isMarked(F));
-	json::Value safe(LDP->isFunctionSafe());
+	json::Value marked(isMarked(&F));
+	json::Value safe(LDP.isFunctionSafe());
 	// json::Value &bppSON  BPP.toJSON() ;
 	functionJSON.try_emplace("isMarked", marked);
 	functionJSON.try_emplace("isSafe", safe);
 	// functionJSON.try_emplace("backwardPropagationAnalysis", ldpJSON);
-	json::Value functionWrapped(std::move(functionJSON));
-	AnalysisOutputJSON->try_emplace(currentRF->getFunctionName(), functionWrapped);
-	return true;
+	return json::Value(std::move(functionJSON));
+}
+
+json::Value SecurityWrapperPass::buildFunctionRecord(Function &F, RevngFunctionParamsPass &RFP, const FunctionSecurityResult &result) {
+	// same layout as the record built from the live analyses
+	json::Object functionJSON;
+	if (JSONSectionsBits.isSet(ldp)) {
+		functionJSON.try_emplace("loopDependenciesAnalysis", result.loopDependencies);
+	}
+	if (JSONSectionsBits.isSet(fpu)) {
+		functionJSON.try_emplace("functionParamsUsageAnalysis", result.paramsUsage);
+	}
+	if (JSONSectionsBits.isSet(rfp)) {
+		functionJSON.try_emplace("functionInfos", RFP.toJSON());
+	}
+	functionJSON.try_emplace("isMarked", isMarked(&F));
+	functionJSON.try_emplace("isSafe", result.isSafe);
+	return json::Value(std::move(functionJSON));
 }
 
 void SecurityWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
 	AU.addRequired<RevngFunctionParamsPass>();
-	AU.addRequired<FunctionParamsUsagePass>();
-	AU.addRequired<LoopDependenciesPass>();
+	if (SecurityCacheDir.empty()) {
+		AU.addRequired<FunctionParamsUsagePass>();
+		AU.addRequired<LoopDependenciesPass>();
+	} else {
+		// the analyses are run by runWithCache, on misses only
+		AU.addRequired<LoopInfoWrapperPass>();
+	}
 	AU.setPreservesAll();
 }
 
@@ -108,27 +187,54 @@ bool SecurityWrapperPass::runOnFunction(Function &F) {
 	LDP = nullptr;
 	currentRF = nullptr;
 
-	get_print_stream(3) << "Starting SecurityWrapperPass on function " << F.getName() << "...\n";
+	security_log(3, "Starting SecurityWrapperPass on function " << F.getName() << "...\n");
 	currentRF = getAnalysis<RevngFunctionParamsPass>().getRevngFunction();
 	if(!(currentRF->getFunctionName() == F.getName() && currentRF->getType() == RevngFunction::TYPE::ISOLATED) ) {
-		get_print_stream(3) << "Skipping non-revng function " << F.getName() << "...\n";
+		security_log(3, "Skipping non-revng function " << F.getName() << "...\n");
 		return false;
 	}
 	if ( isaSkippedFunction(&F) || (!isMarked(&F) && only_marked_funs) ) {
-		get_print_stream(3) << "Skipping not marked function " << F.getName() << "...\n";
+		security_log(3, "Skipping not marked function " << F.getName() << "...\n");
+		return false;
+	}
+	if ( isOutsideInputSlice(&F) ) {
+		security_log(3, "Skipping function outside the input slice " << F.getName() << "...\n");
 		return false;
 	}
 	RFP = &(getAnalysis<RevngFunctionParamsPass>());
+	if (resultCache) {
+		return runWithCache(F);
+	}
 	FPU = &(getAnalysis<FunctionParamsUsagePass>());
 	LDP = &(getAnalysis<LoopDependenciesPass>());
-	if (DumpAnalysis) {
+	if (resultWriter) {
 	   updateJSON(&F);
 	}
+	if (binaryWriter) {
+		binaryWriter->writeFunction(buildFunctionFindings(F, *LDP));
+	}
 	printFunctionInfo(F);
 	return false;
 }
 
 
+bool SecurityWrapperPass::runWithCache(Function &F) {
+	FunctionSecurityResult result = resultCache->getOrCompute(F, [&]() {
+		cacheFPU->analyze(F, currentRF);
+		cacheLDP->analyze(F, currentRF, *cacheFPU, getAnalysis<LoopInfoWrapperPass>().getLoopInfo());
+		return FunctionSecurityResult(*cacheFPU, *cacheLDP);
+	});
+	if (resultWriter) {
+		resultWriter->writeFunction(currentRF->getFunctionName(), buildFunctionRecord(F, *RFP, result));
+	}
+	if (binaryWriter) {
+		binaryWriter->writeFunction(buildFunctionFindings(F, result));
+	}
+	printFunctionInfo(F, result.isSafe, result.numRiskyStores);
+	return false;
+}
+
+
 void SecurityWrapperPass::print(raw_ostream &OS, const Module *M) const {
 	if(!( RFP && FPU && LDP)) {
 		// has riksy stores?
@@ -139,15 +245,23 @@ void SecurityWrapperPass::print(raw_ostream &OS, const Module *M) const {
 
 void SecurityWrapperPass::printFunctionInfo(Function &F) const {
 	if(!( RFP && FPU && LDP)) {
-		get_print_stream(1) << "No result analysis for this function...\n";
+		security_log(1, "No result analysis for this function...\n");
+		return;
 	}
+	printFunctionInfo(F, *LDP);
+}
+
+void SecurityWrapperPass::printFunctionInfo(Function &F, const LoopDependenciesPass &LDP) {
+	printFunctionInfo(F, LDP.isFunctionSafe(), LDP.getNumRiskyStores());
+}
 
-	get_print_stream(1) << "===============================\n";
-	get_print_stream(1) << "Analysis Info for " << F.getName() << "\n";
-	get_print_stream(1) << "===============================\n";
-	get_print_stream(1) << "Is Function Safe: " << LDP->isFunctionSafe() << "\n";
-	get_print_stream(1) << "Is Function Marked: " << isMarked(&F) << "\n";
-	get_print_stream(1) << "Number of risky stores found: " << LDP->getNumRiskyStores() << "\n";
+void SecurityWrapperPass::printFunctionInfo(Function &F, bool isSafe, unsigned int numRiskyStores) {
+	security_log(1, "===============================\n");
+	security_log(1, "Analysis Info for " << F.getName() << "\n");
+	security_log(1, "===============================\n");
+	security_log(1, "Is Function Safe: " << isSafe << "\n");
+	security_log(1, "Is Function Marked: " << isMarked(&F) << "\n");
+	security_log(1, "Number of risky stores found: " << numRiskyStores << "\n");
 
 
 }
@@ -10,6 +10,7 @@
 
 // Local includes
 #include "Cache.h"
+#include "SummaryStore.h"
 
 using llvm::AllocaInst;
 using llvm::BasicBlock;
@@ -334,7 +335,8 @@ void Cache::assignCPUIndices(Function *F, GeneratedCodeBasicInfo *GCBI) {
 }
 
 Cache::Cache(Function *F, GeneratedCodeBasicInfo *GCBI) :
-  DefaultLinkRegister(nullptr) {
+  DefaultLinkRegister(nullptr),
+  Store(nullptr) {
   assignCPUIndices(F, GCBI);
   identifyPartialStores(F);
   identifyIdentityLoads(F);
@@ -356,8 +358,84 @@ Cache::Cache(Function *F, GeneratedCodeBasicInfo *GCBI) :
   }
 }
 
+std::unique_ptr<Cache> Cache::forkEmpty() const {
+  std::unique_ptr<Cache> Result(new Cache());
+  Result->LinkRegisters = LinkRegisters;
+  Result->DefaultLinkRegister = DefaultLinkRegister;
+  Result->IdentityLoads = IdentityLoads;
+  Result->IdentityStores = IdentityStores;
+  Result->CSVToIndexMap = CSVToIndexMap;
+  Result->IndexToCSVMap = IndexToCSVMap;
+  Result->CSVCount = CSVCount;
+  Result->Store = Store;
+  return Result;
+}
+
+void Cache::merge(Cache &&Other) {
+  for (auto &P : Other.Results) {
+    bool New = Results.emplace(P.first, std::move(P.second)).second;
+    revng_assert(New);
+  }
+  Other.Results.clear();
+
+  FakeFunctions.insert(Other.FakeFunctions.begin(), Other.FakeFunctions.end());
+  NoReturnFunctions.insert(Other.NoReturnFunctions.begin(),
+                           Other.NoReturnFunctions.end());
+  IndirectTailCallFunctions.insert(Other.IndirectTailCallFunctions.begin(),
+                                   Other.IndirectTailCallFunctions.end());
+  Fetched.insert(Other.Fetched.begin(), Other.Fetched.end());
+  Dirty.insert(Other.Dirty.begin(), Other.Dirty.end());
+}
+
+void Cache::fetch(BasicBlock *Function) const {
+  if (Store == nullptr or not Fetched.insert(Function).second)
+    return;
+
+  auto Stored = Store->load(Function);
+  if (not Stored)
+    return;
+
+  switch (Stored->Type) {
+  case FunctionType::Fake:
+    FakeFunctions.insert(Function);
+    break;
+  case FunctionType::NoReturn:
+    NoReturnFunctions.insert(Function);
+    break;
+  default:
+    break;
+  }
+
+  if (Stored->Summary)
+    Results.emplace(Function, std::move(*Stored->Summary));
+}
+
+void Cache::persist() const {
+  if (Store == nullptr)
+    return;
+
+  for (BasicBlock *Function : Dirty) {
+    FunctionType::Values Type = FunctionType::Regular;
+    if (FakeFunctions.count(Function) != 0)
+      Type = FunctionType::Fake;
+    else if (NoReturnFunctions.count(Function) != 0)
+      Type = FunctionType::NoReturn;
+
+    auto It = Results.find(Function);
+    const IntraproceduralFunctionSummary *Summary = nullptr;
+    if (It != Results.end())
+      Summary = &It->second;
+    else if (Type != FunctionType::Fake)
+      continue;
+
+    Store->store(Function, Type, Summary);
+  }
+}
+
 Optional<const IntraproceduralFunctionSummary *>
 Cache::get(BasicBlock *Function) const {
+  fetch(Function);
+
   auto It = Results.find(Function);
   if (It != Results.end())
     return { &It->second };
@@ -374,6 +452,9 @@ bool Cache::update(BasicBlock *Function,
     SaLog << DoLog;
   }
 
+  fetch(Function);
+  Dirty.insert(Function);
+
   auto It = Results.find(Function);
   if (It == Results.end()) {
     Results.emplace(std::make_pair(Function, Result.copy()));
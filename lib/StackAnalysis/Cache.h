@@ -1,6 +1,9 @@
 #ifndef CACHE_H
 #define CACHE_H
 
+// Standard includes
+#include <memory>
+
 // Local includes
 #include "Element.h"
 #include "IntraproceduralFunctionSummary.h"
@@ -9,6 +12,8 @@ class GeneratedCodeBasicInfo;
 
 namespace StackAnalysis {
 
+class SummaryStore;
+
 /// \brief Cache for the result of the analysis of a function
 ///
 /// This cache keeps track of three pieces of information:
@@ -16,10 +21,13 @@ namespace StackAnalysis {
 /// * the result of the analysis of a function.
 /// * the set of "fake", "noreturn" and "indirect tail call" functions.
 /// * the association between each function and its return register.
+///
+/// If a SummaryStore is associated, what is known about a function is loaded
+/// from it the first time the function is queried.
 class Cache {
 private:
   /// \brief For each function, the result of the intraprocedural analysis
-  std::map<llvm::BasicBlock *, IntraproceduralFunctionSummary> Results;
+  mutable std::map<llvm::BasicBlock *, IntraproceduralFunctionSummary> Results;
 
   /// \brief For each function, its link register (or nullptr for top of the
   ///        stack)
@@ -28,10 +36,19 @@ private:
   /// \brief The elected default link register (i.e., the most common)
   llvm::GlobalVariable *DefaultLinkRegister;
 
-  std::set<llvm::BasicBlock *> FakeFunctions;
-  std::set<llvm::BasicBlock *> NoReturnFunctions;
+  mutable std::set<llvm::BasicBlock *> FakeFunctions;
+  mutable std::set<llvm::BasicBlock *> NoReturnFunctions;
   std::set<llvm::BasicBlock *> IndirectTailCallFunctions;
 
+  /// \brief Persistent storage of the results, if any
+  SummaryStore *Store;
+
+  /// \brief Functions that have already been looked up in Store
+  mutable std::set<llvm::BasicBlock *> Fetched;
+
+  /// \brief Functions whose information changed since it has been loaded
+  std::set<llvm::BasicBlock *> Dirty;
+
   std::set<const llvm::LoadInst *> IdentityLoads;
   std::set<const llvm::StoreInst *> IdentityStores;
 
@@ -43,6 +60,27 @@ public:
   /// \brief Identify default storage for link register, identity loads
   Cache(llvm::Function *F, GeneratedCodeBasicInfo *GCBI);
 
+  /// \brief Create a cache with the same preprocessing information of this one
+  ///        but no results, to be filled by another thread
+  std::unique_ptr<Cache> forkEmpty() const;
+
+  /// \brief Import the results of \p Other
+  ///
+  /// \p Other must not have results about functions known to this cache,
+  /// which is the case if it was created by forkEmpty and used to analyze
+  /// functions whose analyses do not reach each other.
+  void merge(Cache &&Other);
+
+  /// \brief Load (and save) results from (and to) \p NewStore
+  void setStore(SummaryStore *NewStore) { Store = NewStore; }
+
+  /// \brief Save in the store the results that changed
+  void persist() const;
+
+  const std::map<int32_t, llvm::User *> &getCPUIndices() const {
+    return IndexToCSVMap;
+  }
+
   int32_t getCPUIndex(const llvm::User *U) const { return CSVToIndexMap.at(U); }
   bool isCPU(const llvm::User *U) const { return CSVToIndexMap.count(U) != 0; }
   bool isCSV(const llvm::User *U) const {
@@ -56,19 +94,23 @@ public:
   }
 
   bool isFakeFunction(llvm::BasicBlock *Function) const {
+    fetch(Function);
     return FakeFunctions.count(Function) != 0;
   }
 
   void markAsFake(llvm::BasicBlock *Function) {
     FakeFunctions.insert(Function);
+    Dirty.insert(Function);
   }
 
   bool isNoReturnFunction(llvm::BasicBlock *Function) const {
+    fetch(Function);
     return NoReturnFunctions.count(Function) != 0;
   }
 
   void markAsNoReturn(llvm::BasicBlock *Function) {
     NoReturnFunctions.insert(Function);
+    Dirty.insert(Function);
   }
 
   /// \brief Query the cache for the result of the analysis for a specific
@@ -117,6 +159,11 @@ public:
   }
 
 private:
+  Cache() : DefaultLinkRegister(nullptr), Store(nullptr), CSVCount(0) {}
+
+  /// \brief Import what \p Store knows about \p Function, the first time
+  void fetch(llvm::BasicBlock *Function) const;
+
   void assignCPUIndices(llvm::Function *F, GeneratedCodeBasicInfo *GCBI);
   void identifyPartialStores(const llvm::Function *F);
   void identifyIdentityLoads(const llvm::Function *F);
@@ -113,39 +113,50 @@ bool AddressSpace::lowerThanOrEqual(const AddressSpace &Other) const {
 
 template<bool Diff, bool EarlyExit>
 unsigned AddressSpace::cmp(const AddressSpace &Other, const Module *M) const {
+  // Shared content is trivially equal
+  if (ASOContent == Other.ASOContent)
+    return 0;
+
   LoggerIndent<> Y(SaDiffLog);
   unsigned Result = 0;
 
-  for (auto &P : ASOContent) {
-    auto It = Other.ASOContent.find(P.first);
+  // Both contents are sorted by offset, iterate in parallel
+  auto ThisIt = begin();
+  auto ThisEndIt = end();
+  auto OtherIt = Other.begin();
+  auto OtherEndIt = Other.end();
 
-    // Check if Other has it
-    if (It != Other.ASOContent.end()) {
-      // Check the actual value
-      ROA((P.second.cmp<Diff, EarlyExit>(It->second, M)), {
-        slot(P.first).dump(M, SaDiffLog);
+  while (ThisIt != ThisEndIt || OtherIt != OtherEndIt) {
+    if (OtherIt == OtherEndIt
+        || (ThisIt != ThisEndIt && ThisIt->first < OtherIt->first)) {
+      // Only this has it, that's fine
+      ThisIt++;
+    } else if (ThisIt == ThisEndIt || OtherIt->first < ThisIt->first) {
+      // TODO: assert this matters in the PruneLog
+      ROA(OtherIt->second.hasDirectContent(), {
+        slot(OtherIt->first).dump(M, SaDiffLog);
+        SaDiffLog << " is absent in the LHS and has direct content on the";
+        revng_log(SaDiffLog, " RHS");
+      });
+      OtherIt++;
+    } else {
+      // Both have it, check the actual value
+      ROA((ThisIt->second.cmp<Diff, EarlyExit>(OtherIt->second, M)), {
+        slot(ThisIt->first).dump(M, SaDiffLog);
         SaDiffLog << DoLog;
       });
+      ThisIt++;
+      OtherIt++;
     }
   }
 
-  for (auto &P : Other.ASOContent) {
-    auto It = ASOContent.find(P.first);
-    // TODO: assert this matters in the PruneLog
-    ROA(It == ASOContent.end() && P.second.hasDirectContent(), {
-      slot(P.first).dump(M, SaDiffLog);
-      SaDiffLog << " is absent in the LHS and has direct content on the";
-      revng_log(SaDiffLog, " RHS");
-    });
-  }
-
   return Result;
 }
 
 size_t AddressSpace::hash() const {
   size_t Result = 0;
 
-  for (auto &P : ASOContent) {
+  for (auto &P : content()) {
     Result = combineHash(Result, P.first);
     Result = combineHash(Result, std::hash<Value>()(P.second));
   }
@@ -158,7 +169,7 @@ std::set<ASSlot> Element::collectSlots(int32_t CSVCount) const {
   std::set<ASSlot> SlotsPool;
 
   if (State.size() > CPU.id())
-    for (auto &P : State[CPU.id()].ASOContent)
+    for (auto &P : State[CPU.id()])
       if (P.first < CSVCount)
         SlotsPool.insert(ASSlot::create(CPU, P.first));
 
@@ -220,15 +231,11 @@ Element &Element::combine(const Element &Other) {
 
 void Element::cleanup() {
   for (AddressSpace &AS : State) {
-    for (auto It = AS.ASOContent.begin(); It != AS.ASOContent.end(); /**/) {
-      if (const ASSlot *TheTag = It->second.tag()) {
-        if (*TheTag == ASSlot::create(AS.ID, It->first)) {
-          It = AS.ASOContent.erase(It);
-          continue;
-        }
-      }
-      It++;
-    }
+    ASID ID = AS.ID;
+    AS.eraseIf([ID](const std::pair<int32_t, Value> &P) {
+      const ASSlot *TheTag = P.second.tag();
+      return TheTag != nullptr and *TheTag == ASSlot::create(ID, P.first);
+    });
   }
 }
 
@@ -237,7 +244,7 @@ void Element::apply(const Element &Other) {
 
   ASID CPU = ASID::cpuID();
   const AddressSpace &OtherCPU = Other.State[CPU.id()];
-  for (auto &P : OtherCPU.ASOContent)
+  for (auto &P : OtherCPU)
     store(Value::fromSlot(CPU, P.first), P.second);
 }
 
@@ -246,7 +253,7 @@ std::set<ASSlot> Element::computeCalleeSavedSlots() const {
 
   unsigned I = 0;
   for (const AddressSpace &ASS : State) {
-    for (auto &P : ASS.ASOContent) {
+    for (auto &P : ASS) {
       // Do we have direct content with a name?
       if (const ASSlot *T = P.second.tag()) {
         // Is the name the same as the current slot?
@@ -264,43 +271,45 @@ std::set<ASSlot> Element::computeCalleeSavedSlots() const {
 
 void Element::mergeASState(AddressSpace &ThisState,
                            const AddressSpace &OtherState) {
-  // The following implementation can be easily replaced by any other
-  // implementation using a data structure allowing to iterate over a sorted
-  // pair of <ASO, *> pairs. In particular, instead of a std::map we could use
-  // a sorted std::vector of pairs.
-
-  // Iterate in parallel
-  auto ThisIt = ThisState.ASOContent.begin();
-  auto ThisEndIt = ThisState.ASOContent.end();
-  auto OtherIt = OtherState.ASOContent.begin();
-  auto OtherEndIt = OtherState.ASOContent.end();
-  std::vector<std::pair<int32_t, Value>> NewEntries;
+  auto IsEmpty = [](const std::pair<int32_t, Value> &P) {
+    return !P.second.hasDirectContent() && !P.second.hasTag();
+  };
+
+  // Combining an address space with itself only drops the empty slots
+  if (ThisState.ASOContent == OtherState.ASOContent) {
+    ThisState.eraseIf(IsEmpty);
+    return;
+  }
+
+  // Iterate in parallel over the sorted contents, producing a new one
+  auto ThisIt = ThisState.begin();
+  auto ThisEndIt = ThisState.end();
+  auto OtherIt = OtherState.begin();
+  auto OtherEndIt = OtherState.end();
+  AddressSpace::Container NewContent;
+  NewContent.reserve(std::max(ThisState.size(), OtherState.size()));
 
   bool ThisDone = ThisIt == ThisEndIt;
   bool OtherDone = OtherIt == OtherEndIt;
   while (!ThisDone || !OtherDone) {
-    Value *ThisContent = nullptr;
-    const Value *OtherContent = nullptr;
-    Value TmpContent = Value::empty();
+    int32_t Offset;
+    Value ThisContent = Value::empty();
+    Value OtherContent = Value::empty();
 
     if (ThisDone || (!OtherDone && ThisIt->first > OtherIt->first)) {
-      // Only Other has the current offset: create a new default entry for
-      // delayed appending in this and merge it with OtherContent
-      auto ASO = ASSlot::create(ThisState.id(), OtherIt->first);
-      NewEntries.emplace_back(OtherIt->first, ThisState.load(ASO));
-
-      ThisContent = &NewEntries.back().second;
-      OtherContent = &OtherIt->second;
+      // Only Other has the current offset: merge it with the default content
+      // of this
+      Offset = OtherIt->first;
+      ThisContent = ThisState.load(ThisState.slot(Offset));
+      OtherContent = OtherIt->second;
 
       OtherIt++;
     } else if (OtherDone || (!ThisDone && OtherIt->first > ThisIt->first)) {
-      // Only this has the current offset: create a default OtherContent and
-      // merge with ThisContent
-      auto ASO = ASSlot::create(OtherState.id(), ThisIt->first);
-      TmpContent = OtherState.load(ASO);
-
-      ThisContent = &ThisIt->second;
-      OtherContent = &TmpContent;
+      // Only this has the current offset: merge it with the default content
+      // of Other
+      Offset = ThisIt->first;
+      ThisContent = ThisIt->second;
+      OtherContent = OtherState.load(OtherState.slot(Offset));
 
       ThisIt++;
     } else {
@@ -308,32 +317,25 @@ void Element::mergeASState(AddressSpace &ThisState,
       revng_assert(ThisIt != ThisEndIt && OtherIt != OtherEndIt);
       revng_assert(ThisIt->first == OtherIt->first);
 
-      ThisContent = &ThisIt->second;
-      OtherContent = &OtherIt->second;
+      Offset = ThisIt->first;
+      ThisContent = ThisIt->second;
+      OtherContent = OtherIt->second;
 
       ThisIt++;
       OtherIt++;
     }
 
-    // Perform the merge
-    ThisContent->combine(*OtherContent);
+    // Perform the merge, dropping the slots we no longer know anything about
+    ThisContent.combine(OtherContent);
+    if (ThisContent.hasDirectContent() || ThisContent.hasTag())
+      NewContent.emplace_back(Offset, ThisContent);
 
     ThisDone = ThisIt == ThisEndIt;
     OtherDone = OtherIt == OtherEndIt;
   }
 
-  for (std::pair<int32_t, Value> &P : NewEntries)
-    ThisState.ASOContent[P.first] = P.second;
-
-  // Cleanup phase
-  for (auto It = ThisState.ASOContent.begin(); It != ThisState.ASOContent.end();
-       /**/) {
-
-    if (!It->second.hasDirectContent() && !It->second.hasTag())
-      It = ThisState.eraseASO(It);
-    else
-      It++;
-  }
+  // Keep sharing the storage if the result is unchanged or matches Other
+  ThisState.assign(std::move(NewContent), OtherState);
 }
 
 } // namespace Intraprocedural
@@ -2,7 +2,12 @@
 #define ELEMENT_H
 
 // Standard includes
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <set>
+#include <vector>
 
 // Local libraries includes
 #include "revng/ADT/LazySmallBitVector.h"
@@ -19,6 +24,8 @@ extern Logger<> SaVerboseLog;
 
 namespace StackAnalysis {
 
+class SummarySerializer;
+
 namespace Intraprocedural {
 
 /// \brief A Value represents the value associated by the analysis to an SSA
@@ -31,6 +38,8 @@ namespace Intraprocedural {
 /// callee-saved registers or if an indirect jump is targeting the value saved
 /// in the link register.
 class Value {
+  friend class ::StackAnalysis::SummarySerializer;
+
 private:
   ASSlot DirectContent;
   ASSlot TheTag;
@@ -139,17 +148,25 @@ public:
 ///
 /// An address space is composed by a set of <Offset, Value> pairs recording
 /// what are the possible values of the slot at the given offset.
+///
+/// The pairs are kept in a vector sorted by offset, which is shared among all
+/// the copies of an address space and duplicated only when one of them is
+/// about to be modified (copy-on-write). Since the analysis copies elements on
+/// each transfer and join, but usually alters a single address space, most of
+/// the copies are a matter of incrementing a reference count. An empty address
+/// space does not allocate anything.
 class AddressSpace {
   friend class Element;
 
 public:
-  using Container = std::map<int32_t, Value>;
+  using Container = std::vector<std::pair<int32_t, Value>>;
 
 private:
   /// Address space identifier
   ASID ID;
-  /// Map associating an offset within the address space with a Value
-  Container ASOContent;
+  /// Vector associating an offset within the address space with a Value,
+  /// sorted by offset. nullptr if empty.
+  std::shared_ptr<Container> ASOContent;
 
 public:
   AddressSpace(ASID ID) : ID(ID) {}
@@ -159,16 +176,10 @@ public:
   AddressSpace(AddressSpace &&) = default;
   AddressSpace &operator=(AddressSpace &&) = default;
 
-  ~AddressSpace() { AddressSpaceSizeStats.push(ASOContent.size()); }
-
-  using ASOContentIt = Container::iterator;
-  ASOContentIt eraseASO(ASOContentIt It) {
-    revng_assert(!It->second.hasDirectContent());
-    return ASOContent.erase(It);
-  }
+  ~AddressSpace() { AddressSpaceSizeStats.push(size()); }
 
   bool operator==(const AddressSpace &Other) const {
-    return ASOContent == Other.ASOContent;
+    return ASOContent == Other.ASOContent or content() == Other.content();
   }
 
   bool operator!=(const AddressSpace &Other) const { return !(*this == Other); }
@@ -181,15 +192,34 @@ public:
 
   size_t hash() const;
 
-  bool contains(int32_t Offset) const { return ASOContent.count(Offset) != 0; }
+  bool contains(int32_t Offset) const { return get(Offset) != nullptr; }
 
-  void set(int32_t Offset, Value V) { ASOContent[Offset] = V; }
+  void set(int32_t Offset, Value V) {
+    // Do not detach from the other copies if nothing changes
+    const Value *Old = get(Offset);
+    if (Old != nullptr and *Old == V)
+      return;
+
+    Container &Content = mutableContent();
+
+    // Fast path for the in-order insertions
+    if (Content.empty() or Content.back().first < Offset) {
+      Content.emplace_back(Offset, V);
+      return;
+    }
+
+    auto It = lowerBound(Content, Offset);
+    if (It != Content.end() and It->first == Offset)
+      It->second = V;
+    else
+      Content.emplace(It, Offset, V);
+  }
 
   ASID id() const { return ID; }
   ASSlot slot(int32_t Offset) const { return ASSlot::create(ID, Offset); }
 
-  Container::const_iterator begin() const { return ASOContent.begin(); }
-  Container::const_iterator end() const { return ASOContent.end(); }
+  Container::const_iterator begin() const { return content().begin(); }
+  Container::const_iterator end() const { return content().end(); }
 
   /// \brief Handle loading from a specific slot
   Value load(ASSlot Address) const {
@@ -207,7 +237,7 @@ public:
   }
 
   /// \brief Return the number of slots available in this state
-  size_t size() const { return ASOContent.size(); }
+  size_t size() const { return ASOContent ? ASOContent->size() : 0; }
 
   bool verify(ASID StateID) const { return StateID == ID; }
 
@@ -218,7 +248,7 @@ public:
     ID.dump(Output);
     Output << ":";
 
-    for (auto &P : ASOContent) {
+    for (auto &P : content()) {
       Output << "\n    ";
       ASSlot::dumpOffset(M, ID, P.first, Output);
       Output << ": ";
@@ -227,9 +257,79 @@ public:
   }
 
 private:
+  const Container &content() const {
+    static const Container Empty;
+    return ASOContent ? *ASOContent : Empty;
+  }
+
+  /// \brief Obtain a Container not shared with other address spaces
+  Container &mutableContent() {
+    if (not ASOContent) {
+      ASOContent = std::make_shared<Container>();
+    } else if (ASOContent.use_count() != 1) {
+      ASOContent = std::make_shared<Container>(*ASOContent);
+    } else {
+      // We're the sole owner: make sure the reads performed through the
+      // copies released by other threads happen before our writes
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    return *ASOContent;
+  }
+
+  /// \brief Replace the content with \p NewContent, sharing the storage with
+  ///        \p Other if they have the same content
+  void assign(Container &&NewContent, const AddressSpace &Other) {
+    if (NewContent == content())
+      return;
+
+    if (NewContent.empty())
+      ASOContent.reset();
+    else if (NewContent == Other.content())
+      ASOContent = Other.ASOContent;
+    else
+      ASOContent = std::make_shared<Container>(std::move(NewContent));
+  }
+
+  /// \brief Drop all the slots satisfying \p Predicate
+  template<typename F>
+  void eraseIf(F Predicate) {
+    // Do not detach from the other copies if nothing changes
+    const Container &Content = content();
+    if (std::none_of(Content.begin(), Content.end(), Predicate))
+      return;
+
+    Container &Mutable = mutableContent();
+    auto NewEnd = std::remove_if(Mutable.begin(), Mutable.end(), Predicate);
+    Mutable.erase(NewEnd, Mutable.end());
+    if (Mutable.empty())
+      ASOContent.reset();
+  }
+
+  static bool lessThanOffset(const std::pair<int32_t, Value> &P,
+                             int32_t Offset) {
+    return P.first < Offset;
+  }
+
+  static Container::iterator lowerBound(Container &Content, int32_t Offset) {
+    return std::lower_bound(Content.begin(),
+                            Content.end(),
+                            Offset,
+                            lessThanOffset);
+  }
+
+  static Container::const_iterator
+  lowerBound(const Container &Content, int32_t Offset) {
+    return std::lower_bound(Content.begin(),
+                            Content.end(),
+                            Offset,
+                            lessThanOffset);
+  }
+
   const Value *get(int32_t Offset) const {
-    auto It = ASOContent.find(Offset);
-    if (It == ASOContent.end())
+    const Container &Content = content();
+    auto It = lowerBound(Content, Offset);
+    if (It == Content.end() or It->first != Offset)
       return nullptr;
     else
       return &It->second;
@@ -241,13 +341,19 @@ private:
 /// This class basically keeps the state of all the address spaces being
 /// considered in the current analysis.
 class Element {
+  friend class ::StackAnalysis::SummarySerializer;
+
 public:
   using Container = llvm::SmallVector<AddressSpace, 2>;
+  using FrameSizeMap = std::map<CallSite, llvm::Optional<int32_t>>;
 
 private:
   // The following vector is indexed with ASID
   Container State;
-  std::map<CallSite, llvm::Optional<int32_t>> FrameSizeAtCallSite;
+  /// Height of the stack at each call site, shared among the copies and
+  /// duplicated before being modified, like the content of AddressSpace.
+  /// nullptr if empty.
+  std::shared_ptr<FrameSizeMap> FrameSizeAtCallSite;
 
 private:
   Element() {}
@@ -276,6 +382,9 @@ public:
 
   /// \note Copy constructor has been deleted, so that we don't accidentally
   ///       call it. Use this method instead.
+  ///
+  /// \note The content of the address spaces and the frame sizes are shared
+  ///       with the copy.
   Element copy() const {
     Element Result;
     Result.State = State;
@@ -308,6 +417,11 @@ public:
 
   bool isBottom() const { return State.size() == 0; }
 
+  const FrameSizeMap &frameSizeAtCallSite() const {
+    static const FrameSizeMap Empty;
+    return FrameSizeAtCallSite ? *FrameSizeAtCallSite : Empty;
+  }
+
   /// \brief Combine this lattice element with \p Other
   Element &combine(const Element &Other);
 
@@ -315,7 +429,7 @@ public:
   void cleanup();
 
   bool addressSpaceContainsTag(ASID AddressSpace, const ASSlot *TheTag) const {
-    for (auto &P : State[AddressSpace.id()].ASOContent)
+    for (auto &P : State[AddressSpace.id()])
       if (P.second.hasTag() && *P.second.tag() == *TheTag)
         return true;
 
@@ -328,7 +442,7 @@ public:
   std::set<int32_t> stackArguments(int32_t CallerStackSize) const {
     std::set<int32_t> Result;
     if (State.size() > 0)
-      for (auto &P : State[ASID::stackID().id()].ASOContent)
+      for (auto &P : State[ASID::stackID().id()])
         if (P.first >= 0)
           Result.insert(P.first - CallerStackSize);
 
@@ -396,6 +510,21 @@ public:
 private:
   /// \brief Implement the combine for AddressSpace
   void mergeASState(AddressSpace &ThisState, const AddressSpace &OtherState);
+
+  /// \brief Obtain a FrameSizeMap not shared with other elements
+  FrameSizeMap &mutableFrameSizeAtCallSite() {
+    if (not FrameSizeAtCallSite) {
+      FrameSizeAtCallSite = std::make_shared<FrameSizeMap>();
+    } else if (FrameSizeAtCallSite.use_count() != 1) {
+      auto &Shared = *FrameSizeAtCallSite;
+      FrameSizeAtCallSite = std::make_shared<FrameSizeMap>(Shared);
+    } else {
+      // See AddressSpace::mutableContent
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+
+    return *FrameSizeAtCallSite;
+  }
 };
 
 } // namespace Intraprocedural
@@ -947,7 +947,9 @@ class Analysis
                              Element<E>,
                              IsForward ? ReversePostOrder : PostOrder,
                              ABIIRBasicBlock::links_const_range,
-                             Interrupt<E>> {
+                             Interrupt<E>,
+                             false,
+                             true> {
 
 private:
   using DirectedLabelRange = typename conditional<IsForward,
@@ -960,7 +962,9 @@ public:
                                  Element<E>,
                                  IsForward ? ReversePostOrder : PostOrder,
                                  ABIIRBasicBlock::links_const_range,
-                                 Interrupt<E>>;
+                                 Interrupt<E>,
+                                 false,
+                                 true>;
 
 private:
   /// The entry basic block of the function
@@ -1036,7 +1040,7 @@ public:
 
   Interrupt<E> transfer(ABIIRBasicBlock *BB) {
     revng_log(SaABI, "Analyzing " << BB->basicBlock());
-    Element<E> Result = this->State[BB].copy();
+    Element<E> Result = this->getState(BB)->copy();
 
     VisitsCount++;
 
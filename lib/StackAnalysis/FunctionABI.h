@@ -153,6 +153,7 @@ class Element;
 }
 
 class ABIFunction;
+class SummarySerializer;
 
 struct CombineHelper {
 
@@ -307,6 +308,8 @@ inline void dumpAnalysis(T &Output, const char *Prefix, const V &Analysis) {
 /// \brief State of a register in terms of being an argument or a return value
 ///        in a certain call site
 class CallSiteRegisterState {
+  friend class SummarySerializer;
+
 private:
   RegisterArgumentsOfFunctionCall RAOFC;
   UsedReturnValuesOfFunctionCall URVOFC;
@@ -398,6 +401,8 @@ CallSiteRegisterState::getByType() const {
 
 /// \brief State of a register in terms of being an argument or a return value
 class RegisterState {
+  friend class SummarySerializer;
+
 private:
   // Core analyses
   DeadRegisterArgumentsOfFunction DRAOF;
@@ -537,6 +542,7 @@ inline const RegisterArgumentsOfFunctionCall &RegisterState::getByType() const {
 class FunctionABI {
   template<typename Enabled>
   friend class ABIAnalysis::Element;
+  friend class SummarySerializer;
 
 private:
   struct CallsAnalyses {
@@ -263,14 +263,17 @@ void ResultsPool::mergeFunction(BasicBlock *Function,
   const Module *M = getModule(Function);
   size_t CSVCount = std::distance(M->global_begin(), M->global_end());
 
-  LocallyWrittenRegisters[Function] = Summary.WrittenRegisters;
+  FunctionRecord &Record = getFunction(Function);
+  Record.LocallyWrittenRegisters = Summary.WrittenRegisters;
 
   // Merge results from the arguments analyses
   const FunctionABI &ABI = Summary.ABI;
   auto &Slots = Summary.LocalSlots;
   for (auto &Slot : Slots) {
     int32_t Offset = Slot.first.offset();
-    FunctionSlot Key = { Function, Offset };
+    FunctionRegisterDescription &Description = Record.Slots[Offset];
+    FRA &Argument = Description.Argument;
+    FRV &ReturnValue = Description.ReturnValue;
 
     revng_assert(Slot.first.addressSpace() == ASID::cpuID()
                  and Offset <= static_cast<int32_t>(CSVCount));
@@ -279,57 +282,56 @@ void ResultsPool::mergeFunction(BasicBlock *Function,
     case LocalSlotType::UsedRegister:
     case LocalSlotType::ForwardedArgument:
     case LocalSlotType::ForwardedReturnValue:
-      ABI.applyResults(FunctionRegisterArguments[Key], Offset);
-      ABI.applyResults(FunctionReturnValues[Key], Offset);
+      ABI.applyResults(Argument, Offset);
+      ABI.applyResults(ReturnValue, Offset);
 
       // Handle forwarded arguments/return values (push rax; pop rdx)
       if (Slot.second == LocalSlotType::ForwardedArgument
-          && FunctionRegisterArguments[Key].value() == FRA::Yes) {
-        FunctionRegisterArguments[Key] = FRA::maybe();
+          && Argument.value() == FRA::Yes) {
+        Argument = FRA::maybe();
       }
 
       if (Slot.second == LocalSlotType::ForwardedReturnValue
-          && (FunctionReturnValues[Key].value() == FRV::YesOrDead)) {
-        FunctionReturnValues[Key] = FRV::maybe();
+          && (ReturnValue.value() == FRV::YesOrDead)) {
+        ReturnValue = FRV::maybe();
       }
 
       break;
 
     case LocalSlotType::ExplicitlyCalleeSavedRegister:
-      FunctionRegisterArguments[Key] = FRA::no();
-      FunctionReturnValues[Key] = FRV::no();
-      ExplicitlyCalleeSavedRegisters[Function].insert(Slot.first.offset());
+      Argument = FRA::no();
+      ReturnValue = FRV::no();
+      Record.ExplicitlyCalleeSavedRegisters.insert(Slot.first.offset());
       break;
     }
 
-    for (auto &P : CallSites) {
-      CallSite Call = P.first;
-
-      if (!Call.belongsTo(Function))
-        continue;
-
-      FunctionCallSlot K = { Call, Offset };
-      Instruction *I = Call.callInstruction();
+    for (unsigned Index : Record.CallSites) {
+      CallSiteRecord &CallRecord = CallSites[Index];
+      Instruction *I = CallRecord.Call.callInstruction();
       FunctionCall TheCall = { getFunctionCallCallee(I->getParent()), I };
 
+      FunctionCallRegisterDescription &CallSlot = CallRecord.Slots[Offset];
+      FCRA &CallArgument = CallSlot.Argument;
+      FCRV &CallReturnValue = CallSlot.ReturnValue;
+
       switch (Slot.second) {
       case LocalSlotType::UsedRegister:
       case LocalSlotType::ForwardedArgument:
       case LocalSlotType::ForwardedReturnValue:
       case LocalSlotType::ExplicitlyCalleeSavedRegister:
 
-        ABI.applyResults(FunctionCallRegisterArguments[K], TheCall, Offset);
-        ABI.applyResults(FunctionCallReturnValues[K], TheCall, Offset);
+        ABI.applyResults(CallArgument, TheCall, Offset);
+        ABI.applyResults(CallReturnValue, TheCall, Offset);
 
         // Handle forwarded arguments/return values (push rax; pop rdx)
         if (Slot.second == LocalSlotType::ForwardedArgument
-            && FunctionCallRegisterArguments[K].value() == FCRA::Yes) {
-          FunctionCallRegisterArguments[K] = FCRA::maybe();
+            && CallArgument.value() == FCRA::Yes) {
+          CallArgument = FCRA::maybe();
         }
 
         if (Slot.second == LocalSlotType::ForwardedReturnValue
-            && FunctionCallReturnValues[K].value() == FCRV::Yes) {
-          FunctionCallReturnValues[K] = FCRV::maybe();
+            && CallReturnValue.value() == FCRV::Yes) {
+          CallReturnValue = FCRV::maybe();
         }
       }
     }
@@ -339,23 +341,27 @@ void ResultsPool::mergeFunction(BasicBlock *Function,
 void ResultsPool::mergeBranches(BasicBlock *Function,
                                 const BasicBlockTypeMap &Branches) {
   // Merge information about the branches type
+  FunctionRecord &Record = getFunction(Function);
   for (auto &P : Branches)
-    BranchesType[{ Function, P.first->getTerminator() }] = P.second;
+    Record.BranchesType[P.first] = P.second;
 }
 
 void ResultsPool::mergeCallSites(BasicBlock *Entry,
                                  const StackSizeMap &ToImport) {
+  FunctionRecord &Record = getFunction(Entry);
   for (auto &P : ToImport) {
-    FunctionCalls[Entry].push_back(P.first);
-    CallSite Call = { Entry, P.first.callInstruction() };
-    auto It = CallSites.find(Call);
-    if (It != CallSites.end()) {
-      if (!compareOptional(It->second, P.second)) {
+    Record.FunctionCalls.push_back(P.first);
+    Instruction *I = P.first.callInstruction();
+    auto It = CallSiteIndices.find({ Entry, I });
+    if (It != CallSiteIndices.end()) {
+      if (!compareOptional(CallSites[It->second].StackHeight, P.second)) {
         revng_abort("This call site has a stack at a different height than"
                     " previously recorded");
       }
     } else {
-      CallSites[Call] = P.second;
+      CallSiteIndices[{ Entry, I }] = CallSites.size();
+      Record.CallSites.push_back(CallSites.size());
+      CallSites.emplace_back(CallSite(Entry, I), P.second);
     }
   }
 }
@@ -417,9 +423,18 @@ struct ClobberedRegistersAnalysis {
     auto &Clobbered = Result.Clobbered;
     auto &ECSVotes = Result.ECSVotes;
 
-    // Loop over all the functions
-    for (auto &P : This.FunctionTypes) {
-      BasicBlock *Function = P.first;
+    static const std::vector<FunctionCall> NoFunctionCalls;
+    auto GetFunctionCalls = [&This](BasicBlock *Function) {
+      const ResultsPool::FunctionRecord *Record = This.findFunction(Function);
+      return Record == nullptr ? &NoFunctionCalls : &Record->FunctionCalls;
+    };
+
+    // Loop over all the registered functions
+    for (const ResultsPool::FunctionRecord &Record : This.Functions) {
+      if (Record.Type == FunctionType::Invalid)
+        continue;
+
+      BasicBlock *Function = Record.Entry;
 
       // Have we handled this already?
       if (Clobbered.count(Function) != 0)
@@ -448,10 +463,9 @@ struct ClobberedRegistersAnalysis {
       std::set<BasicBlock *> InProgress;
 
       // Initialize the worklist
-      const auto &FunctionCallsList = This.FunctionCalls[Function];
       WorkList.emplace_back(Function,
-                            FunctionCallsList.begin(),
-                            FunctionCallsList.end());
+                            Record.FunctionCalls.begin(),
+                            Record.FunctionCalls.end());
       InProgress.insert(Function);
 
       // Loop over the worklist
@@ -480,10 +494,10 @@ struct ClobberedRegistersAnalysis {
             auto ClobberedIt = Clobbered.find(Callee);
             if (ClobberedIt == Clobbered.end()) {
               // No, push it on the worklist
-              const auto &FunctionCallsList = This.FunctionCalls[Callee];
+              const auto *FunctionCallsList = GetFunctionCalls(Callee);
               WorkList.emplace_back(Callee,
-                                    FunctionCallsList.begin(),
-                                    FunctionCallsList.end());
+                                    FunctionCallsList->begin(),
+                                    FunctionCallsList->end());
               InProgress.insert(Callee);
 
               // Early exit so we can proceed from the callee
@@ -505,29 +519,29 @@ struct ClobberedRegistersAnalysis {
         if (Current.CallIt == Current.EndCallIt) {
           // Oh, we're done
 
-          {
-            // Add all the locally written registers
-            auto It = This.LocallyWrittenRegisters.find(Function);
-            if (It != This.LocallyWrittenRegisters.end())
-              CurrentClobbered.insert(It->second.begin(), It->second.end());
-          }
+          const ResultsPool::FunctionRecord *Done;
+          Done = This.findFunction(Function);
+
+          // Add all the locally written registers
+          if (Done != nullptr)
+            CurrentClobbered.insert(Done->LocallyWrittenRegisters.begin(),
+                                    Done->LocallyWrittenRegisters.end());
 
           // Increase the counter associated to each written register
           for (int32_t Index : CurrentClobbered)
             ECSVotes[Index].Total++;
 
-          {
-            // Erase from the clobbered registers all the callee-saved, if any
-            auto It = This.ExplicitlyCalleeSavedRegisters.find(Function);
-            if (It != This.ExplicitlyCalleeSavedRegisters.end()) {
-              // Do not use CurrentClobbered.erase(BeginIt, EndIt);
-              for (int32_t Index : It->second)
-                CurrentClobbered.erase(Index);
-
-              // Increase the counter associated to each register
-              for (int32_t Index : It->second)
-                ECSVotes[Index].ECS++;
-            }
+          // Erase from the clobbered registers all the callee-saved, if any
+          if (Done != nullptr) {
+            const auto &CalleeSaved = Done->ExplicitlyCalleeSavedRegisters;
+
+            // Do not use CurrentClobbered.erase(BeginIt, EndIt);
+            for (int32_t Index : CalleeSaved)
+              CurrentClobbered.erase(Index);
+
+            // Increase the counter associated to each register
+            for (int32_t Index : CalleeSaved)
+              ECSVotes[Index].ECS++;
           }
 
           // Pop from the worklist
@@ -579,14 +593,13 @@ struct ClobberedRegistersAnalysis {
 };
 
 FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
-  ASID CPU = ASID::cpuID();
-
   // Create the result data structure
   FunctionsSummary Result;
 
   // Set function types
-  for (auto &P : FunctionTypes)
-    Result.Functions[P.first].Type = P.second;
+  for (const FunctionRecord &Record : Functions)
+    if (Record.Type != FunctionType::Invalid)
+      Result.Functions[Record.Entry].Type = Record.Type;
 
   // Compute the set of registers clobbered by each function
   ClobberedRegistersAnalysis::ClobberedMap Clobbered;
@@ -598,107 +611,122 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
   }
 
   // Register block types
-  for (auto &P : BranchesType) {
-    BasicBlock *BB = P.first.branch()->getParent();
-    Result.Functions[P.first.entry()].BasicBlocks[BB] = P.second;
+  for (const FunctionRecord &Record : Functions) {
+    if (Record.BranchesType.empty())
+      continue;
+
+    auto &BasicBlocks = Result.Functions[Record.Entry].BasicBlocks;
+    for (auto &P : Record.BranchesType)
+      BasicBlocks[P.first] = P.second;
   }
 
   using CallSiteDescription = FunctionsSummary::CallSiteDescription;
+  using SlotIterator = SlotRecords<FunctionCallRegisterDescription>::
+    const_iterator;
+
+  /// \brief A call site targeting a certain function, along with a cursor on
+  ///        its slots
+  struct Caller {
+    const CallSiteRecord *Record;
+    CallSiteDescription *Description;
+    SlotIterator Slot;
+    /// \brief Status of the slot currently being merged
+    const FunctionCallRegisterDescription *Status;
+  };
 
   //
-  // Collect, for each call site, all the slots and create a CallSiteDescription
+  // Create a CallSiteDescription for each call site and group them by callee
   //
-  struct FunctionCallSites {
-    /// \brief Collect all the slots used by the function/its callers
-    std::set<ASSlot> Slots;
-    /// \brief The callers
-    std::map<CallSite, CallSiteDescription *> CallSites;
-  };
-  std::map<BasicBlock *, FunctionCallSites> FunctionCallSitesMap;
-
-  auto &FCRA = FunctionCallRegisterArguments;
-  auto &FCRV = FunctionCallReturnValues;
-  auto &FRA = FunctionRegisterArguments;
-  auto &FRV = FunctionReturnValues;
-
-  for (auto &P : FRA) {
-    BasicBlock *FunctionEntry = P.first.first;
-    FunctionCallSites &FCS = FunctionCallSitesMap[FunctionEntry];
-    auto Slot = ASSlot::create(CPU, P.first.second);
-    FCS.Slots.insert(Slot);
-  }
-
-  for (auto &P : FRV) {
-    BasicBlock *FunctionEntry = P.first.first;
-    FunctionCallSites &FCS = FunctionCallSitesMap[FunctionEntry];
-    auto Slot = ASSlot::create(CPU, P.first.second);
-    FCS.Slots.insert(Slot);
-  }
-
-  // Go over arguments of function calls
-  for (auto &P : FCRA) {
-    const CallSite &TheCallSite = P.first.first;
-    auto Slot = ASSlot::create(CPU, P.first.second);
-    BasicBlock *CallerBB = TheCallSite.callInstruction()->getParent();
-    BasicBlock *Callee = getFunctionCallCallee(CallerBB);
-    FunctionCallSites &FCS = FunctionCallSitesMap[Callee];
-
-    // Register the slot
-    FCS.Slots.insert(Slot);
-
-    // Check if we already created the CallSiteDescription
-    auto It = FCS.CallSites.find(TheCallSite);
-    if (It == FCS.CallSites.end()) {
-      auto &CallerCallSites = Result.Functions[TheCallSite.caller()].CallSites;
-      Instruction *I = TheCallSite.callInstruction();
-      CallerCallSites.emplace_back(I, Callee);
-      FCS.CallSites[TheCallSite] = &CallerCallSites.back();
-      revng_assert(FCS.CallSites[TheCallSite] == &CallerCallSites.back());
-    }
-  }
-
-  // Go over return values of function calls
-  for (auto &P : FCRV) {
-    const CallSite &TheCallSite = P.first.first;
-    auto Slot = ASSlot::create(CPU, P.first.second);
-    BasicBlock *CallerBB = TheCallSite.callInstruction()->getParent();
-    BasicBlock *Callee = getFunctionCallCallee(CallerBB);
-    FunctionCallSites &FCS = FunctionCallSitesMap[Callee];
-    FCS.Slots.insert(Slot);
+  llvm::DenseMap<BasicBlock *, std::vector<Caller>> CallersMap;
+  for (const CallSiteRecord &Record : CallSites) {
+    if (Record.Slots.empty())
+      continue;
+
+    const CallSite &TheCallSite = Record.Call;
+    Instruction *I = TheCallSite.callInstruction();
+    BasicBlock *Callee = getFunctionCallCallee(I->getParent());
+
+    auto &CallerCallSites = Result.Functions[TheCallSite.caller()].CallSites;
+    CallerCallSites.emplace_back(I, Callee);
+    CallSiteDescription *Description = &CallerCallSites.back();
+    CallersMap[Callee].push_back({ &Record,
+                                   Description,
+                                   Record.Slots.begin(),
+                                   nullptr });
   }
 
   //
   // Merge information about a function and all the call sites targeting it
   //
+  const FunctionRegisterDescription NoFunctionSlot;
+  const FunctionCallRegisterDescription NoCallSlot;
+  const SlotRecords<FunctionRegisterDescription> NoSlots;
 
   // For each function
   for (auto &P : Result.Functions) {
     BasicBlock *FunctionEntry = P.first;
 
-    // Integrate slots from each call site
-    FunctionCallSites &FCS = FunctionCallSitesMap[FunctionEntry];
+    const FunctionRecord *Record = findFunction(FunctionEntry);
+    const auto &Slots = Record == nullptr ? NoSlots : Record->Slots;
+    auto FunctionSlotIt = Slots.begin();
+
+    std::vector<Caller> NoCallers;
+    auto CallersIt = CallersMap.find(FunctionEntry);
+    std::vector<Caller> &Callers = (CallersIt == CallersMap.end() ?
+                                      NoCallers :
+                                      CallersIt->second);
+
+    // Iterate over each slot used by the function or by one of its callers, in
+    // ascending order: all the slot records are sorted, perform a linear merge
+    while (true) {
+      llvm::Optional<int32_t> Next;
+      auto Consider = [&Next](int32_t Offset) {
+        if (not Next or Offset < *Next)
+          Next = Offset;
+      };
+
+      if (FunctionSlotIt != Slots.end())
+        Consider(FunctionSlotIt->first);
+      for (Caller &C : Callers)
+        if (C.Slot != C.Record->Slots.end())
+          Consider(C.Slot->first);
+
+      if (not Next)
+        break;
+
+      int32_t Offset = *Next;
+
+      // Advance the cursors sitting on this slot
+      bool CalleeHasSlot = (FunctionSlotIt != Slots.end()
+                            and FunctionSlotIt->first == Offset);
+      const FunctionRegisterDescription *FunctionSlotPtr = &NoFunctionSlot;
+      if (CalleeHasSlot) {
+        FunctionSlotPtr = &FunctionSlotIt->second;
+        ++FunctionSlotIt;
+      }
+      const FunctionRegisterDescription &FunctionSlot = *FunctionSlotPtr;
+
+      for (Caller &C : Callers) {
+        if (C.Slot != C.Record->Slots.end() and C.Slot->first == Offset) {
+          C.Status = &C.Slot->second;
+          ++C.Slot;
+        } else {
+          C.Status = &NoCallSlot;
+        }
+      }
 
-    // Iterate over each slot
-    for (ASSlot Slot : FCS.Slots) {
-      revng_assert(Slot.addressSpace() == CPU);
-      int32_t Offset = Slot.offset();
       if (not TheCache->isCSVIndex(Offset))
         continue;
 
       GlobalVariable *CSV = TheCache->getCSVByIndex(Offset);
-      FunctionSlot TheFunctionSlot{ FunctionEntry, Offset };
 
-      bool CalleeHasSlot = FRA.count(TheFunctionSlot) != 0;
       if (FunctionEntry == nullptr or not CalleeHasSlot) {
-        for (auto &Q : FCS.CallSites) {
-          CallSiteDescription &TheCallSiteDescription = *Q.second;
-          auto &CallSiteRegister = TheCallSiteDescription.RegisterSlots[CSV];
-          const CallSite &TheCallSite = Q.first;
-          FunctionCallSlot FCS{ TheCallSite, Offset };
+        for (Caller &C : Callers) {
+          auto &CallSiteRegister = C.Description->RegisterSlots[CSV];
 
-          CallSiteRegister.Argument = FCRA[FCS];
+          CallSiteRegister.Argument = C.Status->Argument;
           CallSiteRegister.Argument.notAvailable();
-          CallSiteRegister.ReturnValue = FCRV[FCS];
+          CallSiteRegister.ReturnValue = C.Status->ReturnValue;
           CallSiteRegister.ReturnValue.notAvailable();
 
           if (FunctionEntry != nullptr) {
@@ -719,7 +747,7 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
         //
 
         // Register status at the function
-        const FunctionRegisterArgument &FunctionStatus = FRA[TheFunctionSlot];
+        const FunctionRegisterArgument &FunctionStatus = FunctionSlot.Argument;
         auto Status = FunctionStatus.value();
         revng_assert(Status == FunctionRegisterArgument::Maybe
                      or Status == FunctionRegisterArgument::NoOrDead
@@ -731,14 +759,11 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
         // at least a call site we have Yes information before the merge)
         bool AtLeastAYes = false;
 
-        for (auto &Q : FCS.CallSites) {
-          const CallSite &TheCallSite = Q.first;
-          revng_assert(Q.second != nullptr);
-          CallSiteDescription &TheCallSiteDescription = *Q.second;
-          FunctionCallSlot FCS{ TheCallSite, Offset };
+        for (Caller &C : Callers) {
+          CallSiteDescription &TheCallSiteDescription = *C.Description;
 
           // Register status at current call site
-          const FunctionCallRegisterArgument &CallerStatus = FCRA[FCS];
+          const FunctionCallRegisterArgument &CallerStatus = C.Status->Argument;
           auto Status = CallerStatus.value();
           revng_assert(Status == FunctionCallRegisterArgument::Maybe
                        or Status == FunctionCallRegisterArgument::Yes);
@@ -828,7 +853,7 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
         //
 
         // Register status at the function
-        const FunctionReturnValue &FunctionStatus = FRV[TheFunctionSlot];
+        const FunctionReturnValue &FunctionStatus = FunctionSlot.ReturnValue;
         auto Status = FunctionStatus.value();
         revng_assert(Status == FunctionReturnValue::Maybe
                      or Status == FunctionReturnValue::No
@@ -837,13 +862,11 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
         // Propagate information from the function to callers (and record if at
         // least on call sites says Yes or Dead)
         bool AtLeastAYesOrDead = false;
-        for (auto &Q : FCS.CallSites) {
-          const CallSite &TheCallSite = Q.first;
-          auto &TheCallSiteDescription = *Q.second;
-          FunctionCallSlot FCS{ TheCallSite, Offset };
+        for (Caller &C : Callers) {
+          auto &TheCallSiteDescription = *C.Description;
 
           // Register status at current call site
-          const FunctionCallReturnValue &CallerStatus = FCRV[FCS];
+          const FunctionCallReturnValue &CallerStatus = C.Status->ReturnValue;
           auto Status = CallerStatus.value();
           revng_assert(Status == FunctionCallReturnValue::Maybe
                        or Status == FunctionCallReturnValue::NoOrDead
@@ -899,9 +922,9 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
           // If at least a call site states that this slot is a return value,
           // all the other call sites can benefit from this information
 
-          for (auto &Q : FCS.CallSites) {
+          for (Caller &C : Callers) {
             using FCReturnValue = FunctionCallReturnValue;
-            auto &TheCallSiteDescription = *Q.second;
+            auto &TheCallSiteDescription = *C.Description;
             auto &Value = TheCallSiteDescription.RegisterSlots[CSV].ReturnValue;
             switch (Value.value()) {
             case FCReturnValue::NoOrDead:
@@ -926,7 +949,7 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
         FunctionReturnValue Result = FunctionStatus;
         using FCReturnValue = FunctionCallReturnValue;
 
-        if (FCS.CallSites.size() > 0) {
+        if (Callers.size() > 0) {
           // At this point the information associated to the call sites is
           // either all "No", one of "Yes", "Dead" and "YesOrDead" or one of
           // "NoOrDead" and "Maybe"
@@ -936,11 +959,11 @@ FunctionsSummary ResultsPool::finalize(Module *M, Cache *TheCache) {
 
           // Initialize the result to propagate to the callee with the first
           // call site
-          auto BeginIt = FCS.CallSites.begin();
-          auto Accumulate = BeginIt->second->RegisterSlots[CSV].ReturnValue;
+          CallSiteDescription *First = Callers.begin()->Description;
+          auto Accumulate = First->RegisterSlots[CSV].ReturnValue;
 
-          for (auto &Q : FCS.CallSites) {
-            auto &TheCallSiteDescription = *Q.second;
+          for (Caller &C : Callers) {
+            auto &TheCallSiteDescription = *C.Description;
             auto &Value = TheCallSiteDescription.RegisterSlots[CSV].ReturnValue;
 
             AllNo = AllNo and Value.value() == FCReturnValue::No;
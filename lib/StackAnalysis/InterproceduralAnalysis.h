@@ -6,11 +6,13 @@
 //
 
 // Standard includes
+#include <algorithm>
 #include <map>
 #include <set>
 #include <vector>
 
 // LLVM includes
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/BasicBlock.h"
@@ -53,38 +55,102 @@ public:
   using StackSizeMap = map<FunctionCall, llvm::Optional<int32_t>>;
 
 private:
-  using FunctionSlot = std::pair<BasicBlock *, int32_t>;
-  using FunctionCallSlot = std::pair<CallSite, int32_t>;
+  /// \brief Records about the registers of a function or a call site, sorted
+  ///        by CPU slot offset
+  template<typename T>
+  class SlotRecords {
+  public:
+    using Record = std::pair<int32_t, T>;
+    using const_iterator = typename std::vector<Record>::const_iterator;
+
+  private:
+    std::vector<Record> Records;
+
+  public:
+    /// \brief Get the record of \p Offset, creating it if necessary
+    T &operator[](int32_t Offset) {
+      auto It = std::lower_bound(Records.begin(), Records.end(), Offset, less);
+      if (It == Records.end() or It->first != Offset)
+        It = Records.insert(It, { Offset, T() });
+      return It->second;
+    }
 
-private:
-  // TODO: maps with the same keys could be merged
+    const T *find(int32_t Offset) const {
+      auto It = std::lower_bound(Records.begin(), Records.end(), Offset, less);
+      if (It == Records.end() or It->first != Offset)
+        return nullptr;
+      return &It->second;
+    }
+
+    bool empty() const { return Records.empty(); }
+    const_iterator begin() const { return Records.begin(); }
+    const_iterator end() const { return Records.end(); }
+
+  private:
+    static bool less(const Record &R, int32_t Offset) {
+      return R.first < Offset;
+    }
+  };
+
+  using FunctionRegisterDescription = FunctionsSummary::
+    FunctionRegisterDescription;
+  using FunctionCallRegisterDescription = FunctionsSummary::
+    FunctionCallRegisterDescription;
+
+  /// \brief All the information about a function
+  struct FunctionRecord {
+    FunctionRecord(BasicBlock *Entry) :
+      Entry(Entry),
+      Type(FunctionType::Invalid) {}
+
+    BasicBlock *Entry;
+
+    /// \brief Classification of the function, Invalid if not registered
+    FunctionType::Values Type;
+
+    /// \brief Status of each register as an argument and a return value
+    SlotRecords<FunctionRegisterDescription> Slots;
+
+    /// \brief Indices of the call sites of this function in CallSites
+    std::vector<unsigned> CallSites;
+
+    /// \brief Classification of each branch
+    llvm::DenseMap<BasicBlock *, BranchType::Values> BranchesType;
+
+    std::set<int32_t> LocallyWrittenRegisters;
+    std::set<int32_t> ExplicitlyCalleeSavedRegisters;
+    std::vector<FunctionCall> FunctionCalls;
+  };
 
-  // Data about functions
-  map<FunctionSlot, FunctionRegisterArgument> FunctionRegisterArguments;
-  map<FunctionSlot, FunctionReturnValue> FunctionReturnValues;
+  /// \brief All the information about a call site
+  struct CallSiteRecord {
+    CallSiteRecord(CallSite Call, llvm::Optional<int32_t> StackHeight) :
+      Call(Call),
+      StackHeight(StackHeight) {}
 
-  // Data about function calls
-  using FCS = FunctionCallSlot;
-  map<FCS, FunctionCallRegisterArgument> FunctionCallRegisterArguments;
-  map<FCS, FunctionCallReturnValue> FunctionCallReturnValues;
+    CallSite Call;
 
-  /// \brief Height of the stack at each call site
-  map<CallSite, llvm::Optional<int32_t>> CallSites;
+    /// \brief Height of the stack at the call site
+    llvm::Optional<int32_t> StackHeight;
 
-  /// \brief Classification of each branch
-  map<Branch, BranchType::Values> BranchesType;
+    /// \brief Status of each register as an argument and a return value
+    SlotRecords<FunctionCallRegisterDescription> Slots;
+  };
 
-  /// \brief Classification of each function
-  map<BasicBlock *, FunctionType::Values> FunctionTypes;
+private:
+  /// \brief The functions, in the order they have been first met
+  std::vector<FunctionRecord> Functions;
+  llvm::DenseMap<BasicBlock *, unsigned> FunctionIndices;
 
-  map<BasicBlock *, std::set<int32_t>> LocallyWrittenRegisters;
-  map<BasicBlock *, std::set<int32_t>> ExplicitlyCalleeSavedRegisters;
-  map<BasicBlock *, std::vector<FunctionCall>> FunctionCalls;
+  /// \brief The call sites, in the order they have been first met
+  std::vector<CallSiteRecord> CallSites;
+  using CallSiteKey = std::pair<BasicBlock *, llvm::Instruction *>;
+  llvm::DenseMap<CallSiteKey, unsigned> CallSiteIndices;
 
 public:
   /// \brief Register a function for which a summary is not available
   void registerFunction(llvm::BasicBlock *Function, FunctionType::Values Type) {
-    FunctionTypes[Function] = Type;
+    getFunction(Function).Type = Type;
   }
 
   void registerFunction(llvm::BasicBlock *Entry,
@@ -126,14 +192,11 @@ public:
   template<typename T>
   void dump(const llvm::Module *M, T &Output) const {
     Output << "CallSites:\n";
-    for (auto &P : CallSites) {
-      const CallSite &TheCallSite = P.first;
-      llvm::Optional<int32_t> StackHeight = P.second;
-
-      TheCallSite.dump(Output);
+    for (const CallSiteRecord &Record : CallSites) {
+      Record.Call.dump(Output);
       Output << ": ";
-      if (StackHeight)
-        Output << *StackHeight;
+      if (Record.StackHeight)
+        Output << *Record.StackHeight;
       else
         Output << "unknown";
 
@@ -141,44 +204,52 @@ public:
     }
 
     Output << "FunctionRegisterArguments:\n";
-    for (auto &P : FunctionRegisterArguments) {
-      Output << getName(P.first.first) << " ";
-      ASSlot::create(ASID::cpuID(), P.first.second).dump(M, Output);
-      Output << ": ";
-      P.second.dump(Output);
-      Output << "\n";
+    for (const FunctionRecord &Record : Functions) {
+      for (auto &P : Record.Slots) {
+        Output << getName(Record.Entry) << " ";
+        ASSlot::create(ASID::cpuID(), P.first).dump(M, Output);
+        Output << ": ";
+        P.second.Argument.dump(Output);
+        Output << "\n";
+      }
     }
     Output << "\n";
 
     Output << "FunctionReturnValues:\n";
-    for (auto &P : FunctionReturnValues) {
-      Output << getName(P.first.first) << " ";
-      ASSlot::create(ASID::cpuID(), P.first.second).dump(M, Output);
-      Output << ": ";
-      P.second.dump(Output);
-      Output << "\n";
+    for (const FunctionRecord &Record : Functions) {
+      for (auto &P : Record.Slots) {
+        Output << getName(Record.Entry) << " ";
+        ASSlot::create(ASID::cpuID(), P.first).dump(M, Output);
+        Output << ": ";
+        P.second.ReturnValue.dump(Output);
+        Output << "\n";
+      }
     }
     Output << "\n";
 
     Output << "FunctionCallRegisterArguments:\n";
-    for (auto &P : FunctionCallRegisterArguments) {
-      P.first.first.dump(Output);
-      Output << " ";
-      ASSlot::create(ASID::cpuID(), P.first.second).dump(M, Output);
-      Output << ": ";
-      P.second.dump(Output);
-      Output << "\n";
+    for (const CallSiteRecord &Record : CallSites) {
+      for (auto &P : Record.Slots) {
+        Record.Call.dump(Output);
+        Output << " ";
+        ASSlot::create(ASID::cpuID(), P.first).dump(M, Output);
+        Output << ": ";
+        P.second.Argument.dump(Output);
+        Output << "\n";
+      }
     }
     Output << "\n";
 
     Output << "FunctionCallReturnValues:\n";
-    for (auto &P : FunctionCallReturnValues) {
-      P.first.first.dump(Output);
-      Output << " ";
-      ASSlot::create(ASID::cpuID(), P.first.second).dump(M, Output);
-      Output << ": ";
-      P.second.dump(Output);
-      Output << "\n";
+    for (const CallSiteRecord &Record : CallSites) {
+      for (auto &P : Record.Slots) {
+        Record.Call.dump(Output);
+        Output << " ";
+        ASSlot::create(ASID::cpuID(), P.first).dump(M, Output);
+        Output << ": ";
+        P.second.ReturnValue.dump(Output);
+        Output << "\n";
+      }
     }
     Output << "\n";
   }
@@ -186,10 +257,29 @@ public:
   /// \brief Build a set of all the `BasicBlock`s that have been visited so far
   std::set<llvm::BasicBlock *> visitedBlocks() const {
     std::set<llvm::BasicBlock *> Result;
-    for (auto &P : BranchesType)
-      Result.insert(P.first.branch()->getParent());
+    for (const FunctionRecord &Record : Functions)
+      for (auto &P : Record.BranchesType)
+        Result.insert(P.first);
     return Result;
   }
+
+private:
+  FunctionRecord &getFunction(BasicBlock *Entry) {
+    auto It = FunctionIndices.find(Entry);
+    if (It != FunctionIndices.end())
+      return Functions[It->second];
+
+    FunctionIndices[Entry] = Functions.size();
+    Functions.emplace_back(Entry);
+    return Functions.back();
+  }
+
+  const FunctionRecord *findFunction(BasicBlock *Entry) const {
+    auto It = FunctionIndices.find(Entry);
+    if (It == FunctionIndices.end())
+      return nullptr;
+    return &Functions[It->second];
+  }
 };
 
 /// \brief Interprocedural part of the stack analysis
@@ -50,6 +50,9 @@ RunningStatistics ABIRegistersCountStats("ABIRegistersCount");
 static RunningStatistics CacheHitRate("CacheHitRate");
 
 /// \brief Per-function cache hit rate
+///
+/// Only collected for SaInterpLog: with a logger enabled the analysis is
+/// sequential.
 static std::map<BasicBlock *, RunningStatistics> FunctionCacheHitRate;
 
 /// \brief Round \p Value to \p Digits
@@ -903,18 +906,19 @@ Interrupt Analysis::handleCall(Instruction *Caller,
       const char *ResultString = nullptr;
       if (CacheEntry) {
         CacheHitRate.push(1);
-        FunctionCacheHitRate[Callee].push(1);
         ResultString = "hit";
       } else {
         CacheHitRate.push(0);
-        FunctionCacheHitRate[Callee].push(0);
         ResultString = "miss";
       }
 
       if (SaInterpLog.isEnabled()) {
+        RunningStatistics &FunctionHitRate = FunctionCacheHitRate[Callee];
+        FunctionHitRate.push(CacheEntry ? 1 : 0);
+
         SaInterpLog << "Cache " << ResultString << " for " << Callee << " at "
                     << Caller << " (";
-        auto Mean = FunctionCacheHitRate[Callee].mean();
+        auto Mean = FunctionHitRate.mean();
         SaInterpLog << "function hit rate: " << round(100 * Mean, 4) << "%";
         SaInterpLog << ", hit rate: " << round(100 * CacheHitRate.mean(), 4)
                     << "%) ";
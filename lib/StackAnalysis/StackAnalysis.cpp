@@ -8,12 +8,18 @@
 //
 
 // Standard includes
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <map>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 // LLVM includes
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/IntEqClasses.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
 #include "llvm/Pass.h"
 
@@ -21,13 +27,18 @@
 #include "revng/StackAnalysis/StackAnalysis.h"
 #include "revng/Support/CommandLine.h"
 #include "revng/Support/IRHelpers.h"
+#include "revng/Support/Statistics.h"
 
 // Local includes
 #include "Cache.h"
 #include "InterproceduralAnalysis.h"
 #include "Intraprocedural.h"
+#include "SummaryStore.h"
 
 using llvm::BasicBlock;
+using llvm::BlockAddress;
+using llvm::CallInst;
+using llvm::dyn_cast;
 using llvm::Function;
 using llvm::Module;
 using llvm::RegisterPass;
@@ -68,6 +79,142 @@ static opt<std::string> ABIAnalysisOutputPath("abi-analysis-output",
                                               value_desc("path"),
                                               cat(MainCategory));
 
+static opt<unsigned> Threads("stack-analysis-threads",
+                             desc("Number of threads analyzing independent "
+                                  "functions (0 = one per core)"),
+                             init(1),
+                             cat(MainCategory));
+
+static opt<std::string> StoreDirectory("stack-analysis-store",
+                                       desc("Directory where the results of "
+                                            "the analysis of each function are "
+                                            "saved and reused across runs"),
+                                       value_desc("path"),
+                                       cat(MainCategory));
+
+/// \brief Group \p Entries so that the analyses of different groups never
+///        reach the same basic block
+///
+/// The footprint of a function is the set of basic blocks reachable from its
+/// entry without going through the dispatcher, plus the callees and return
+/// addresses of the function calls it performs. This over-approximates what
+/// the analysis of the function (including its callees) visits, and therefore
+/// the entries of the Cache it reads or writes.
+///
+/// Each basic block is explored only once: reaching a block explored from
+/// another entry joins the two groups, since everything reachable from there
+/// is already part of the footprint of the other one.
+///
+/// \return the groups, each with the entries in the original order.
+static std::vector<std::vector<BasicBlock *>>
+groupByFootprint(const std::vector<BasicBlock *> &Entries,
+                 GeneratedCodeBasicInfo &GCBI) {
+  llvm::DenseMap<BasicBlock *, unsigned> Owner;
+  llvm::IntEqClasses Groups(Entries.size());
+  std::vector<BasicBlock *> WorkList;
+
+  for (unsigned I = 0; I < Entries.size(); I++) {
+    WorkList.push_back(Entries[I]);
+    while (not WorkList.empty()) {
+      BasicBlock *BB = WorkList.back();
+      WorkList.pop_back();
+
+      auto It = Owner.try_emplace(BB, I);
+      if (not It.second) {
+        if (It.first->second != I)
+          Groups.join(I, It.first->second);
+        continue;
+      }
+
+      if (CallInst *Call = GCBI.getFunctionCall(BB)) {
+        if (auto *Callee = dyn_cast<BlockAddress>(Call->getArgOperand(0)))
+          WorkList.push_back(Callee->getBasicBlock());
+        if (auto *Return = dyn_cast<BlockAddress>(Call->getArgOperand(1)))
+          WorkList.push_back(Return->getBasicBlock());
+      }
+
+      for (BasicBlock *Successor : llvm::successors(BB)) {
+        switch (GCBI.getType(Successor)) {
+        case BlockType::DispatcherBlock:
+        case BlockType::DispatcherFailureBlock:
+        case BlockType::AnyPCBlock:
+        case BlockType::UnexpectedPCBlock:
+          break;
+        default:
+          WorkList.push_back(Successor);
+        }
+      }
+    }
+  }
+
+  Groups.compress();
+  std::vector<std::vector<BasicBlock *>> Result(Groups.getNumClasses());
+  for (unsigned I = 0; I < Entries.size(); I++)
+    Result[Groups[I]].push_back(Entries[I]);
+  return Result;
+}
+
+/// \brief Analyze \p Entries, in order, on multiple threads
+///
+/// Entries are grouped so that the analyses of different groups touch
+/// disjoint entries of the Cache: each worker owns a Cache of its own and
+/// analyzes whole groups, then the caches are merged in \p TheCache. The
+/// results are the same as analyzing the entries one after the other.
+///
+/// Workers also record statistics privately, they are merged after the join.
+static void analyzeInParallel(const std::vector<BasicBlock *> &Entries,
+                              Cache &TheCache,
+                              GeneratedCodeBasicInfo &GCBI,
+                              bool AnalyzeABI,
+                              unsigned ThreadsCount) {
+  std::vector<std::vector<BasicBlock *>> Groups;
+  Groups = groupByFootprint(Entries, GCBI);
+
+  // Start from the largest groups, so that they do not end up last
+  auto Larger = [](const std::vector<BasicBlock *> &A,
+                   const std::vector<BasicBlock *> &B) {
+    return A.size() > B.size();
+  };
+  std::stable_sort(Groups.begin(), Groups.end(), Larger);
+
+  ThreadsCount = std::min<size_t>(ThreadsCount, Groups.size());
+  revng_log(StackAnalysisLog,
+            "Analyzing " << Groups.size() << " groups of functions on "
+                         << ThreadsCount << " threads");
+
+  std::vector<std::unique_ptr<Cache>> Caches;
+  for (unsigned I = 0; I < ThreadsCount; I++)
+    Caches.push_back(TheCache.forkEmpty());
+  std::vector<ThreadStatistics> Statistics(ThreadsCount);
+
+  std::atomic<size_t> NextGroup(0);
+  auto Worker = [&](unsigned Index) {
+    Cache &WorkerCache = *Caches[Index];
+    ThreadStatistics::Scope PrivateStatistics(Statistics[Index]);
+
+    // The pool is not used by the interprocedural analysis, but it's not
+    // shared either
+    ResultsPool Unused;
+    for (size_t I = NextGroup++; I < Groups.size(); I = NextGroup++) {
+      for (BasicBlock *Entry : Groups[I]) {
+        InterproceduralAnalysis SA(WorkerCache, GCBI, AnalyzeABI);
+        SA.run(Entry, Unused);
+      }
+    }
+  };
+
+  std::vector<std::thread> Pool;
+  for (unsigned I = 0; I < ThreadsCount; I++)
+    Pool.emplace_back(Worker, I);
+  for (std::thread &Thread : Pool)
+    Thread.join();
+
+  for (std::unique_ptr<Cache> &WorkerCache : Caches)
+    TheCache.merge(std::move(*WorkerCache));
+  for (ThreadStatistics &WorkerStatistics : Statistics)
+    WorkerStatistics.merge();
+}
+
 template<bool AnalyzeABI>
 bool StackAnalysis<AnalyzeABI>::runOnModule(Module &M) {
   Function &F = *M.getFunction("root");
@@ -122,16 +269,50 @@ bool StackAnalysis<AnalyzeABI>::runOnModule(Module &M) {
   // Initialize the cache where all the results will be accumulated
   Cache TheCache(&F, &GCBI);
 
+  // Reuse the results of previous runs on the unchanged functions
+  std::unique_ptr<SummaryStore> Store;
+  if (not StoreDirectory.empty()) {
+    Store.reset(new SummaryStore(StoreDirectory,
+                                 &F,
+                                 &GCBI,
+                                 TheCache,
+                                 AnalyzeABI));
+    TheCache.setStore(Store.get());
+  }
+
   // Pool where the final results will be collected
   ResultsPool Results;
 
+  unsigned ThreadsCount = Threads;
+  if (ThreadsCount == 0)
+    ThreadsCount = std::max(1U, std::thread::hardware_concurrency());
+
+  // Logs are meant to be read in order
+  if (Loggers->anyEnabled())
+    ThreadsCount = 1;
+
   // First analyze all the `Force`d functions (i.e., with an explicit direct
   // call)
-  for (CFEP &Function : Functions) {
-    if (Function.Force) {
-      auto &GCBI = getAnalysis<GeneratedCodeBasicInfo>();
-      InterproceduralAnalysis SA(TheCache, GCBI, AnalyzeABI);
-      SA.run(Function.Entry, Results);
+  if (ThreadsCount > 1) {
+    // Looking up a metadata kind by name registers it the first time, which
+    // writes to the context: make sure the workers only read it
+    llvm::LLVMContext &Context = M.getContext();
+    for (const char *Kind : { BlockTypeMDName, JTReasonMDName, "noreturn" })
+      Context.getMDKindID(Kind);
+
+    std::vector<BasicBlock *> Forced;
+    for (CFEP &Function : Functions)
+      if (Function.Force)
+        Forced.push_back(Function.Entry);
+
+    analyzeInParallel(Forced, TheCache, GCBI, AnalyzeABI, ThreadsCount);
+  } else {
+    for (CFEP &Function : Functions) {
+      if (Function.Force) {
+        auto &GCBI = getAnalysis<GeneratedCodeBasicInfo>();
+        InterproceduralAnalysis SA(TheCache, GCBI, AnalyzeABI);
+        SA.run(Function.Entry, Results);
+      }
     }
   }
 
@@ -146,6 +327,8 @@ bool StackAnalysis<AnalyzeABI>::runOnModule(Module &M) {
     }
   }
 
+  TheCache.persist();
+
   for (CFEP &Function : Functions) {
     using IFS = IntraproceduralFunctionSummary;
     BasicBlock *Entry = Function.Entry;
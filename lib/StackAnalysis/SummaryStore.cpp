@@ -0,0 +1,856 @@
+/// \file SummaryStore.cpp
+/// \brief Persistent storage of the results of the intraprocedural analysis
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+// Standard includes
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
+// LLVM includes
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Local libraries includes
+#include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
+
+// Local includes
+#include "Cache.h"
+#include "SummaryStore.h"
+
+using llvm::APInt;
+using llvm::BasicBlock;
+using llvm::BlockAddress;
+using llvm::CallInst;
+using llvm::CmpInst;
+using llvm::Constant;
+using llvm::ConstantExpr;
+using llvm::ConstantInt;
+using llvm::dyn_cast;
+using llvm::Function;
+using llvm::GetElementPtrInst;
+using llvm::GlobalValue;
+using llvm::Instruction;
+using llvm::MD5;
+using llvm::MemoryBuffer;
+using llvm::Optional;
+using llvm::SmallString;
+using llvm::StringRef;
+using llvm::Type;
+using llvm::User;
+
+static Logger<> SaStoreLog("sa-store");
+
+/// \brief Bump whenever the analysis, or the layout of the entries, change
+static const uint32_t SummaryStoreVersion = 1;
+
+static const char SummaryStoreMagic[4] = { 'R', 'S', 'A', 'S' };
+
+namespace StackAnalysis {
+
+/// \brief Serialize and deserialize IntraproceduralFunctionSummary
+///
+/// Basic blocks are identified by their name, instructions by the name of
+/// their basic block and their position within it.
+class SummarySerializer {
+private:
+  using IFS = IntraproceduralFunctionSummary;
+
+  class Writer {
+  private:
+    llvm::raw_ostream &OS;
+
+  public:
+    Writer(llvm::raw_ostream &OS) : OS(OS) {}
+
+    template<typename T,
+             typename = std::enable_if_t<std::is_integral<T>::value>>
+    void write(T Value) {
+      llvm::support::endian::write(OS, Value, llvm::support::little);
+    }
+
+    void write(StringRef String) {
+      write<uint32_t>(String.size());
+      OS << String;
+    }
+
+    void write(const BasicBlock *BB) {
+      write(BB == nullptr ? StringRef() : BB->getName());
+    }
+
+    void write(const Instruction *I) {
+      if (I == nullptr) {
+        write(static_cast<const BasicBlock *>(nullptr));
+        return;
+      }
+
+      const BasicBlock *BB = I->getParent();
+      write(BB);
+      write<uint32_t>(std::distance(BB->begin(), I->getIterator()));
+    }
+
+    void write(ASSlot Slot) {
+      write<uint32_t>(Slot.addressSpace().id());
+      write<int32_t>(Slot.offset());
+    }
+
+    void write(const Optional<int32_t> &Size) {
+      write<uint8_t>(Size.hasValue());
+      write<int32_t>(Size.hasValue() ? *Size : 0);
+    }
+  };
+
+  class Reader {
+  private:
+    const SummaryStore &Store;
+    StringRef Buffer;
+    bool Failed;
+
+  public:
+    Reader(const SummaryStore &Store, StringRef Buffer) :
+      Store(Store),
+      Buffer(Buffer),
+      Failed(false) {}
+
+    bool failed() const { return Failed; }
+    bool atEnd() const { return Buffer.empty(); }
+
+    /// \brief Mark the entry as unreadable, any further read returns zeros
+    void fail() {
+      Failed = true;
+      Buffer = StringRef();
+    }
+
+    template<typename T>
+    T read() {
+      if (Buffer.size() < sizeof(T)) {
+        fail();
+        return T();
+      }
+
+      using namespace llvm::support;
+      T Result = endian::read<T, little, unaligned>(Buffer.data());
+      Buffer = Buffer.drop_front(sizeof(T));
+      return Result;
+    }
+
+    StringRef readString() {
+      uint32_t Size = read<uint32_t>();
+      if (Buffer.size() < Size) {
+        fail();
+        return StringRef();
+      }
+
+      StringRef Result = Buffer.take_front(Size);
+      Buffer = Buffer.drop_front(Size);
+      return Result;
+    }
+
+    BasicBlock *readBasicBlock() {
+      StringRef Name = readString();
+      if (Name.empty())
+        return nullptr;
+
+      BasicBlock *Result = Store.getBasicBlock(Name);
+      if (Result == nullptr)
+        fail();
+      return Result;
+    }
+
+    Instruction *readInstruction() {
+      BasicBlock *BB = readBasicBlock();
+      if (BB == nullptr)
+        return nullptr;
+
+      uint32_t Index = read<uint32_t>();
+      if (Index >= BB->size()) {
+        fail();
+        return nullptr;
+      }
+
+      return &*std::next(BB->begin(), Index);
+    }
+
+    ASSlot readSlot() {
+      uint32_t ID = read<uint32_t>();
+      int32_t Offset = read<int32_t>();
+      if (ID >= ASID::invalidID().id()) {
+        if (ID != ASID::invalidID().id())
+          fail();
+        return ASSlot::invalid();
+      }
+
+      return ASSlot::create(ASID(ID), Offset);
+    }
+
+    Optional<int32_t> readSize() {
+      bool HasValue = read<uint8_t>() != 0;
+      int32_t Size = read<int32_t>();
+      if (HasValue)
+        return Size;
+      return Optional<int32_t>();
+    }
+
+    template<typename E>
+    E readEnum() {
+      return static_cast<E>(read<uint8_t>());
+    }
+  };
+
+public:
+  static void write(llvm::raw_ostream &OS,
+                    FunctionType::Values Type,
+                    const IFS *Summary) {
+    Writer W(OS);
+    OS.write(SummaryStoreMagic, sizeof(SummaryStoreMagic));
+    W.write<uint32_t>(SummaryStoreVersion);
+    W.write<uint8_t>(Type);
+    W.write<uint8_t>(Summary != nullptr);
+    if (Summary != nullptr)
+      write(W, *Summary);
+  }
+
+  static Optional<SummaryStore::StoredFunction>
+  read(const SummaryStore &Store, StringRef Buffer) {
+    StringRef Magic(SummaryStoreMagic, sizeof(SummaryStoreMagic));
+    if (not Buffer.startswith(Magic))
+      return Optional<SummaryStore::StoredFunction>();
+
+    Reader R(Store, Buffer.drop_front(Magic.size()));
+    if (R.read<uint32_t>() != SummaryStoreVersion)
+      return Optional<SummaryStore::StoredFunction>();
+
+    SummaryStore::StoredFunction Result;
+    Result.Type = R.readEnum<FunctionType::Values>();
+    if (R.read<uint8_t>() != 0)
+      Result.Summary = read(R);
+
+    if (R.failed() or not R.atEnd())
+      return Optional<SummaryStore::StoredFunction>();
+
+    return { std::move(Result) };
+  }
+
+private:
+  static void write(Writer &W, const IFS &Summary) {
+    W.write<uint8_t>(Summary.Type);
+    write(W, Summary.FinalState);
+    write(W, Summary.ABI);
+
+    W.write<uint32_t>(Summary.LocalSlots.size());
+    for (const IFS::LocalSlot &Slot : Summary.LocalSlots) {
+      W.write(Slot.first);
+      W.write<uint8_t>(Slot.second);
+    }
+
+    W.write<uint32_t>(Summary.FrameSizeAtCallSite.size());
+    for (auto &P : Summary.FrameSizeAtCallSite) {
+      W.write(P.first.callee());
+      W.write(P.first.callInstruction());
+      W.write(P.second);
+    }
+
+    W.write<uint32_t>(Summary.BranchesType.size());
+    for (auto &P : Summary.BranchesType) {
+      W.write(P.first);
+      W.write<uint8_t>(P.second);
+    }
+
+    W.write<uint32_t>(Summary.WrittenRegisters.size());
+    for (int32_t Register : Summary.WrittenRegisters)
+      W.write<int32_t>(Register);
+  }
+
+  static IFS read(Reader &R) {
+    IFS Result;
+    Result.Type = R.readEnum<FunctionType::Values>();
+    Result.FinalState = readElement(R);
+    Result.ABI = readABI(R);
+
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      ASSlot Slot = R.readSlot();
+      Result.LocalSlots.emplace_back(Slot, R.readEnum<LocalSlotType::Values>());
+    }
+
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      BasicBlock *Callee = R.readBasicBlock();
+      Instruction *Call = R.readInstruction();
+      Result.FrameSizeAtCallSite[{ Callee, Call }] = R.readSize();
+    }
+
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      BasicBlock *BB = R.readBasicBlock();
+      Result.BranchesType[BB] = R.readEnum<BranchType::Values>();
+    }
+
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++)
+      Result.WrittenRegisters.insert(R.read<int32_t>());
+
+    return Result;
+  }
+
+  static void write(Writer &W, const Intraprocedural::Value &V) {
+    W.write(V.DirectContent);
+    W.write(V.TheTag);
+  }
+
+  static Intraprocedural::Value readValue(Reader &R) {
+    Intraprocedural::Value Result;
+    Result.DirectContent = R.readSlot();
+    Result.TheTag = R.readSlot();
+    return Result;
+  }
+
+  static void write(Writer &W, const Intraprocedural::Element &E) {
+    W.write<uint32_t>(E.State.size());
+    for (const Intraprocedural::AddressSpace &AS : E.State) {
+      W.write<uint32_t>(AS.id().id());
+      W.write<uint32_t>(AS.size());
+      for (auto &P : AS) {
+        W.write<int32_t>(P.first);
+        write(W, P.second);
+      }
+    }
+
+    W.write<uint32_t>(E.frameSizeAtCallSite().size());
+    for (auto &P : E.frameSizeAtCallSite()) {
+      W.write(P.first.caller());
+      W.write(P.first.callInstruction());
+      W.write(P.second);
+    }
+  }
+
+  static Intraprocedural::Element readElement(Reader &R) {
+    using namespace Intraprocedural;
+
+    Element Result = Element::bottom();
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      uint32_t ID = R.read<uint32_t>();
+      if (ID != I) {
+        // The address spaces are indexed by their ID
+        R.fail();
+        return Result;
+      }
+
+      AddressSpace AS((ASID(ID)));
+      for (uint32_t J = 0, Size = R.read<uint32_t>(); J < Size; J++) {
+        int32_t Offset = R.read<int32_t>();
+        AS.set(Offset, readValue(R));
+      }
+      Result.State.push_back(std::move(AS));
+    }
+
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      BasicBlock *Caller = R.readBasicBlock();
+      Instruction *Call = R.readInstruction();
+      Result.mutableFrameSizeAtCallSite()[{ Caller, Call }] = R.readSize();
+    }
+
+    return Result;
+  }
+
+  template<typename T>
+  static void writeAnalysis(Writer &W, const T &Analysis) {
+    W.write<uint8_t>(Analysis.value());
+  }
+
+  template<typename T>
+  static void readAnalysis(Reader &R, T &Analysis) {
+    Analysis = T(R.readEnum<typename T::Values>());
+  }
+
+  static void write(Writer &W, const RegisterState &State) {
+    writeAnalysis(W, State.DRAOF);
+    writeAnalysis(W, State.URAOF);
+    writeAnalysis(W, State.URVOF);
+    writeAnalysis(W, State.URVOFC);
+    writeAnalysis(W, State.DRVOFC);
+    writeAnalysis(W, State.RAOFC);
+  }
+
+  static void read(Reader &R, RegisterState &State) {
+    readAnalysis(R, State.DRAOF);
+    readAnalysis(R, State.URAOF);
+    readAnalysis(R, State.URVOF);
+    readAnalysis(R, State.URVOFC);
+    readAnalysis(R, State.DRVOFC);
+    readAnalysis(R, State.RAOFC);
+  }
+
+  static void write(Writer &W, const CallSiteRegisterState &State) {
+    writeAnalysis(W, State.RAOFC);
+    writeAnalysis(W, State.URVOFC);
+    writeAnalysis(W, State.DRVOFC);
+  }
+
+  static void read(Reader &R, CallSiteRegisterState &State) {
+    readAnalysis(R, State.RAOFC);
+    readAnalysis(R, State.URVOFC);
+    readAnalysis(R, State.DRVOFC);
+  }
+
+  template<typename K, typename V, size_t N, typename F>
+  static void
+  writeMap(Writer &W, const DefaultMap<K, V, N> &Map, F WriteKey) {
+    write(W, Map.getDefault());
+    W.write<uint32_t>(Map.size());
+    for (auto &P : Map) {
+      WriteKey(P.first);
+      write(W, P.second);
+    }
+  }
+
+  static void write(Writer &W, const FunctionABI::CallsAnalyses &Analyses) {
+    auto WriteRegister = [&W](int32_t Register) { W.write<int32_t>(Register); };
+    writeMap(W, Analyses.Registers, WriteRegister);
+  }
+
+  static void read(Reader &R, FunctionABI::CallsAnalyses &Analyses) {
+    auto ReadRegister = [&R]() { return R.read<int32_t>(); };
+    readMap(R, Analyses.Registers, ReadRegister);
+  }
+
+  template<typename K, typename V, size_t N, typename F>
+  static void readMap(Reader &R, DefaultMap<K, V, N> &Map, F ReadKey) {
+    read(R, Map.Default);
+    for (uint32_t I = 0, Count = R.read<uint32_t>(); I < Count; I++) {
+      K Key = ReadKey();
+      read(R, Map[Key]);
+    }
+  }
+
+  static void write(Writer &W, const FunctionABI &ABI) {
+    auto WriteRegister = [&W](int32_t Register) { W.write<int32_t>(Register); };
+    writeMap(W, ABI.RegisterAnalyses, WriteRegister);
+
+    auto WriteCall = [&W](const FunctionCall &Call) {
+      W.write(Call.callee());
+      W.write(Call.callInstruction());
+    };
+    writeMap(W, ABI.Calls, WriteCall);
+  }
+
+  static FunctionABI readABI(Reader &R) {
+    FunctionABI Result;
+
+    auto ReadRegister = [&R]() { return R.read<int32_t>(); };
+    readMap(R, Result.RegisterAnalyses, ReadRegister);
+
+    auto ReadCall = [&R]() {
+      BasicBlock *Callee = R.readBasicBlock();
+      Instruction *Call = R.readInstruction();
+      return FunctionCall(Callee, Call);
+    };
+    readMap(R, Result.Calls, ReadCall);
+
+    return Result;
+  }
+};
+
+namespace {
+
+/// \brief Feed the content of the basic blocks of a function into an MD5 hash
+///
+/// Instructions are identified by their basic block and their position within
+/// it, basic blocks and globals by their name.
+class BodyHasher {
+private:
+  MD5 &Hash;
+  GeneratedCodeBasicInfo *GCBI;
+  llvm::DenseMap<Type *, std::string> TypeNames;
+  llvm::DenseMap<const Instruction *, uint32_t> Positions;
+
+public:
+  BodyHasher(MD5 &Hash, GeneratedCodeBasicInfo *GCBI) :
+    Hash(Hash),
+    GCBI(GCBI) {}
+
+  void add(uint64_t Value) {
+    uint8_t Bytes[sizeof(Value)];
+    llvm::support::endian::write64le(Bytes, Value);
+    Hash.update(Bytes);
+  }
+
+  void add(StringRef String) {
+    add(String.size());
+    Hash.update(String);
+  }
+
+  void hash(BasicBlock *BB) {
+    add(BB->getName());
+    add(GCBI->getType(BB));
+
+    // Only the jump targets are tagged with their reasons
+    uint32_t Reasons = 0;
+    if (BB->getTerminator()->getMetadata(JTReasonMDName) != nullptr)
+      Reasons = GCBI->getJTReasons(BB);
+    add(Reasons);
+
+    add(BB->size());
+    for (Instruction &I : *BB)
+      hash(I);
+  }
+
+private:
+  void add(const APInt &Value) {
+    add(Value.getBitWidth());
+    for (unsigned I = 0; I < Value.getNumWords(); I++)
+      add(Value.getRawData()[I]);
+  }
+
+  void add(Type *T) {
+    auto It = TypeNames.find(T);
+    if (It == TypeNames.end()) {
+      std::string Name;
+      llvm::raw_string_ostream Stream(Name);
+      T->print(Stream);
+      Stream.flush();
+      It = TypeNames.insert({ T, Name }).first;
+    }
+    add(StringRef(It->second));
+  }
+
+  uint32_t position(const Instruction *I) {
+    auto It = Positions.find(I);
+    if (It != Positions.end())
+      return It->second;
+
+    // Number the whole basic block, its other instructions will likely follow
+    uint32_t Index = 0;
+    for (const Instruction &Other : *I->getParent())
+      Positions[&Other] = Index++;
+    return Positions[I];
+  }
+
+  void hash(Instruction &I) {
+    add(I.getOpcode());
+    add(I.getType());
+    add(I.getRawSubclassOptionalData());
+    if (auto *Compare = dyn_cast<CmpInst>(&I))
+      add(Compare->getPredicate());
+    if (auto *GEP = dyn_cast<GetElementPtrInst>(&I))
+      add(GEP->getSourceElementType());
+
+    add(I.getNumOperands());
+    for (llvm::Value *Operand : I.operand_values())
+      hash(Operand);
+  }
+
+  void hash(const llvm::Value *V) {
+    if (V == nullptr) {
+      add('0');
+    } else if (auto *I = dyn_cast<Instruction>(V)) {
+      add('I');
+      add(I->getParent()->getName());
+      add(position(I));
+    } else if (auto *BB = dyn_cast<BasicBlock>(V)) {
+      add('B');
+      add(BB->getName());
+    } else if (auto *GV = dyn_cast<GlobalValue>(V)) {
+      add('G');
+      add(GV->getName());
+    } else if (auto *Address = dyn_cast<BlockAddress>(V)) {
+      add('A');
+      add(Address->getBasicBlock()->getName());
+    } else if (auto *CI = dyn_cast<ConstantInt>(V)) {
+      add('C');
+      add(CI->getValue());
+    } else if (auto *CE = dyn_cast<ConstantExpr>(V)) {
+      add('E');
+      add(CE->getOpcode());
+      add(CE->getType());
+      add(CE->getNumOperands());
+      for (const llvm::Value *Operand : CE->operand_values())
+        hash(Operand);
+    } else {
+      add('V');
+      add(V->getValueID());
+      add(V->getType());
+    }
+  }
+};
+
+} // namespace
+
+static std::string digest(MD5 &Hash) {
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.digest().str().str();
+}
+
+SummaryStore::SummaryStore(StringRef Directory,
+                           Function *F,
+                           GeneratedCodeBasicInfo *GCBI,
+                           const Cache &TheCache,
+                           bool AnalyzeABI) :
+  Directory(Directory.str()),
+  GCBI(GCBI),
+  TheCache(TheCache) {
+
+  if (std::error_code Error = llvm::sys::fs::create_directories(Directory))
+    revng_log(SaStoreLog,
+              "Cannot create " << Directory << ": " << Error.message());
+
+  for (BasicBlock &BB : *F)
+    if (BB.hasName())
+      BasicBlocks[BB.getName()] = &BB;
+
+  // The results depend on the analysis mode and on how the CPU state is laid
+  // out
+  MD5 Hash;
+  BodyHasher Hasher(Hash, GCBI);
+  Hasher.add(SummaryStoreVersion);
+  Hasher.add(AnalyzeABI);
+  for (auto &P : TheCache.getCPUIndices()) {
+    Hasher.add(P.first);
+    Hasher.add(P.second->getName());
+  }
+  ModuleSalt = digest(Hash);
+}
+
+SummaryStore::FunctionShape
+SummaryStore::computeShape(BasicBlock *Entry) const {
+  FunctionShape Result;
+  llvm::SmallPtrSet<BasicBlock *, 16> Visited;
+  std::vector<BasicBlock *> WorkList;
+  WorkList.push_back(Entry);
+
+  while (not WorkList.empty()) {
+    BasicBlock *BB = WorkList.back();
+    WorkList.pop_back();
+
+    if (not Visited.insert(BB).second)
+      continue;
+
+    Result.BasicBlocks.push_back(BB);
+
+    // Function calls lead to the return address, not into the callee
+    BasicBlock *Callee = nullptr;
+    if (CallInst *Call = GCBI->getFunctionCall(BB)) {
+      if (auto *Address = dyn_cast<BlockAddress>(Call->getArgOperand(0))) {
+        Callee = Address->getBasicBlock();
+        Result.Callees.push_back(Callee);
+      }
+
+      if (auto *Address = dyn_cast<BlockAddress>(Call->getArgOperand(1)))
+        WorkList.push_back(Address->getBasicBlock());
+    }
+
+    for (BasicBlock *Successor : llvm::successors(BB)) {
+      if (Successor == Callee)
+        continue;
+
+      switch (GCBI->getType(Successor)) {
+      case BlockType::DispatcherBlock:
+      case BlockType::DispatcherFailureBlock:
+      case BlockType::AnyPCBlock:
+      case BlockType::UnexpectedPCBlock:
+        break;
+      default:
+        WorkList.push_back(Successor);
+      }
+    }
+  }
+
+  return Result;
+}
+
+std::string SummaryStore::hashBody(BasicBlock *Entry,
+                                   const FunctionShape &Shape) const {
+  MD5 Hash;
+  BodyHasher Hasher(Hash, GCBI);
+  Hasher.add(ModuleSalt);
+
+  llvm::GlobalVariable *LinkRegister = TheCache.getLinkRegister(Entry);
+  Hasher.add(LinkRegister == nullptr ? StringRef() : LinkRegister->getName());
+
+  Hasher.add(Shape.BasicBlocks.size());
+  for (BasicBlock *BB : Shape.BasicBlocks)
+    Hasher.hash(BB);
+
+  return digest(Hash);
+}
+
+/// The keys are computed on the strongly connected components of the call
+/// graph (Tarjan's algorithm, without recursion): each member of a component
+/// hashes the bodies of all the members and the keys of the callees outside
+/// of the component, which are complete by the time the component is.
+void SummaryStore::computeKeys(BasicBlock *Root) {
+  struct Node {
+    BasicBlock *Entry;
+    FunctionShape Shape;
+    std::string Body;
+    unsigned Index;
+    unsigned LowLink;
+    size_t NextCallee;
+    bool OnStack;
+  };
+
+  std::vector<Node> Nodes;
+  llvm::DenseMap<BasicBlock *, unsigned> NodeIndex;
+  std::vector<unsigned> Component;
+  std::vector<unsigned> CallStack;
+
+  auto Visit = [&](BasicBlock *Entry) {
+    unsigned Index = Nodes.size();
+    NodeIndex[Entry] = Index;
+    FunctionShape Shape = computeShape(Entry);
+    std::string Body = hashBody(Entry, Shape);
+    Nodes.push_back({ Entry, std::move(Shape), Body, Index, Index, 0, true });
+    Component.push_back(Index);
+    CallStack.push_back(Index);
+  };
+
+  Visit(Root);
+  while (not CallStack.empty()) {
+    unsigned Current = CallStack.back();
+
+    if (Nodes[Current].NextCallee < Nodes[Current].Shape.Callees.size()) {
+      BasicBlock *Callee = Nodes[Current].Shape.Callees[Nodes[Current]
+                                                          .NextCallee++];
+      if (Keys.count(Callee) != 0)
+        continue;
+
+      auto It = NodeIndex.find(Callee);
+      if (It == NodeIndex.end()) {
+        Visit(Callee);
+      } else if (Nodes[It->second].OnStack) {
+        Nodes[Current].LowLink = std::min(Nodes[Current].LowLink,
+                                          Nodes[It->second].Index);
+      }
+      continue;
+    }
+
+    CallStack.pop_back();
+    if (not CallStack.empty()) {
+      unsigned Caller = CallStack.back();
+      Nodes[Caller].LowLink = std::min(Nodes[Caller].LowLink,
+                                       Nodes[Current].LowLink);
+    }
+
+    if (Nodes[Current].LowLink != Nodes[Current].Index)
+      continue;
+
+    // Current is the root of a component, pop it
+    std::vector<unsigned> Members;
+    unsigned Member;
+    do {
+      Member = Component.back();
+      Component.pop_back();
+      Nodes[Member].OnStack = false;
+      Members.push_back(Member);
+    } while (Member != Current);
+
+    // Sort everything, so that the key does not depend on the visit order
+    std::vector<StringRef> Bodies;
+    std::vector<StringRef> CalleeKeys;
+    for (unsigned Member : Members) {
+      Bodies.push_back(Nodes[Member].Body);
+      for (BasicBlock *Callee : Nodes[Member].Shape.Callees) {
+        auto It = Keys.find(Callee);
+        if (It != Keys.end())
+          CalleeKeys.push_back(It->second);
+      }
+    }
+    std::sort(Bodies.begin(), Bodies.end());
+    std::sort(CalleeKeys.begin(), CalleeKeys.end());
+    CalleeKeys.erase(std::unique(CalleeKeys.begin(), CalleeKeys.end()),
+                     CalleeKeys.end());
+
+    MD5 ComponentHash;
+    BodyHasher ComponentHasher(ComponentHash, GCBI);
+    ComponentHasher.add(Bodies.size());
+    for (StringRef Body : Bodies)
+      ComponentHasher.add(Body);
+    ComponentHasher.add(CalleeKeys.size());
+    for (StringRef Key : CalleeKeys)
+      ComponentHasher.add(Key);
+    std::string ComponentKey = digest(ComponentHash);
+
+    for (unsigned Member : Members) {
+      MD5 Hash;
+      BodyHasher Hasher(Hash, GCBI);
+      Hasher.add(ComponentKey);
+      Hasher.add(Nodes[Member].Body);
+      Keys[Nodes[Member].Entry] = digest(Hash);
+    }
+  }
+}
+
+std::string SummaryStore::getKey(BasicBlock *Entry) {
+  std::lock_guard<std::mutex> Guard(KeysLock);
+  auto It = Keys.find(Entry);
+  if (It == Keys.end()) {
+    computeKeys(Entry);
+    It = Keys.find(Entry);
+  }
+
+  revng_assert(It != Keys.end());
+  return It->second;
+}
+
+std::string SummaryStore::getEntryPath(StringRef Key) const {
+  SmallString<128> Path(Directory);
+  llvm::sys::path::append(Path, Key + ".summary");
+  return Path.str().str();
+}
+
+Optional<SummaryStore::StoredFunction> SummaryStore::load(BasicBlock *Entry) {
+  std::string Path = getEntryPath(getKey(Entry));
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (not Buffer) {
+    revng_log(SaStoreLog, "No stored summary for " << getName(Entry));
+    return Optional<StoredFunction>();
+  }
+
+  auto Result = SummarySerializer::read(*this, (*Buffer)->getBuffer());
+  if (Result) {
+    revng_log(SaStoreLog, "Loaded the summary of " << getName(Entry));
+  } else {
+    // A damaged entry is just a miss, it will be overwritten
+    revng_log(SaStoreLog, "Ignoring unreadable entry " << Path);
+  }
+
+  return Result;
+}
+
+void SummaryStore::store(BasicBlock *Entry,
+                         FunctionType::Values Type,
+                         const IFS *Summary) {
+  std::string Path = getEntryPath(getKey(Entry));
+
+  SmallString<128> Temporary;
+  int FD;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%.tmp", FD, Temporary)) {
+    revng_log(SaStoreLog, "Cannot create a temporary file for " << Path);
+    return;
+  }
+
+  {
+    llvm::raw_fd_ostream Stream(FD, /* shouldClose */ true);
+    SummarySerializer::write(Stream, Type, Summary);
+    Stream.close();
+    if (Stream.has_error()) {
+      Stream.clear_error();
+      llvm::sys::fs::remove(Temporary);
+      return;
+    }
+  }
+
+  if (llvm::sys::fs::rename(Temporary, Path))
+    llvm::sys::fs::remove(Temporary);
+}
+
+} // namespace StackAnalysis
@@ -0,0 +1,120 @@
+#ifndef SUMMARYSTORE_H
+#define SUMMARYSTORE_H
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+// Standard includes
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// LLVM includes
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+
+// Local includes
+#include "IntraproceduralFunctionSummary.h"
+
+class GeneratedCodeBasicInfo;
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Instruction;
+} // namespace llvm
+
+namespace StackAnalysis {
+
+class Cache;
+
+/// \brief On-disk, content-addressed store of IntraproceduralFunctionSummary
+///
+/// Each function is identified by a key covering:
+///
+/// * the basic blocks reachable from its entry without going through the
+///   dispatcher or into its callees;
+/// * the keys of the functions it calls, so that a change in a callee changes
+///   the key of all of its callers;
+/// * the analysis mode and the CPU state layout (the CSVs and their indices,
+///   the link register).
+///
+/// Functions calling each other recursively share the same key, computed over
+/// the whole strongly connected component of the call graph.
+///
+/// Each entry is a separate file, written to a temporary and renamed in place.
+/// Entries that cannot be read are considered missing and overwritten.
+class SummaryStore {
+public:
+  using IFS = IntraproceduralFunctionSummary;
+
+  /// \brief What is known about a function at the end of an analysis
+  struct StoredFunction {
+    /// \brief Regular, NoReturn or Fake
+    FunctionType::Values Type;
+    /// \brief The summary in the Cache, if any (fake functions might have none)
+    llvm::Optional<IFS> Summary;
+  };
+
+public:
+  SummaryStore(llvm::StringRef Directory,
+               llvm::Function *F,
+               GeneratedCodeBasicInfo *GCBI,
+               const Cache &TheCache,
+               bool AnalyzeABI);
+
+  /// \brief Load what is known about the function starting at \p Entry
+  llvm::Optional<StoredFunction> load(llvm::BasicBlock *Entry);
+
+  /// \brief Record that the function starting at \p Entry has type \p Type
+  ///        and summary \p Summary (if not nullptr)
+  void store(llvm::BasicBlock *Entry,
+             FunctionType::Values Type,
+             const IFS *Summary);
+
+  /// \brief Key of the function starting at \p Entry, as an hex string
+  std::string getKey(llvm::BasicBlock *Entry);
+
+  llvm::BasicBlock *getBasicBlock(llvm::StringRef Name) const {
+    auto It = BasicBlocks.find(Name);
+    if (It == BasicBlocks.end())
+      return nullptr;
+    return It->second;
+  }
+
+private:
+  struct FunctionShape {
+    std::vector<llvm::BasicBlock *> BasicBlocks;
+    std::vector<llvm::BasicBlock *> Callees;
+  };
+
+private:
+  FunctionShape computeShape(llvm::BasicBlock *Entry) const;
+  std::string hashBody(llvm::BasicBlock *Entry,
+                       const FunctionShape &Shape) const;
+  void computeKeys(llvm::BasicBlock *Root);
+  std::string getEntryPath(llvm::StringRef Key) const;
+
+private:
+  std::string Directory;
+  GeneratedCodeBasicInfo *GCBI;
+  const Cache &TheCache;
+
+  /// \brief Hash of what is common to all the functions: analysis mode and
+  ///        CPU state layout
+  std::string ModuleSalt;
+
+  llvm::StringMap<llvm::BasicBlock *> BasicBlocks;
+
+  /// \brief Protects Keys, the store is shared by the analysis threads
+  std::mutex KeysLock;
+  llvm::DenseMap<llvm::BasicBlock *, std::string> Keys;
+};
+
+} // namespace StackAnalysis
+
+#endif // SUMMARYSTORE_H
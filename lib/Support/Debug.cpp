@@ -76,7 +76,7 @@ static std::unique_ptr<cl::alias> DebugLoggingAlias;
 llvm::ManagedStatic<DebugLogOptionWrapper> DebugLogOption;
 
 template<bool X>
-unsigned Logger<X>::IndentLevel;
+thread_local unsigned Logger<X>::IndentLevel;
 
 template<bool X>
 void Logger<X>::indent(unsigned Level) {
@@ -38,6 +38,8 @@ static std::array<Handler, 3> Handlers = { { { SIGINT, true, {}, {} },
 
 llvm::ManagedStatic<OnQuitRegistry> OnQuitStatistics;
 
+thread_local ThreadStatistics *ThreadStatistics::Current = nullptr;
+
 void installStatistics() {
   if (Statistics)
     OnQuitStatistics->install();
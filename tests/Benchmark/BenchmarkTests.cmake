@@ -0,0 +1,29 @@
+#
+# This file is distributed under the MIT License. See LICENSE.md for details.
+#
+
+set(SRC "${CMAKE_SOURCE_DIR}/tests/Benchmark")
+
+#
+# benchmark_securitypass
+#
+
+add_executable(benchmark_securitypass "${SRC}/SecurityPass.cpp")
+target_include_directories(benchmark_securitypass
+  PRIVATE "${CMAKE_SOURCE_DIR}")
+target_link_libraries(benchmark_securitypass
+  revngSecurityPass
+  revngSupport
+  ${LLVM_LIBRARIES})
+
+# Quick run, making sure the benchmark itself keeps working
+add_test(NAME benchmark_securitypass
+  COMMAND benchmark_securitypass -functions=1000)
+set_tests_properties(benchmark_securitypass PROPERTIES LABELS "benchmark")
+
+# Full run, failing if the time of a stage grows superlinearly with the size
+# of the module
+add_custom_target(run-security-benchmark
+  COMMAND benchmark_securitypass -functions=1000,10000,100000 -max-scaling=4
+  DEPENDS benchmark_securitypass
+  USES_TERMINAL)
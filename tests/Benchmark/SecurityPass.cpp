@@ -0,0 +1,448 @@
+/// \file SecurityPass.cpp
+/// \brief Benchmark of the security analyses on synthetic isolated modules
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+// Standard includes
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+}
+
+// LLVM includes
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+// Local libraries includes
+#include "revng/SecurityPass/BackwardPropagationPass.h"
+#include "revng/SecurityPass/FunctionParamsUsagePass.h"
+#include "revng/SecurityPass/LoopDependenciesPass.h"
+#include "revng/SecurityPass/RevngFunctionParamsPass.h"
+#include "revng/SecurityPass/SecurityWrapperPass.h"
+#include "revng/Support/Assert.h"
+#include "revng/Support/IRHelpers.h"
+
+using namespace llvm;
+
+namespace {
+
+cl::OptionCategory BenchmarkCategory("Benchmark options");
+
+cl::list<unsigned> Functions("functions",
+                             cl::desc("number of isolated functions of each "
+                                      "synthetic module"),
+                             cl::CommaSeparated,
+                             cl::cat(BenchmarkCategory));
+
+cl::opt<unsigned> CallDepth("call-depth",
+                            cl::desc("length of the call chains"),
+                            cl::init(64),
+                            cl::cat(BenchmarkCategory));
+
+cl::opt<unsigned> LoopsPerFunction("loops",
+                                   cl::desc("loops in each function"),
+                                   cl::init(2),
+                                   cl::cat(BenchmarkCategory));
+
+cl::list<std::string> Stages("stages",
+                             cl::desc("passes to time, all of them by "
+                                      "default"),
+                             cl::CommaSeparated,
+                             cl::cat(BenchmarkCategory));
+
+cl::opt<double> MaxScaling("max-scaling",
+                           cl::desc("fail if the time of a stage grows more "
+                                    "than this many times faster than the "
+                                    "module (0 to disable)"),
+                           cl::init(0),
+                           cl::cat(BenchmarkCategory));
+
+cl::opt<bool> KeepInputs("keep-inputs",
+                         cl::desc("do not delete the generated CSV files"),
+                         cl::cat(BenchmarkCategory));
+
+/// Below this many seconds timings are mostly noise: they do not take part
+/// in the scaling check
+constexpr double MinimumScalingTime = 0.1;
+
+struct Stage {
+  const char *Name;
+  Pass *(*Create)();
+};
+
+template<typename T>
+Pass *create() {
+  return new T();
+}
+
+const Stage AllStages[] = {
+  { "revng-func-params", create<revng::RevngFunctionParamsPass> },
+  { "revng-params-usage", create<revng::FunctionParamsUsagePass> },
+  { "revng-loop-deps", create<revng::LoopDependenciesPass> },
+  { "revng-backward-prop", create<revng::BackwardPropagationPass> },
+  { "revng-security-analysis", create<revng::SecurityWrapperPass> }
+};
+
+struct Measure {
+  double Seconds = 0;
+  long PeakKiB = 0;
+};
+
+/// Generator of isolated modules resembling the output of revng
+///
+/// Every function has a `revng.func.entry` tuple listing its CSV arguments,
+/// reads a parameter from the virtual stack through `rsp` and writes, in
+/// each of its loops, through a pointer derived from its arguments. The
+/// functions are laid out in call chains of `CallDepth` functions, each
+/// ending in an input source listed in the input functions CSV.
+class ModuleGenerator {
+public:
+  ModuleGenerator(LLVMContext &Context, unsigned FunctionsCount) :
+    Context(Context),
+    QMD(Context),
+    FunctionsCount(FunctionsCount),
+    M(new Module("benchmark", Context)),
+    Int8PtrTy(Type::getInt8PtrTy(Context)),
+    Int32Ty(Type::getInt32Ty(Context)),
+    Int64Ty(Type::getInt64Ty(Context)),
+    Int64PtrTy(Type::getInt64PtrTy(Context)) {}
+
+  std::unique_ptr<Module> generate();
+
+  /// Name of the input source of chain \p Chain, without the `bb.` prefix
+  static std::string inputName(unsigned Chain) {
+    return "read_input_" + std::to_string(Chain);
+  }
+
+  static uint64_t entryAddress(unsigned Index) {
+    return 0x400000 + 0x100 * uint64_t(Index);
+  }
+
+  unsigned chains() const {
+    return (FunctionsCount + CallDepth - 1) / CallDepth;
+  }
+
+private:
+  GlobalVariable *createCSV(StringRef Name) {
+    auto *Initializer = ConstantInt::get(Int64Ty, 0);
+    return new GlobalVariable(*M,
+                              Int64Ty,
+                              false,
+                              GlobalValue::InternalLinkage,
+                              Initializer,
+                              Name);
+  }
+
+  Function *createIsolated(const Twine &Name, uint64_t Address);
+  void emitBody(Function *F, uint64_t Address, Function *Callee);
+  void emitInputSource(Function *F, uint64_t Address);
+
+private:
+  LLVMContext &Context;
+  QuickMetadata QMD;
+  unsigned FunctionsCount;
+  std::unique_ptr<Module> M;
+  PointerType *Int8PtrTy;
+  Type *Int32Ty;
+  Type *Int64Ty;
+  PointerType *Int64PtrTy;
+  GlobalVariable *RAX = nullptr;
+  GlobalVariable *RDI = nullptr;
+  GlobalVariable *RSI = nullptr;
+  GlobalVariable *RDX = nullptr;
+  GlobalVariable *RSP = nullptr;
+  Function *NewPC = nullptr;
+};
+
+Function *ModuleGenerator::createIsolated(const Twine &Name, uint64_t Address) {
+  auto *FT = FunctionType::get(Type::getVoidTy(Context), false);
+  auto *F = Function::Create(FT, GlobalValue::ExternalLinkage, Name, *M);
+
+  std::vector<Metadata *> Slots;
+  for (GlobalVariable *CSV : { RDI, RSI, RDX })
+    Slots.push_back(QMD.tuple({ QMD.get(CSV), QMD.get("Yes"), QMD.get("No") }));
+  F->setMetadata("revng.func.entry",
+                 QMD.tuple({ QMD.get(F->getName()),
+                             QMD.get(Address),
+                             QMD.get("Regular"),
+                             QMD.tuple({ QMD.get(RAX) }),
+                             QMD.tuple(Slots) }));
+  return F;
+}
+
+void ModuleGenerator::emitBody(Function *F,
+                               uint64_t Address,
+                               Function *Callee) {
+  auto *Entry = BasicBlock::Create(Context, "entry", F);
+  IRBuilder<> Builder(Entry);
+  Builder.CreateCall(NewPC,
+                     { ConstantInt::get(Int64Ty, Address),
+                       ConstantInt::get(Int64Ty, 4),
+                       ConstantInt::get(Int32Ty, 1),
+                       ConstantPointerNull::get(Int8PtrTy) });
+  Value *Buffer = Builder.CreateLoad(Int64Ty, RDI, "rdi");
+  Value *Size = Builder.CreateLoad(Int64Ty, RSI, "rsi");
+  Value *Other = Builder.CreateLoad(Int64Ty, RDX, "rdx");
+
+  // A parameter passed on the virtual stack
+  Value *SP = Builder.CreateLoad(Int64Ty, RSP, "rsp");
+  Value *SlotAddress = Builder.CreateAdd(SP, ConstantInt::get(Int64Ty, 8));
+  Value *Slot = Builder.CreateIntToPtr(SlotAddress, Int64PtrTy);
+  Value *StackParam = Builder.CreateLoad(Int64Ty, Slot, "stack_param");
+
+  // Loops bounded by a parameter and storing through another one
+  for (unsigned I = 0; I < LoopsPerFunction; I++) {
+    BasicBlock *Preheader = Builder.GetInsertBlock();
+    auto *Body = BasicBlock::Create(Context, "loop", F);
+    auto *Exit = BasicBlock::Create(Context, "loop_exit", F);
+    Builder.CreateBr(Body);
+
+    Builder.SetInsertPoint(Body);
+    PHINode *Index = Builder.CreatePHI(Int64Ty, 2, "index");
+    Index->addIncoming(ConstantInt::get(Int64Ty, 0), Preheader);
+    Value *Offset = Builder.CreateShl(Index, 3);
+    Value *ElementAddress = Builder.CreateAdd(Buffer, Offset);
+    Value *Pointer = Builder.CreateIntToPtr(ElementAddress, Int64PtrTy);
+    Builder.CreateStore(Builder.CreateAdd(StackParam, Index), Pointer);
+    Value *Next = Builder.CreateAdd(Index, ConstantInt::get(Int64Ty, 1));
+    Index->addIncoming(Next, Body);
+    Builder.CreateCondBr(Builder.CreateICmpULT(Next, Size), Body, Exit);
+
+    Builder.SetInsertPoint(Exit);
+  }
+
+  // Pass an argument on to the next function of the chain
+  Builder.CreateStore(Other, RDI);
+  Builder.CreateCall(Callee);
+  Builder.CreateStore(Builder.CreateLoad(Int64Ty, RAX), RDX);
+  Builder.CreateRetVoid();
+}
+
+void ModuleGenerator::emitInputSource(Function *F, uint64_t Address) {
+  auto *Entry = BasicBlock::Create(Context, "entry", F);
+  IRBuilder<> Builder(Entry);
+  Builder.CreateCall(NewPC,
+                     { ConstantInt::get(Int64Ty, Address),
+                       ConstantInt::get(Int64Ty, 4),
+                       ConstantInt::get(Int32Ty, 1),
+                       ConstantPointerNull::get(Int8PtrTy) });
+  Value *Buffer = Builder.CreateLoad(Int64Ty, RDI, "rdi");
+  Builder.CreateStore(Buffer, RAX);
+  Builder.CreateRetVoid();
+}
+
+std::unique_ptr<Module> ModuleGenerator::generate() {
+  RAX = createCSV("rax");
+  RDI = createCSV("rdi");
+  RSI = createCSV("rsi");
+  RDX = createCSV("rdx");
+  RSP = createCSV("rsp");
+  createCSV("pc");
+
+  auto *NewPCType = FunctionType::get(Type::getVoidTy(Context),
+                                      { Int64Ty, Int64Ty, Int32Ty, Int8PtrTy },
+                                      true);
+  NewPC = Function::Create(NewPCType,
+                           GlobalValue::ExternalLinkage,
+                           "newpc",
+                           *M);
+
+  // Create all the functions first, so that calls can go forward
+  std::vector<Function *> Isolated;
+  Isolated.reserve(FunctionsCount);
+  for (unsigned I = 0; I < FunctionsCount; I++)
+    Isolated.push_back(createIsolated("bb.fun_" + Twine(I), entryAddress(I)));
+
+  std::vector<Function *> Sources;
+  for (unsigned Chain = 0; Chain < chains(); Chain++) {
+    uint64_t Address = entryAddress(FunctionsCount + Chain);
+    Sources.push_back(createIsolated("bb." + inputName(Chain), Address));
+    emitInputSource(Sources.back(), Address);
+  }
+
+  for (unsigned I = 0; I < FunctionsCount; I++) {
+    bool LastOfChain = I % CallDepth == CallDepth - 1
+                       or I + 1 == FunctionsCount;
+    Function *Callee = LastOfChain ? Sources[I / CallDepth] : Isolated[I + 1];
+    emitBody(Isolated[I], entryAddress(I), Callee);
+  }
+
+  revng_assert(not verifyModule(*M, &dbgs()));
+  return std::move(M);
+}
+
+/// Point the option \p Name of the analyses to a new temporary file,
+/// returning its path
+std::string createInputFile(StringRef Name) {
+  SmallString<128> Path;
+  if (sys::fs::createTemporaryFile(Name, "csv", Path)) {
+    errs() << "Cannot create a temporary file\n";
+    exit(EXIT_FAILURE);
+  }
+
+  auto &Options = cl::getRegisteredOptions();
+  auto It = Options.find(Name);
+  revng_assert(It != Options.end());
+  It->second->addOccurrence(0, Name, Path);
+  return Path.str().str();
+}
+
+void writeFile(StringRef Path, StringRef Content) {
+  std::error_code EC;
+  raw_fd_ostream Stream(Path, EC);
+  if (EC) {
+    errs() << "Cannot write " << Path << ": " << EC.message() << "\n";
+    exit(EXIT_FAILURE);
+  }
+  Stream << Content;
+}
+
+/// Run \p TheStage on \p M in a child process
+///
+/// Each stage gets a fresh copy of the module and of the global state of the
+/// analyses, and the peak resident memory of the child is the one of the
+/// module plus the one of the stage.
+bool measure(Module &M, const Stage &TheStage, Measure &Result) {
+  int Pipe[2];
+  if (pipe(Pipe) != 0)
+    return false;
+
+  pid_t Child = fork();
+  if (Child < 0)
+    return false;
+
+  if (Child == 0) {
+    close(Pipe[0]);
+    legacy::PassManager PM;
+    PM.add(TheStage.Create());
+    auto Start = std::chrono::steady_clock::now();
+    PM.run(M);
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now()
+                                            - Start;
+    double Seconds = Elapsed.count();
+    bool Written = write(Pipe[1], &Seconds, sizeof(Seconds)) == sizeof(Seconds);
+    _exit(Written ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  close(Pipe[1]);
+  bool Read = read(Pipe[0], &Result.Seconds, sizeof(Result.Seconds))
+              == sizeof(Result.Seconds);
+  close(Pipe[0]);
+
+  int Status;
+  struct rusage Usage;
+  if (wait4(Child, &Status, 0, &Usage) != Child)
+    return false;
+  Result.PeakKiB = Usage.ru_maxrss;
+  return Read and WIFEXITED(Status) and WEXITSTATUS(Status) == EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  PassRegistry &Registry = *PassRegistry::getPassRegistry();
+  initializeCore(Registry);
+  initializeAnalysis(Registry);
+
+  cl::ParseCommandLineOptions(argc, argv);
+  std::vector<unsigned> Sizes(Functions.begin(), Functions.end());
+  if (Sizes.empty())
+    Sizes.push_back(1000);
+  if (CallDepth == 0)
+    CallDepth = 1;
+
+  std::vector<const Stage *> Selected;
+  for (const Stage &TheStage : AllStages)
+    if (Stages.empty() or is_contained(Stages, TheStage.Name))
+      Selected.push_back(&TheStage);
+  for (const std::string &Name : Stages) {
+    auto HasName = [&Name](const Stage &S) { return Name == S.Name; };
+    if (none_of(AllStages, HasName)) {
+      errs() << "Unknown stage " << Name << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  outs() << " functions  stage                        seconds    peak MiB"
+            "   scaling\n";
+
+  // The input sources of the backward propagation, rewritten for each module
+  std::string InputsPath = createInputFile("input-functions-csv");
+  std::string RelocationsPath = createInputFile("dyn-rel-maps");
+
+  bool Success = true;
+  std::vector<Measure> Previous(Selected.size());
+  unsigned PreviousFunctions = 0;
+  for (unsigned FunctionsCount : Sizes) {
+    LLVMContext Context;
+    ModuleGenerator Generator(Context, FunctionsCount);
+    std::unique_ptr<Module> M = Generator.generate();
+
+    std::string InputFunctions;
+    for (unsigned Chain = 0; Chain < Generator.chains(); Chain++)
+      InputFunctions += ModuleGenerator::inputName(Chain) + ",1,buffer\n";
+    writeFile(InputsPath, InputFunctions);
+    writeFile(RelocationsPath, "");
+
+    for (unsigned I = 0; I < Selected.size(); I++) {
+      Measure Result;
+      if (not measure(*M, *Selected[I], Result)) {
+        errs() << Selected[I]->Name << " failed on " << FunctionsCount
+               << " functions\n";
+        Success = false;
+        continue;
+      }
+
+      // How much faster than the module the time of the stage grows: about
+      // one for linear stages
+      double Scaling = 0;
+      if (PreviousFunctions != 0 and Previous[I].Seconds > 0) {
+        double Growth = double(FunctionsCount) / PreviousFunctions;
+        Scaling = Result.Seconds / Previous[I].Seconds / Growth;
+        if (MaxScaling != 0 and Result.Seconds >= MinimumScalingTime
+            and Scaling > MaxScaling) {
+          errs() << Selected[I]->Name << " grows superlinearly between "
+                 << PreviousFunctions << " and " << FunctionsCount
+                 << " functions\n";
+          Success = false;
+        }
+      }
+
+      outs() << format("%10u  %-24s  %10.3f  %10.1f  %8.2f\n",
+                       FunctionsCount,
+                       Selected[I]->Name,
+                       Result.Seconds,
+                       Result.PeakKiB / 1024.0,
+                       Scaling);
+      outs().flush();
+      Previous[I] = Result;
+    }
+    PreviousFunctions = FunctionsCount;
+  }
+
+  if (not KeepInputs) {
+    sys::fs::remove(InputsPath);
+    sys::fs::remove(RelocationsPath);
+  }
+
+  return Success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -39,6 +39,7 @@ endmacro()
 include(${CMAKE_SOURCE_DIR}/tests/Runtime/RuntimeTests.cmake)
 include(${CMAKE_SOURCE_DIR}/tests/Analysis/AnalysisTests.cmake)
 include(${CMAKE_SOURCE_DIR}/tests/Unit/UnitTests.cmake)
+include(${CMAKE_SOURCE_DIR}/tests/Benchmark/BenchmarkTests.cmake)
 
 # Compile the requested programs
 foreach(ARCH ${SUPPORTED_ARCHITECTURES})
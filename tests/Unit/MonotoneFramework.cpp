@@ -0,0 +1,173 @@
+/// \file MonotoneFramework.cpp
+/// \brief Tests for MonotoneFramework
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+// Standard includes
+#include <map>
+#include <set>
+#include <vector>
+
+// Boost includes
+#define BOOST_TEST_MODULE MonotoneFramework
+bool init_unit_test();
+#include <boost/test/unit_test.hpp>
+
+// LLVM includes
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Module.h"
+
+// Local libraries includes
+#include "revng/Support/MonotoneFramework.h"
+#include "revng/UnitTestHelpers/LLVMTestHelpers.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+using BlockSet = UnionMonotoneSet<BasicBlock *>;
+
+/// \brief Collect, for each basic block, the blocks on some path from the entry
+template<bool Indexed>
+class ReachingBlocks
+  : public MonotoneFramework<ReachingBlocks<Indexed>,
+                             BasicBlock *,
+                             BlockSet,
+                             ReversePostOrder,
+                             SmallVector<BasicBlock *, 2>,
+                             DefaultInterrupt<BlockSet>,
+                             false,
+                             Indexed> {
+private:
+  using Base = MonotoneFramework<ReachingBlocks<Indexed>,
+                                 BasicBlock *,
+                                 BlockSet,
+                                 ReversePostOrder,
+                                 SmallVector<BasicBlock *, 2>,
+                                 DefaultInterrupt<BlockSet>,
+                                 false,
+                                 Indexed>;
+
+public:
+  /// Labels in the order the transfer function was run on them
+  std::vector<BasicBlock *> Visits;
+
+public:
+  ReachingBlocks(BasicBlock *Entry) : Base(Entry) {
+    this->registerExtremal(Entry);
+  }
+
+  BlockSet extremalValue(BasicBlock *) const { return BlockSet(); }
+
+  void assertLowerThanOrEqual(const BlockSet &A, const BlockSet &B) const {
+    revng_assert(A.lowerThanOrEqual(B));
+  }
+
+  DefaultInterrupt<BlockSet> transfer(BasicBlock *BB) {
+    Visits.push_back(BB);
+    BlockSet Result = this->getState(BB)->copy();
+    Result.insert(BB);
+    return DefaultInterrupt<BlockSet>::createInterrupt(std::move(Result));
+  }
+
+  Optional<BlockSet>
+  handleEdge(const BlockSet &, BasicBlock *, BasicBlock *) const {
+    return None;
+  }
+
+  SmallVector<BasicBlock *, 2>
+  successors(BasicBlock *BB, DefaultInterrupt<BlockSet> &) const {
+    return SmallVector<BasicBlock *, 2>(succ_begin(BB), succ_end(BB));
+  }
+
+  size_t successor_size(BasicBlock *BB, DefaultInterrupt<BlockSet> &) const {
+    return succ_end(BB) - succ_begin(BB);
+  }
+
+  void dumpFinalState() const { revng_abort(); }
+
+  /// \brief The state of every basic block of \p F, if reached
+  std::map<BasicBlock *, std::set<BasicBlock *>> results(Function *F) {
+    std::map<BasicBlock *, std::set<BasicBlock *>> Result;
+    for (BasicBlock &BB : *F)
+      if (BlockSet *State = this->getState(&BB))
+        Result[&BB] = std::set<BasicBlock *>(State->begin(), State->end());
+    return Result;
+  }
+};
+
+static const char *Body = R"LLVM(
+  br label %loop
+
+loop:
+  %counter = load i64, i64* @rax
+  %done = icmp eq i64 %counter, 0
+  br i1 %done, label %exit, label %inner
+
+inner:
+  %value = load i64, i64* @rdi
+  %again = icmp ugt i64 %value, 10
+  br i1 %again, label %inner, label %latch
+
+latch:
+  br label %loop
+
+unreachable:
+  br label %exit
+
+exit:
+  ret void
+)LLVM";
+
+BOOST_AUTO_TEST_CASE(TestIndexedMatchesMap) {
+  LLVMContext TestContext;
+  std::unique_ptr<Module> M = loadModule(TestContext, Body);
+  Function *F = M->getFunction("main");
+  BasicBlock *Entry = &F->getEntryBlock();
+
+  ReachingBlocks<false> MapMode(Entry);
+  MapMode.initialize();
+  MapMode.run();
+
+  ReachingBlocks<true> IndexedMode(Entry);
+  IndexedMode.initialize();
+  IndexedMode.run();
+
+  revng_check(MapMode.Visits == IndexedMode.Visits);
+  revng_check(MapMode.size() == IndexedMode.size());
+  revng_check(MapMode.results(F) == IndexedMode.results(F));
+
+  // The loops are visited more than once
+  revng_check(MapMode.Visits.size() > 5);
+
+  auto *Loop = basicBlockByName(F, "loop");
+  auto *Inner = basicBlockByName(F, "inner");
+  auto *Latch = basicBlockByName(F, "latch");
+  auto *Exit = basicBlockByName(F, "exit");
+  std::set<BasicBlock *> Expected = { Entry, Loop, Inner, Latch };
+  revng_check(IndexedMode.results(F).at(Exit) == Expected);
+}
+
+BOOST_AUTO_TEST_CASE(TestLabelsOutsideTheGraph) {
+  LLVMContext TestContext;
+  std::unique_ptr<Module> M = loadModule(TestContext, Body);
+  Function *F = M->getFunction("main");
+  BasicBlock *Entry = &F->getEntryBlock();
+  BasicBlock *Unreachable = basicBlockByName(F, "unreachable");
+
+  ReachingBlocks<false> MapMode(Entry);
+  MapMode.initialize();
+  MapMode.run();
+
+  ReachingBlocks<true> IndexedMode(Entry);
+  IndexedMode.initialize();
+  IndexedMode.run();
+
+  // The unreachable block is not part of the reverse post order: it has no
+  // state, in either mode
+  revng_check(MapMode.getState(Unreachable) == nullptr);
+  revng_check(IndexedMode.getState(Unreachable) == nullptr);
+  revng_check(MapMode.results(F).count(Unreachable) == 0);
+  revng_check(IndexedMode.results(F).count(Unreachable) == 0);
+}
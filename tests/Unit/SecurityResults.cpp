@@ -0,0 +1,185 @@
+/// \file SecurityResults.cpp
+/// \brief Tests for the binary security analysis results
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+// Standard includes
+#include <cstring>
+#include <string>
+
+// Boost includes
+#define BOOST_TEST_MODULE SecurityResults
+bool init_unit_test();
+#include <boost/test/unit_test.hpp>
+
+// LLVM includes
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+// Local libraries includes
+#include "revng/SecurityPass/BinaryResultFormat.h"
+#include "revng/SecurityPass/ResultWriter.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+using namespace revng;
+
+static InstructionLocation location(uint64_t Address, uint32_t Offset) {
+  InstructionLocation Result;
+  Result.address = Address;
+  Result.offset = Offset;
+  return Result;
+}
+
+/// Write two functions, one of them with loops, and return the file content
+static std::string writeResults() {
+  SmallString<128> Path;
+  std::error_code Error = sys::fs::createTemporaryFile("security-results",
+                                                       "bin",
+                                                       Path);
+  revng_check(!Error);
+
+  {
+    BinaryResultWriter Writer(Path);
+
+    FunctionFindings Vulnerable;
+    Vulnerable.name = "vulnerable";
+    Vulnerable.entryAddress = 0x401000;
+    Vulnerable.isMarked = true;
+    Vulnerable.isSafe = false;
+    Vulnerable.numRiskyStores = 2;
+    LoopFindings Outer;
+    Outer.name = "outer";
+    Outer.branches.push_back(location(0x401010, 1));
+    Outer.stores.push_back(location(0x401020, 0));
+    Outer.stores.push_back(location(0x401028, 3));
+    Vulnerable.loops.push_back(Outer);
+    LoopFindings Inner;
+    Inner.name = "inner";
+    Inner.branches.push_back(location(0x401030, 2));
+    Vulnerable.loops.push_back(Inner);
+    revng_check(Writer.writeFunction(Vulnerable));
+
+    FunctionFindings Safe;
+    Safe.name = "safe";
+    Safe.entryAddress = 0x402000;
+    revng_check(Writer.writeFunction(Safe));
+
+    // Records of a function already written are dropped
+    Safe.isSafe = false;
+    revng_check(not Writer.writeFunction(Safe));
+
+    revng_check(!Writer.close());
+  }
+
+  auto Buffer = MemoryBuffer::getFile(Path);
+  revng_check(Buffer);
+  std::string Result = (*Buffer)->getBuffer().str();
+  sys::fs::remove(Path);
+  return Result;
+}
+
+using ReaderResult = Expected<std::unique_ptr<BinaryResultReader>>;
+
+static ReaderResult read(StringRef Data) {
+  return BinaryResultReader::create(MemoryBuffer::getMemBufferCopy(Data));
+}
+
+static bool isRejected(StringRef Data) {
+  ReaderResult Reader = read(Data);
+  if (Reader)
+    return false;
+  consumeError(Reader.takeError());
+  return true;
+}
+
+static binary::Header &header(std::string &Data) {
+  return *reinterpret_cast<binary::Header *>(&Data[0]);
+}
+
+BOOST_AUTO_TEST_CASE(TestRoundTrip) {
+  ReaderResult Reader = read(writeResults());
+  revng_check(Reader);
+
+  ArrayRef<binary::FunctionRecord> Functions = (*Reader)->functions();
+  revng_check(Functions.size() == 2);
+
+  const binary::FunctionRecord &Vulnerable = Functions[0];
+  revng_check((*Reader)->getName(Vulnerable) == "vulnerable");
+  revng_check(Vulnerable.entryAddress == 0x401000);
+  revng_check(Vulnerable.flags == binary::IsMarked);
+  revng_check(Vulnerable.numRiskyStores == 2);
+
+  ArrayRef<binary::LoopRecord> Loops = (*Reader)->loops(Vulnerable);
+  revng_check(Loops.size() == 2);
+  revng_check((*Reader)->getName(Loops[0]) == "outer");
+  revng_check((*Reader)->branches(Loops[0]).size() == 1);
+  revng_check((*Reader)->branches(Loops[0])[0].address == 0x401010);
+  revng_check((*Reader)->branches(Loops[0])[0].offset == 1);
+  revng_check((*Reader)->stores(Loops[0]).size() == 2);
+  revng_check((*Reader)->stores(Loops[0])[1].address == 0x401028);
+  revng_check((*Reader)->stores(Loops[0])[1].offset == 3);
+  revng_check((*Reader)->getName(Loops[1]) == "inner");
+  revng_check((*Reader)->branches(Loops[1])[0].address == 0x401030);
+  revng_check((*Reader)->stores(Loops[1]).empty());
+
+  const binary::FunctionRecord &Safe = Functions[1];
+  revng_check((*Reader)->getName(Safe) == "safe");
+  revng_check(Safe.entryAddress == 0x402000);
+  revng_check(Safe.flags == binary::IsSafe);
+  revng_check((*Reader)->loops(Safe).empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestMalformedInput) {
+  const std::string Valid = writeResults();
+  revng_check(not isRejected(Valid));
+
+  // Truncated header and truncated tables
+  revng_check(isRejected(StringRef(Valid).take_front(sizeof(binary::Header)
+                                                     - 1)));
+  revng_check(isRejected(StringRef(Valid).drop_back(1)));
+  revng_check(isRejected(StringRef(Valid).take_front(sizeof(binary::Header)
+                                                     + 1)));
+
+  std::string Data = Valid;
+  Data[0] = 'X';
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  header(Data).version = binary::Version + 1;
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  header(Data).numLocations = header(Data).numLocations + 1000;
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  header(Data).loopsOffset = header(Data).loopsOffset + 1;
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  Data.back() = 'X';
+  revng_check(isRejected(Data));
+
+  // References out of their table
+  Data = Valid;
+  auto *Functions = reinterpret_cast<binary::FunctionRecord *>(
+    &Data[header(Data).functionsOffset]);
+  Functions[0].numLoops = header(Data).numLoops + 1;
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  Functions = reinterpret_cast<binary::FunctionRecord *>(
+    &Data[header(Data).functionsOffset]);
+  Functions[1].name = header(Data).stringsSize;
+  revng_check(isRejected(Data));
+
+  Data = Valid;
+  auto *Loops = reinterpret_cast<binary::LoopRecord *>(
+    &Data[header(Data).loopsOffset]);
+  Loops[0].firstStore = header(Data).numLocations;
+  revng_check(isRejected(Data));
+}
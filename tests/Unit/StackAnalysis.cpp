@@ -5,22 +5,43 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+// Standard includes
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 // Boost includes
 #define BOOST_TEST_MODULE StackAnalysis
 bool init_unit_test();
 #include <boost/test/unit_test.hpp>
 
+// LLVM includes
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
 // Local libraries includes
+#include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
+#include "revng/UnitTestHelpers/LLVMTestHelpers.h"
 #include "revng/UnitTestHelpers/UnitTestHelpers.h"
 
 // Local includes
+#include "Cache.h"
+#include "InterproceduralAnalysis.h"
 #include "Intraprocedural.h"
+#include "SummaryStore.h"
 
 using namespace StackAnalysis;
 
 BOOST_TEST_DONT_PRINT_LOG_VALUE(ASID)
 BOOST_TEST_DONT_PRINT_LOG_VALUE(ASSlot)
 BOOST_TEST_DONT_PRINT_LOG_VALUE(std::vector<ASID>)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(StackAnalysis::Intraprocedural::Value)
+BOOST_TEST_DONT_PRINT_LOG_VALUE(StackAnalysis::Intraprocedural::Element)
 
 const ASID SP0 = ASID::stackID();
 const ASID GLB = ASID::globalID();
@@ -56,3 +77,628 @@ BOOST_AUTO_TEST_CASE(TestASSlot) {
   Map[SP0Slot] = 0;
   BOOST_TEST(Map.count(SP0Slot) != 0U);
 }
+
+using Intraprocedural::Element;
+using Intraprocedural::Value;
+
+static Value slotValue(ASID ID, int32_t Offset) {
+  return Value::fromSlot(ID, Offset);
+}
+
+static Value cpuSlot(int32_t Offset) {
+  return slotValue(CPU, Offset);
+}
+
+static Value cpuTag(int32_t Offset) {
+  return Value::fromTag(ASSlot::create(CPU, Offset));
+}
+
+/// \brief Build an element from scratch, sharing nothing with other elements
+static Element
+build(std::initializer_list<std::pair<int32_t, Value>> Registers) {
+  Element Result = Element::initial();
+  for (auto &P : Registers)
+    Result.store(cpuSlot(P.first), P.second);
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(TestElementCopiesAreIsolated) {
+  Element Original = build({ { 1, slotValue(SP0, -8) },
+                             { 2, slotValue(GLB, 0x1000) } });
+  Element Reference = build({ { 1, slotValue(SP0, -8) },
+                              { 2, slotValue(GLB, 0x1000) } });
+
+  // Overwrite a slot and add a new one in the copy
+  Element Copy = Original.copy();
+  BOOST_TEST(Copy == Original);
+  Copy.store(cpuSlot(1), slotValue(SP0, -16));
+  Copy.store(cpuSlot(3), slotValue(GLB, 0x2000));
+  BOOST_TEST(Copy != Original);
+  BOOST_TEST(Original == Reference);
+  BOOST_TEST(Original.load(cpuSlot(1)) == slotValue(SP0, -8));
+  BOOST_TEST(Copy.load(cpuSlot(1)) == slotValue(SP0, -16));
+  BOOST_TEST(Original.load(cpuSlot(3)) == cpuTag(3));
+
+  // Writing to the original does not affect the copy either
+  Element Other = Original.copy();
+  Original.store(cpuSlot(2), slotValue(GLB, 0x3000));
+  BOOST_TEST(Other == Reference);
+  BOOST_TEST(Other.load(cpuSlot(2)) == slotValue(GLB, 0x1000));
+
+  // Dropping slots from a copy leaves the original alone
+  Element Tagged = build({ { 4, cpuTag(4) } });
+  Element TaggedCopy = Tagged.copy();
+  TaggedCopy.cleanup();
+  ASSlot CalleeSaved = ASSlot::create(CPU, 4);
+  BOOST_TEST(Tagged.computeCalleeSavedSlots().count(CalleeSaved) == 1U);
+  BOOST_TEST(TaggedCopy.computeCalleeSavedSlots().empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestElementSharingDoesNotAffectResults) {
+  auto MakeLeft = []() {
+    return build({ { 1, slotValue(SP0, -8) },
+                   { 2, slotValue(GLB, 0x1000) },
+                   { 5, cpuTag(5) } });
+  };
+  auto MakeRight = []() {
+    return build({ { 1, slotValue(SP0, -8) },
+                   { 2, slotValue(GLB, 0x2000) },
+                   { 3, slotValue(SP0, -4) } });
+  };
+
+  // Compare and combine copies sharing their content with the results on
+  // elements built separately
+  Element Left = MakeLeft();
+  Element Right = MakeRight();
+  Element SharedLeft = Left.copy();
+  Element SharedRight = Right.copy();
+  Element SeparateLeft = MakeLeft();
+  Element SeparateRight = MakeRight();
+
+  BOOST_TEST(SharedLeft.lowerThanOrEqual(Left));
+  BOOST_TEST(SeparateLeft.lowerThanOrEqual(Left));
+  BOOST_TEST(SharedLeft.equal(SeparateLeft));
+  BOOST_TEST(SharedLeft.lowerThanOrEqual(SharedRight)
+             == SeparateLeft.lowerThanOrEqual(SeparateRight));
+  BOOST_TEST(SharedRight.lowerThanOrEqual(SharedLeft)
+             == SeparateRight.lowerThanOrEqual(SeparateLeft));
+
+  Element SharedResult = Left.copy();
+  SharedResult.combine(Right);
+  Element SeparateResult = MakeLeft();
+  SeparateResult.combine(MakeRight());
+  BOOST_TEST(SharedResult == SeparateResult);
+  BOOST_TEST(SharedResult.hash() == SeparateResult.hash());
+
+  // Only the slots where both agree survive
+  BOOST_TEST(SharedResult.load(cpuSlot(1)) == slotValue(SP0, -8));
+  BOOST_TEST(not SharedResult.load(cpuSlot(2)).hasDirectContent());
+  BOOST_TEST(not SharedResult.load(cpuSlot(3)).hasDirectContent());
+  BOOST_TEST(Left.lowerThanOrEqual(SharedResult));
+  BOOST_TEST(Right.lowerThanOrEqual(SharedResult));
+
+  // The combine did not touch its operands
+  BOOST_TEST(Left == MakeLeft());
+  BOOST_TEST(Right == MakeRight());
+
+  // Combining an element with a copy of itself gives the same result as
+  // combining it with an equal element built separately
+  Element SelfShared = Left.copy();
+  SelfShared.combine(Left);
+  Element SelfSeparate = MakeLeft();
+  SelfSeparate.combine(MakeLeft());
+  BOOST_TEST(SelfShared == SelfSeparate);
+  BOOST_TEST(SelfShared == Left);
+}
+
+/// A lifted program: main calls callee twice, leaf once and performs an
+/// indirect call, callee calls leaf
+static const char *LiftedModule = R"LLVM(
+@pc = internal global i64 0
+@rsp = internal global i64 0
+@rax = internal global i64 0
+@rbx = internal global i64 0
+@rdi = internal global i64 0
+
+define internal void @function_call(i8*, i8*, i64, i64*, i8*) {
+  ret void
+}
+
+define void @root(i64) {
+entrypoint:
+  br label %dispatcher.entry
+
+dispatcher.entry:
+  %pc = load i64, i64* @pc
+  switch i64 %pc, label %dispatcher.default [
+    i64 4096, label %bb.main
+    i64 8192, label %bb.callee
+    i64 12288, label %bb.leaf
+  ], !revng.block.type !1
+
+dispatcher.default:
+  unreachable, !revng.block.type !2
+
+anypc:
+  br label %dispatcher.entry, !revng.block.type !3
+
+unexpectedpc:
+  br label %dispatcher.entry, !revng.block.type !4
+
+bb.main:
+  store i64 1, i64* @rdi
+  call void @function_call(i8* blockaddress(@root, %bb.callee),
+                           i8* blockaddress(@root, %bb.main.0x10),
+                           i64 4112,
+                           i64* null,
+                           i8* null)
+  br label %bb.callee
+
+bb.main.0x10:
+  call void @function_call(i8* blockaddress(@root, %bb.callee),
+                           i8* blockaddress(@root, %bb.main.0x20),
+                           i64 4128,
+                           i64* null,
+                           i8* null)
+  br label %bb.callee
+
+bb.main.0x20:
+  call void @function_call(i8* blockaddress(@root, %bb.leaf),
+                           i8* blockaddress(@root, %bb.main.0x30),
+                           i64 4144,
+                           i64* null,
+                           i8* null)
+  br label %bb.leaf
+
+bb.main.0x30:
+  %target = load i64, i64* @rax
+  store i64 %target, i64* @pc
+  call void @function_call(i8* null,
+                           i8* blockaddress(@root, %bb.main.0x40),
+                           i64 4160,
+                           i64* null,
+                           i8* null)
+  br label %anypc
+
+bb.main.0x40:
+  br label %anypc
+
+bb.callee:
+  store i64 2, i64* @rbx
+  call void @function_call(i8* blockaddress(@root, %bb.leaf),
+                           i8* blockaddress(@root, %bb.callee.0x10),
+                           i64 8208,
+                           i64* null,
+                           i8* null)
+  br label %bb.leaf, !revng.jt.reasons !6
+
+bb.callee.0x10:
+  br label %anypc
+
+bb.leaf:
+  store i64 0, i64* @rax
+  br label %anypc, !revng.jt.reasons !6
+}
+
+!revng.input.architecture = !{!0}
+!0 = !{i32 1, i32 0, !"pc", !"rsp", !5}
+!1 = !{!"DispatcherBlock"}
+!2 = !{!"DispatcherFailureBlock"}
+!3 = !{!"AnyPCBlock"}
+!4 = !{!"UnexpectedPCBlock"}
+!5 = !{!"rsp", !"rax", !"rbx", !"rdi"}
+!6 = !{!"Callee"}
+)LLVM";
+
+/// \brief The lifted module along with what the stack analysis needs
+struct LiftedProgram {
+  llvm::LLVMContext Context;
+  std::unique_ptr<llvm::Module> M;
+  llvm::Function *Root;
+  GeneratedCodeBasicInfo GCBI;
+  std::unique_ptr<Cache> TheCache;
+
+  LiftedProgram(const char *Text = LiftedModule) {
+    llvm::SMDiagnostic Diagnostic;
+    auto Buffer = llvm::MemoryBuffer::getMemBuffer(Text);
+    M = llvm::parseIR(Buffer->getMemBufferRef(), Diagnostic, Context);
+    if (M.get() == nullptr) {
+      Diagnostic.print("revng", llvm::dbgs());
+      revng_abort();
+    }
+
+    Root = M->getFunction("root");
+    GCBI.runOnModule(*M);
+    TheCache.reset(new Cache(Root, &GCBI));
+  }
+
+  llvm::BasicBlock *block(const char *Name) {
+    return basicBlockByName(Root, Name);
+  }
+
+  /// \brief The call to function_call in the basic block \p Name
+  llvm::Instruction *call(const char *Name) {
+    for (llvm::Instruction &I : *block(Name))
+      if (isCallTo(&I, "function_call"))
+        return &I;
+    revng_abort();
+  }
+
+  FunctionCall functionCall(const char *Callee, const char *Caller) {
+    return { Callee == nullptr ? nullptr : block(Callee), call(Caller) };
+  }
+};
+
+using IFS = IntraproceduralFunctionSummary;
+
+static IFS createSummary(std::vector<IFS::LocalSlot> LocalSlots,
+                         IFS::CallSiteStackSizeMap FrameSizes,
+                         IFS::BranchesTypeMap BranchesType,
+                         std::set<int32_t> WrittenRegisters) {
+  IFS Result;
+  Result.Type = FunctionType::Regular;
+  Result.LocalSlots = std::move(LocalSlots);
+  Result.FrameSizeAtCallSite = std::move(FrameSizes);
+  Result.BranchesType = std::move(BranchesType);
+  Result.WrittenRegisters = std::move(WrittenRegisters);
+  return Result;
+}
+
+// Indices of the CSVs in the CPU address space
+const int32_t RAX = 3;
+const int32_t RBX = 4;
+const int32_t RDI = 5;
+
+/// \brief Summaries of main, callee and leaf, in this order
+static std::vector<std::pair<llvm::BasicBlock *, IFS>>
+createSummaries(LiftedProgram &P) {
+  using namespace BranchType;
+  using namespace LocalSlotType;
+
+  ASSlot RAXSlot = ASSlot::create(CPU, RAX);
+  ASSlot RBXSlot = ASSlot::create(CPU, RBX);
+  ASSlot RDISlot = ASSlot::create(CPU, RDI);
+
+  std::vector<std::pair<llvm::BasicBlock *, IFS>> Result;
+
+  IFS::CallSiteStackSizeMap MainCalls = {
+    { P.functionCall("bb.callee", "bb.main"), -8 },
+    { P.functionCall("bb.callee", "bb.main.0x10"), -8 },
+    { P.functionCall("bb.leaf", "bb.main.0x20"), -8 },
+    { P.functionCall(nullptr, "bb.main.0x30"), llvm::None }
+  };
+  IFS::BranchesTypeMap MainBranches = {
+    { P.block("bb.main"), HandledCall },
+    { P.block("bb.main.0x10"), HandledCall },
+    { P.block("bb.main.0x20"), HandledCall },
+    { P.block("bb.main.0x30"), IndirectCall },
+    { P.block("bb.main.0x40"), Return }
+  };
+  Result.emplace_back(P.block("bb.main"),
+                      createSummary({ { RDISlot, UsedRegister },
+                                      { RBXSlot,
+                                        ExplicitlyCalleeSavedRegister } },
+                                    MainCalls,
+                                    MainBranches,
+                                    { RBX, RDI }));
+
+  IFS::CallSiteStackSizeMap CalleeCalls = {
+    { P.functionCall("bb.leaf", "bb.callee"), -16 }
+  };
+  IFS::BranchesTypeMap CalleeBranches = {
+    { P.block("bb.callee"), HandledCall },
+    { P.block("bb.callee.0x10"), Return }
+  };
+  Result.emplace_back(P.block("bb.callee"),
+                      createSummary({ { RDISlot, UsedRegister },
+                                      { RAXSlot, ForwardedReturnValue },
+                                      { RBXSlot,
+                                        ExplicitlyCalleeSavedRegister } },
+                                    CalleeCalls,
+                                    CalleeBranches,
+                                    { RAX, RBX }));
+
+  Result.emplace_back(P.block("bb.leaf"),
+                      createSummary({ { RAXSlot, UsedRegister } },
+                                    {},
+                                    { { P.block("bb.leaf"), Return } },
+                                    { RAX }));
+
+  return Result;
+}
+
+static std::string nameOf(const llvm::Value *V) {
+  return V == nullptr ? std::string("null") : V->getName().str();
+}
+
+/// \brief Describe \p Summary one fact per line, sorted so that the result
+///        does not depend on the order of the call sites
+static std::string describe(const FunctionsSummary &Summary) {
+  std::vector<std::string> Lines;
+  for (auto &P : Summary.Functions) {
+    std::string Function = nameOf(P.first);
+    const FunctionsSummary::FunctionDescription &Description = P.second;
+
+    Lines.push_back(Function + " " + FunctionType::getName(Description.Type));
+
+    for (auto &Q : Description.BasicBlocks)
+      Lines.push_back(Function + " " + nameOf(Q.first) + " "
+                      + BranchType::getName(Q.second));
+
+    for (llvm::GlobalVariable *CSV : Description.ClobberedRegisters)
+      Lines.push_back(Function + " clobbers " + nameOf(CSV));
+
+    for (auto &Q : Description.RegisterSlots)
+      Lines.push_back(Function + " " + nameOf(Q.first) + " "
+                      + Q.second.Argument.valueName() + " "
+                      + Q.second.ReturnValue.valueName());
+
+    for (const FunctionsSummary::CallSiteDescription &Call :
+         Description.CallSites) {
+      std::string Prefix = (Function + " " + nameOf(Call.Call->getParent())
+                            + " -> " + nameOf(Call.Callee));
+      Lines.push_back(Prefix);
+      for (auto &Q : Call.RegisterSlots)
+        Lines.push_back(Prefix + " " + nameOf(Q.first) + " "
+                        + Q.second.Argument.valueName() + " "
+                        + Q.second.ReturnValue.valueName());
+    }
+  }
+
+  std::sort(Lines.begin(), Lines.end());
+
+  std::string Result;
+  for (const std::string &Line : Lines)
+    Result += Line + "\n";
+  return Result;
+}
+
+static FunctionsSummary finalize(LiftedProgram &P, bool Reverse) {
+  auto Summaries = createSummaries(P);
+  if (Reverse)
+    std::reverse(Summaries.begin(), Summaries.end());
+
+  ResultsPool Results;
+  for (auto &S : Summaries)
+    Results.registerFunction(S.first, FunctionType::Regular, &S.second);
+
+  return Results.finalize(P.M.get(), P.TheCache.get());
+}
+
+BOOST_AUTO_TEST_CASE(TestResultsPoolFinalize) {
+  LiftedProgram P;
+
+  // The results produced by the ResultsPool based on std::map
+  const char *Expected =
+    "bb.callee Regular\n"
+    "bb.callee bb.callee -> bb.leaf\n"
+    "bb.callee bb.callee -> bb.leaf rax Maybe Maybe\n"
+    "bb.callee bb.callee -> bb.leaf rbx Maybe Maybe\n"
+    "bb.callee bb.callee -> bb.leaf rdi Maybe Maybe\n"
+    "bb.callee bb.callee HandledCall\n"
+    "bb.callee bb.callee.0x10 Return\n"
+    "bb.callee clobbers rax\n"
+    "bb.callee rax Maybe Maybe\n"
+    "bb.callee rbx No No\n"
+    "bb.callee rdi Maybe Maybe\n"
+    "bb.leaf Regular\n"
+    "bb.leaf bb.leaf Return\n"
+    "bb.leaf clobbers rax\n"
+    "bb.leaf rax Maybe Maybe\n"
+    "bb.leaf rbx Maybe Maybe\n"
+    "bb.leaf rdi Maybe Maybe\n"
+    "bb.main Regular\n"
+    "bb.main bb.main -> bb.callee\n"
+    "bb.main bb.main -> bb.callee rax Maybe Maybe\n"
+    "bb.main bb.main -> bb.callee rbx No No\n"
+    "bb.main bb.main -> bb.callee rdi Maybe Maybe\n"
+    "bb.main bb.main HandledCall\n"
+    "bb.main bb.main.0x10 -> bb.callee\n"
+    "bb.main bb.main.0x10 -> bb.callee rax Maybe Maybe\n"
+    "bb.main bb.main.0x10 -> bb.callee rbx No No\n"
+    "bb.main bb.main.0x10 -> bb.callee rdi Maybe Maybe\n"
+    "bb.main bb.main.0x10 HandledCall\n"
+    "bb.main bb.main.0x20 -> bb.leaf\n"
+    "bb.main bb.main.0x20 -> bb.leaf rax Maybe Maybe\n"
+    "bb.main bb.main.0x20 -> bb.leaf rbx Maybe Maybe\n"
+    "bb.main bb.main.0x20 -> bb.leaf rdi Maybe Maybe\n"
+    "bb.main bb.main.0x20 HandledCall\n"
+    "bb.main bb.main.0x30 -> null\n"
+    "bb.main bb.main.0x30 -> null rbx Maybe Maybe\n"
+    "bb.main bb.main.0x30 -> null rdi Maybe Maybe\n"
+    "bb.main bb.main.0x30 IndirectCall\n"
+    "bb.main bb.main.0x40 Return\n"
+    "bb.main clobbers rax\n"
+    "bb.main clobbers rdi\n"
+    "bb.main rbx No No\n"
+    "bb.main rdi Maybe Maybe\n"
+    "null Invalid\n"
+    "null clobbers rax\n"
+    "null clobbers rdi\n";
+
+  std::string Result = describe(finalize(P, false));
+  BOOST_TEST(Result == Expected);
+
+  // The order in which the functions are registered does not matter
+  BOOST_TEST(describe(finalize(P, true)) == Result);
+}
+
+/// \brief A SummaryStore on a temporary directory, removed on destruction
+struct TemporaryStore {
+  llvm::SmallString<128> Directory;
+  std::unique_ptr<SummaryStore> Store;
+
+  TemporaryStore() {
+    std::error_code Error;
+    Error = llvm::sys::fs::createUniqueDirectory("summary-store", Directory);
+    revng_check(!Error);
+  }
+
+  ~TemporaryStore() { llvm::sys::fs::remove_directories(Directory); }
+
+  SummaryStore &open(LiftedProgram &P) {
+    Store.reset(new SummaryStore(Directory,
+                                 P.Root,
+                                 &P.GCBI,
+                                 *P.TheCache,
+                                 true));
+    return *Store;
+  }
+
+  std::string path(llvm::BasicBlock *Entry) {
+    llvm::SmallString<128> Result(Directory);
+    llvm::sys::path::append(Result, Store->getKey(Entry) + ".summary");
+    return Result.str().str();
+  }
+
+  std::string read(llvm::BasicBlock *Entry) {
+    auto Buffer = llvm::MemoryBuffer::getFile(path(Entry));
+    revng_check(Buffer);
+    return (*Buffer)->getBuffer().str();
+  }
+
+  void write(llvm::BasicBlock *Entry, llvm::StringRef Data) {
+    std::error_code Error;
+    llvm::raw_fd_ostream Stream(path(Entry), Error, llvm::sys::fs::OF_None);
+    revng_check(!Error);
+    Stream << Data;
+  }
+};
+
+BOOST_AUTO_TEST_CASE(TestSummaryStoreRoundTrip) {
+  LiftedProgram P;
+  TemporaryStore Temporary;
+  SummaryStore &Store = Temporary.open(P);
+
+  llvm::BasicBlock *Main = P.block("bb.main");
+  llvm::BasicBlock *Callee = P.block("bb.callee");
+  llvm::BasicBlock *Leaf = P.block("bb.leaf");
+
+  BOOST_TEST(not Store.load(Main).hasValue());
+
+  auto Summaries = createSummaries(P);
+  IFS &Original = Summaries[0].second;
+  Original.FinalState = build({ { RBX, cpuTag(RBX) },
+                                { RDI, slotValue(SP0, -8) } });
+  Store.store(Main, FunctionType::Regular, &Original);
+  Store.store(Callee, FunctionType::Fake, nullptr);
+
+  llvm::Optional<SummaryStore::StoredFunction> Loaded = Store.load(Main);
+  BOOST_TEST(Loaded.hasValue());
+  BOOST_TEST(Loaded->Type == FunctionType::Regular);
+  BOOST_TEST(Loaded->Summary.hasValue());
+
+  const IFS &Summary = *Loaded->Summary;
+  BOOST_TEST(Summary.Type == Original.Type);
+  BOOST_TEST(Summary.FinalState == Original.FinalState);
+  BOOST_TEST(Summary.LocalSlots == Original.LocalSlots);
+  BOOST_TEST(Summary.FrameSizeAtCallSite == Original.FrameSizeAtCallSite);
+  BOOST_TEST(Summary.BranchesType == Original.BranchesType);
+  BOOST_TEST(Summary.WrittenRegisters == Original.WrittenRegisters);
+
+  // Functions without a summary
+  Loaded = Store.load(Callee);
+  BOOST_TEST(Loaded.hasValue());
+  BOOST_TEST(Loaded->Type == FunctionType::Fake);
+  BOOST_TEST(not Loaded->Summary.hasValue());
+
+  BOOST_TEST(not Store.load(Leaf).hasValue());
+
+  // The entries survive the store
+  SummaryStore &Reopened = Temporary.open(P);
+  BOOST_TEST(Reopened.load(Main).hasValue());
+  BOOST_TEST(Reopened.load(Callee).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(TestSummaryStoreMalformedInput) {
+  LiftedProgram P;
+  TemporaryStore Temporary;
+  SummaryStore &Store = Temporary.open(P);
+
+  llvm::BasicBlock *Main = P.block("bb.main");
+  auto Summaries = createSummaries(P);
+  Store.store(Main, FunctionType::Regular, &Summaries[0].second);
+  const std::string Valid = Temporary.read(Main);
+  BOOST_TEST(Store.load(Main).hasValue());
+
+  // Every truncation is rejected
+  for (size_t Size = 0; Size < Valid.size(); Size++) {
+    Temporary.write(Main, llvm::StringRef(Valid).take_front(Size));
+    BOOST_TEST(not Store.load(Main).hasValue());
+  }
+
+  // Trailing data
+  Temporary.write(Main, Valid + "X");
+  BOOST_TEST(not Store.load(Main).hasValue());
+
+  // Wrong magic
+  std::string Data = Valid;
+  Data[0] = 'X';
+  Temporary.write(Main, Data);
+  BOOST_TEST(not Store.load(Main).hasValue());
+
+  // Wrong version
+  Data = Valid;
+  Data[4]++;
+  Temporary.write(Main, Data);
+  BOOST_TEST(not Store.load(Main).hasValue());
+
+  // Reference to a basic block that does not exist
+  Data = Valid;
+  size_t Position = Data.find("bb.callee");
+  revng_check(Position != std::string::npos);
+  Data.replace(Position, 9, "bb.absent");
+  Temporary.write(Main, Data);
+  BOOST_TEST(not Store.load(Main).hasValue());
+
+  // A damaged entry is overwritten by the next store
+  Store.store(Main, FunctionType::Regular, &Summaries[0].second);
+  BOOST_TEST(Temporary.read(Main) == Valid);
+  BOOST_TEST(Store.load(Main).hasValue());
+}
+
+BOOST_AUTO_TEST_CASE(TestSummaryStoreKeys) {
+  LiftedProgram P;
+  TemporaryStore Temporary;
+  SummaryStore &Store = Temporary.open(P);
+
+  const char *Functions[] = { "bb.main", "bb.callee", "bb.leaf" };
+  std::vector<std::string> Keys;
+  for (const char *Name : Functions) {
+    Keys.push_back(Store.getKey(P.block(Name)));
+    Store.store(P.block(Name), FunctionType::Fake, nullptr);
+  }
+
+  // Keys are stable and distinct
+  BOOST_TEST(Keys[0] != Keys[1]);
+  BOOST_TEST(Keys[1] != Keys[2]);
+  BOOST_TEST(Keys[0] != Keys[2]);
+  {
+    LiftedProgram Same;
+    SummaryStore &SameStore = Temporary.open(Same);
+    for (unsigned I = 0; I < 3; I++) {
+      BOOST_TEST(SameStore.getKey(Same.block(Functions[I])) == Keys[I]);
+      BOOST_TEST(SameStore.load(Same.block(Functions[I])).hasValue());
+    }
+  }
+
+  // Change the body of callee: its key and the key of main, which calls it,
+  // change, leaf is not affected
+  std::string Text = LiftedModule;
+  size_t Position = Text.find("store i64 2, i64* @rbx");
+  revng_check(Position != std::string::npos);
+  Text.replace(Position, 11, "store i64 3");
+
+  LiftedProgram Changed(Text.c_str());
+  SummaryStore &ChangedStore = Temporary.open(Changed);
+  llvm::BasicBlock *Main = Changed.block("bb.main");
+  llvm::BasicBlock *Callee = Changed.block("bb.callee");
+  llvm::BasicBlock *Leaf = Changed.block("bb.leaf");
+
+  BOOST_TEST(ChangedStore.getKey(Main) != Keys[0]);
+  BOOST_TEST(ChangedStore.getKey(Callee) != Keys[1]);
+  BOOST_TEST(ChangedStore.getKey(Leaf) == Keys[2]);
+  BOOST_TEST(not ChangedStore.load(Main).hasValue());
+  BOOST_TEST(not ChangedStore.load(Callee).hasValue());
+  BOOST_TEST(ChangedStore.load(Leaf).hasValue());
+}
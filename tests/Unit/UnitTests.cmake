@@ -131,3 +131,35 @@ target_link_libraries(test_shrinkinstructionoperands
   ${LLVM_LIBRARIES})
 add_test(NAME test_shrinkinstructionoperands COMMAND test_shrinkinstructionoperands)
 set_tests_properties(test_shrinkinstructionoperands PROPERTIES LABELS "unit")
+
+#
+# test_securityresults
+#
+
+add_executable(test_securityresults "${SRC}/SecurityResults.cpp")
+target_include_directories(test_securityresults
+  PRIVATE "${CMAKE_SOURCE_DIR}")
+target_link_libraries(test_securityresults
+  revngSecurityPass
+  revngSecurityResults
+  revngSupport
+  revngUnitTestHelpers
+  Boost::unit_test_framework
+  ${LLVM_LIBRARIES})
+add_test(NAME test_securityresults COMMAND test_securityresults)
+set_tests_properties(test_securityresults PROPERTIES LABELS "unit")
+
+#
+# test_monotoneframework
+#
+
+add_executable(test_monotoneframework "${SRC}/MonotoneFramework.cpp")
+target_include_directories(test_monotoneframework
+  PRIVATE "${CMAKE_SOURCE_DIR}")
+target_link_libraries(test_monotoneframework
+  revngSupport
+  revngUnitTestHelpers
+  Boost::unit_test_framework
+  ${LLVM_LIBRARIES})
+add_test(NAME test_monotoneframework COMMAND test_monotoneframework)
+set_tests_properties(test_monotoneframework PROPERTIES LABELS "unit")